@@ -0,0 +1,217 @@
+#include "../include/Acceptor.h"
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 连接风暴：一个Acceptor每秒能accept多少连接
+ * 用法: bench_accept [seconds] [clientThreads] [burst]
+ * 客户端都在fork出的子进程里，服务端accept后直接close。分两项：
+ * - burst: loop暂停时先积压burst个已完成握手的连接，测loop取完它们的时间
+ * - storm: clientThreads个线程不停地connect后立即RST关闭，持续seconds秒，
+ *   统计统计每秒accept数、每次epoll唤醒accept的连接数、
+ * loop线程的CPU占用和每个连接花费的CPU时间。单核机器上客户端与服务端抢CPU，
+ * accepts/s受客户端限制，us/conn更能反映acceptor本身的开销
+ * mode:
+ * - lt/1:     水平触发，每次可读只accept一个（改动之前的行为）
+ * - lt/16:    水平触发，每次最多16个
+ * - lt/64:    水平触发，每次最多64个（默认）
+ * - et/64:    边缘触发，每次最多64个，剩下的排到下一轮
+ * - emfile:   lt/64，服务端fd已经用完，所有连接都由预留fd接受后关闭
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static const uint16_t kPort = 19200;
+
+struct Mode {
+    const char *name;
+    bool edgeTriggered;
+    int maxAccepts;
+    bool exhaustFds;
+};
+
+static const Mode kModes[] = {
+    {"lt/1", false, 1, false},
+    {"lt/16", false, 16, false},
+    {"lt/64", false, 64, false},
+    {"et/64", true, 64, false},
+    {"emfile", false, 64, true},
+};
+
+static void runClients(int threads) {
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&addr]() {
+            // 父进程kill之前一直跑
+            for (;;) {
+                int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                if (fd < 0) {
+                    usleep(1000);
+                    continue;
+                }
+                if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) !=
+                    0) {
+                    ::close(fd);
+                    usleep(1000);
+                    continue;
+                }
+                // RST关闭，客户端不留TIME_WAIT，端口不会耗尽
+                struct linger lg {1, 0};
+                ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+                ::close(fd);
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+}
+
+// 子进程建立n个连接后通知父进程，然后保持连接直到被kill
+static pid_t startBurst(size_t n) {
+    int pipefd[2];
+    if (::pipe(pipefd) != 0) {
+        return -1;
+    }
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        ::close(pipefd[0]);
+        struct sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kPort);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        std::vector<int> fds;
+        for (size_t i = 0; i < n; ++i) {
+            int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+                break;
+            }
+            fds.push_back(fd);
+        }
+        char done = 'x';
+        (void)::write(pipefd[1], &done, 1);
+        pause();
+        _exit(0);
+    }
+    ::close(pipefd[1]);
+    char done;
+    (void)::read(pipefd[0], &done, 1);
+    ::close(pipefd[0]);
+    return child;
+}
+
+static double threadCpuSeconds() {
+    struct rusage ru;
+    getrusage(RUSAGE_THREAD, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+           (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 3;
+    int clientThreads = argc > 2 ? atoi(argv[2]) : 4;
+    size_t burst = argc > 3 ? static_cast<size_t>(atol(argv[3])) : 4000;
+
+    Logger::setLogLevel(ERROR);
+
+    printf("seconds=%d clientThreads=%d burst=%zu\n", seconds, clientThreads,
+           burst);
+    printf("%-8s %10s %14s %12s %12s %14s %10s %10s\n", "mode", "burst us",
+           "burst us/conn", "accepts/s", "dropped/s", "accepts/wakeup",
+           "loop cpu", "us/conn");
+    for (const Mode &mode : kModes) {
+        EventLoop loop;
+        Acceptor acceptor(&loop, InetAddress(kPort, true));
+        acceptor.setEdgeTriggered(mode.edgeTriggered);
+        acceptor.setMaxAcceptsPerWakeup(mode.maxAccepts);
+        acceptor.listen();
+
+        // burst：积压的连接全部交给回调后退出
+        double burstUs = 0;
+        if (!mode.exhaustFds) {
+            pid_t holder = startBurst(burst);
+            auto start = BenchClock::now();
+            acceptor.setNewConnectionCallback(
+                [&](int sockfd, const InetAddress &) {
+                    ::close(sockfd);
+                    if (acceptor.acceptedCount() == burst) {
+                        burstUs = std::chrono::duration<double, std::micro>(
+                                      BenchClock::now() - start)
+                                      .count();
+                        loop.quit();
+                    }
+                });
+            loop.loop();
+            ::kill(holder, SIGKILL);
+            waitpid(holder, nullptr, 0);
+            acceptor.setNewConnectionCallback(
+                [](int sockfd, const InetAddress &) { ::close(sockfd); });
+        }
+        uint64_t burstAccepted = acceptor.acceptedCount();
+
+        fflush(stdout);
+        pid_t child = fork();
+        if (child == 0) {
+            runClients(clientThreads);
+            _exit(0);
+        }
+
+        // 用dup把fd占满，之后accept全部EMFILE
+        struct rlimit saved;
+        getrlimit(RLIMIT_NOFILE, &saved);
+        std::vector<int> fillers;
+        if (mode.exhaustFds) {
+            struct rlimit limited = saved;
+            limited.rlim_cur = 1024;
+            setrlimit(RLIMIT_NOFILE, &limited);
+            for (int fd; (fd = ::dup(0)) >= 0;) {
+                fillers.push_back(fd);
+            }
+        }
+
+        uint64_t wakeups = loop.pollerWakeups();
+        double cpu = threadCpuSeconds();
+        loop.runAfter(seconds, [&]() { loop.quit(); });
+        loop.loop();
+        cpu = threadCpuSeconds() - cpu;
+        wakeups = loop.pollerWakeups() - wakeups;
+
+        ::kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+        for (int fd : fillers) {
+            ::close(fd);
+        }
+        setrlimit(RLIMIT_NOFILE, &saved);
+
+        uint64_t accepted = acceptor.acceptedCount() - burstAccepted;
+        uint64_t handled = accepted + acceptor.droppedCount();
+        printf("%-8s %10.0f %14.2f %12.0f %12.0f %14.2f %9.0f%% %10.2f\n",
+               mode.name, burstUs, burstUs / burst,
+               static_cast<double>(accepted) / seconds,
+               static_cast<double>(acceptor.droppedCount()) / seconds,
+               wakeups == 0 ? 0.0 : static_cast<double>(handled) / wakeups,
+               cpu / seconds * 100,
+               handled == 0 ? 0.0 : cpu * 1e6 / handled);
+    }
+    printf("(accepts/wakeup: accepted + dropped connections per epoll_wait "
+           "return, timers included)\n");
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "../include/Buffer.h"
+#include "../include/BufferPool.h"
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpConnection.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 空闲连接的缓冲区内存
+ * 用法: bench_buffermem [connections]
+ * 1. 每个"连接"两个Buffer，各处理过一条消息后空闲：
+ *    独立Buffer（预分配1KB） vs 池化Buffer（懒分配，读空归还）
+ * 2. 真实TcpConnection（socketpair），回显一条消息后空闲，受fd上限限制
+ * 以malloc占用的增量除以连接数报告，不含内核socket缓冲区
+ */
+
+// malloc中仍被占用的字节数；RSS会因为释放后的页被复用而失真
+static long heapInUse() {
+    struct mallinfo2 mi = mallinfo2();
+    return static_cast<long>(mi.uordblks + mi.hblkhd);
+}
+
+static void buffersOnly(size_t n) {
+    std::string msg(200, 'm');
+
+    long before = heapInUse();
+    {
+        std::vector<Buffer> buffers;
+        buffers.reserve(2 * n);
+        for (size_t i = 0; i < 2 * n; ++i) {
+            buffers.emplace_back();
+            buffers.back().append(msg);
+            buffers.back().retrieveAll();
+        }
+        long after = heapInUse();
+        printf("  unpooled Buffer x2 : %6.0f bytes/connection\n",
+               static_cast<double>(after - before) / n);
+    }
+
+    BufferPool pool;
+    before = heapInUse();
+    {
+        std::vector<Buffer> buffers;
+        buffers.reserve(2 * n);
+        for (size_t i = 0; i < 2 * n; ++i) {
+            buffers.emplace_back(&pool);
+            buffers.back().append(msg);
+            buffers.back().retrieveAll();
+        }
+        long after = heapInUse();
+        printf("  pooled Buffer x2   : %6.0f bytes/connection "
+               "(pool in use %zu, cached %zu)\n",
+               static_cast<double>(after - before) / n, pool.inUseBytes(),
+               pool.cachedBytes());
+    }
+}
+
+static void connections(size_t n) {
+    EventLoop loop;
+    std::string msg(200, 'm');
+
+    std::vector<int> peers;
+    std::vector<TcpConnection::TcpConnectionPtr> conns;
+    peers.reserve(n);
+    conns.reserve(n);
+
+    long before = heapInUse();
+    for (size_t i = 0; i < n; ++i) {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+            break;
+        }
+        Socket sock(fds[0]);
+        sock.setNonBlocking();
+        auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+        conn->setMessageCallback(
+            [](const TcpConnection::TcpConnectionPtr &c, Buffer *buf) {
+                c->send(buf->retrieveAllAsString());
+            });
+        conn->connectEstablished();
+        conns.push_back(conn);
+        peers.push_back(fds[1]);
+
+        ssize_t w = ::write(fds[1], msg.data(), msg.size());
+        (void)w;
+    }
+
+    // 跑到所有回显都写出
+    size_t echoed = 0;
+    std::vector<char> buf(msg.size());
+    std::function<void()> drain = [&]() {
+        for (; echoed < peers.size(); ++echoed) {
+            if (::recv(peers[echoed], buf.data(), buf.size(), MSG_DONTWAIT) <
+                0) {
+                loop.queueInLoop(drain);
+                return;
+            }
+        }
+        loop.quit();
+    };
+    loop.runAfter(0.001, drain);
+    loop.loop();
+
+    long after = heapInUse();
+    printf("  TcpConnection      : %6.0f bytes/connection over %zu "
+           "connections (pool in use %zu)\n",
+           static_cast<double>(after - before) / conns.size(), conns.size(),
+           loop.bufferPool()->inUseBytes());
+
+    for (auto &conn : conns) {
+        conn->connectDestroyed();
+    }
+    for (int fd : peers) {
+        ::close(fd);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 100000;
+
+    Logger::setLogLevel(ERROR);
+
+    printf("%zu idle connections\n", n);
+    buffersOnly(n);
+
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    size_t maxConns = rl.rlim_cur > 128 ? (rl.rlim_cur - 128) / 2 : 0;
+    connections(std::min(n, maxConns));
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "../include/Buffer.h"
+#include "../include/ChainBuffer.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * Buffer 与 ChainBuffer 对比
+ * 用法: bench_chainbuffer [totalMB]
+ * 1. 纯内存：反复 append 小/大消息再全部 retrieve
+ * 2. 输出路径：一次append一个大响应，writeFd写到socketpair，对端线程读走
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static double secondsSince(BenchClock::time_point start) {
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+template <typename B>
+static double appendRetrieve(size_t msgSize, size_t total, size_t batch) {
+    std::string msg(msgSize, 'x');
+    B buf;
+    auto start = BenchClock::now();
+    for (size_t done = 0; done < total;) {
+        for (size_t i = 0; i < batch; ++i) {
+            buf.append(msg);
+        }
+        done += msgSize * batch;
+        buf.retrieveAll();
+    }
+    return total / secondsSince(start) / 1e6;
+}
+
+template <typename B>
+static double writeOut(size_t responseSize, size_t total) {
+    // 按整数个响应发送；非阻塞socket，EAGAIN时poll等待可写，与loop中一致
+    total = std::max<size_t>(1, total / responseSize) * responseSize;
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    ::fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    std::thread reader([&]() {
+        char buf[65536];
+        size_t got = 0;
+        while (got < total) {
+            ssize_t n = ::read(fds[1], buf, sizeof buf);
+            if (n <= 0) {
+                break;
+            }
+            got += n;
+        }
+    });
+
+    // 模拟响应按8KB分片生成
+    std::string piece(8192, 'y');
+    B buf;
+    size_t syscalls = 0;
+    auto start = BenchClock::now();
+    for (size_t sent = 0; sent < total; sent += responseSize) {
+        for (size_t n = 0; n < responseSize; n += piece.size()) {
+            buf.append(piece);
+        }
+        while (buf.readableBytes() > 0) {
+            int savedErrno = 0;
+            ++syscalls;
+            if (buf.writeFd(fds[0], &savedErrno) < 0) {
+                if (savedErrno != EAGAIN) {
+                    break;
+                }
+                struct pollfd pfd = {fds[0], POLLOUT, 0};
+                ::poll(&pfd, 1, -1);
+            }
+        }
+    }
+    reader.join();
+    double mbps = total / secondsSince(start) / 1e6;
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    printf("    %.0f writes per response, ",
+           static_cast<double>(syscalls) * responseSize / total);
+    return mbps;
+}
+
+int main(int argc, char *argv[]) {
+    size_t totalMB = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 512;
+    size_t total = totalMB * 1024 * 1024;
+
+    printf("append+retrieve (MB/s)      Buffer   ChainBuffer\n");
+    printf("  64B x 64             %10.0f %12.0f\n",
+           appendRetrieve<Buffer>(64, total, 64),
+           appendRetrieve<ChainBuffer>(64, total, 64));
+    printf("  4KB x 16             %10.0f %12.0f\n",
+           appendRetrieve<Buffer>(4096, total, 16),
+           appendRetrieve<ChainBuffer>(4096, total, 16));
+    printf("  1MB x 50             %10.0f %12.0f\n",
+           appendRetrieve<Buffer>(1024 * 1024, total, 50),
+           appendRetrieve<ChainBuffer>(1024 * 1024, total, 50));
+
+    printf("append 50MB response + writeFd to socketpair\n");
+    printf("  Buffer     :");
+    double b = writeOut<Buffer>(50 * 1024 * 1024, total);
+    printf("%.0f MB/s\n", b);
+    printf("  ChainBuffer:");
+    double c = writeOut<ChainBuffer>(50 * 1024 * 1024, total);
+    printf("%.0f MB/s\n", c);
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/SlotMap.h"
+#include "../include/TcpServer.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 连接表在建连/断连频繁时的开销
+ * 用法: bench_churn [liveConnections] [churnOps] [seconds]
+ * 1. 连接表本身：表里保持liveConnections个连接，每次随机删掉一个再加入一个新的，
+ *    然后按键查找一个随机连接
+ *    - map:     旧实现，std::map<std::string, TcpConnectionPtr>，键是"ip:port#n"
+ *    - slotmap: SlotMap<TcpConnectionPtr>，键是带代数的64位id
+ * 2. TcpServer端到端：客户端线程不停地connect后立即RST关闭，统计每秒建立并移除的连接数
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static const uint16_t kPort = 19220;
+
+struct Result {
+    double churnNs;
+    double lookupNs;
+};
+
+// 表里存的值，和真实连接表一样是shared_ptr
+using Value = std::shared_ptr<int>;
+
+static Result churnMap(size_t live, size_t ops) {
+    std::map<std::string, Value> table;
+    std::vector<std::string> names;
+    size_t nextId = 1;
+    auto makeName = [&nextId]() {
+        return "127.0.0.1:19220#" + std::to_string(nextId++);
+    };
+    for (size_t i = 0; i < live; ++i) {
+        names.push_back(makeName());
+        table[names.back()] = std::make_shared<int>(0);
+    }
+
+    std::mt19937_64 rng(1);
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        size_t victim = rng() % live;
+        table.erase(names[victim]);
+        names[victim] = makeName();
+        table[names[victim]] = std::make_shared<int>(0);
+    }
+    auto mid = BenchClock::now();
+    size_t hits = 0;
+    for (size_t i = 0; i < ops; ++i) {
+        auto it = table.find(names[rng() % live]);
+        hits += it != table.end() ? 1 : 0;
+    }
+    auto end = BenchClock::now();
+    if (hits != ops) {
+        fprintf(stderr, "map lookup missed\n");
+    }
+    return {std::chrono::duration<double, std::nano>(mid - start).count() / ops,
+            std::chrono::duration<double, std::nano>(end - mid).count() / ops};
+}
+
+static Result churnSlotMap(size_t live, size_t ops) {
+    SlotMap<Value> table;
+    std::vector<SlotMap<Value>::Key> keys;
+    for (size_t i = 0; i < live; ++i) {
+        keys.push_back(table.insert(std::make_shared<int>(0)));
+    }
+
+    std::mt19937_64 rng(1);
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < ops; ++i) {
+        size_t victim = rng() % live;
+        table.erase(keys[victim]);
+        keys[victim] = table.insert(std::make_shared<int>(0));
+    }
+    auto mid = BenchClock::now();
+    size_t hits = 0;
+    for (size_t i = 0; i < ops; ++i) {
+        hits += table.find(keys[rng() % live]) != nullptr ? 1 : 0;
+    }
+    auto end = BenchClock::now();
+    if (hits != ops) {
+        fprintf(stderr, "slotmap lookup missed\n");
+    }
+    return {std::chrono::duration<double, std::nano>(mid - start).count() / ops,
+            std::chrono::duration<double, std::nano>(end - mid).count() / ops};
+}
+
+static void runClient(BenchClock::time_point deadline, uint64_t *count) {
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    while (BenchClock::now() < deadline) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            ++*count;
+        }
+        // RST关闭，客户端不留TIME_WAIT，端口不会耗尽
+        struct linger lg {1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        ::close(fd);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t live = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 100000;
+    size_t ops = argc > 2 ? static_cast<size_t>(atol(argv[2])) : 1000000;
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+
+    Logger::setLogLevel(ERROR);
+
+    printf("live=%zu ops=%zu\n", live, ops);
+    printf("%-8s %14s %14s\n", "table", "churn ns/op", "lookup ns/op");
+    Result m = churnMap(live, ops);
+    printf("%-8s %14.1f %14.1f\n", "map", m.churnNs, m.lookupNs);
+    Result s = churnSlotMap(live, ops);
+    printf("%-8s %14.1f %14.1f\n", "slotmap", s.churnNs, s.lookupNs);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort, true));
+    uint64_t established = 0;
+    uint64_t removed = 0;
+    server.setConnectionCallback(
+        [&](const TcpServer::TcpConnectionPtr &conn) {
+            ++(conn->connected() ? established : removed);
+        });
+    server.start();
+
+    auto deadline = BenchClock::now() + std::chrono::seconds(seconds);
+    const int kClients = 2;
+    std::vector<uint64_t> counts(kClients, 0);
+    std::vector<std::thread> clients;
+    for (int i = 0; i < kClients; ++i) {
+        clients.emplace_back(runClient, deadline, &counts[i]);
+    }
+    std::thread waiter([&]() {
+        for (auto &t : clients) {
+            t.join();
+        }
+        loop.queueInLoop([&]() { loop.quit(); });
+    });
+    loop.loop();
+    waiter.join();
+
+    printf("server churn: %.0f conns/s established, %.0f/s removed "
+           "(%d client threads, %d s)\n",
+           static_cast<double>(established) / seconds,
+           static_cast<double>(removed) / seconds, kClients, seconds);
+    return 0;
+}
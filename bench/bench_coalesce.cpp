@@ -0,0 +1,233 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <linux/tcp.h>
+#include <string>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 写合并：流水线小消息的系统调用次数与吞吐
+ * 用法: bench_coalesce [requests] [pipelineDepth]
+ * 客户端连续发固定16字节的请求，最多depth个在途；服务端每个请求分三次send回复
+ * （头、体、尾），响应体为mem时是内存，为file时头和尾之间用sendFile发一个小文件
+ * 服务端连接都设置TCP_NODELAY，否则直接写的后两次send会被Nagle算法拖住
+ * 统计loop线程中的write/writev/sendmsg/sendfile次数，以及客户端收到的数据报文段数
+ * mode:
+ * - immediate:  默认，每次send直接写
+ * - coalesce:   setWriteCoalescing(true)，迭代末尾一次writev
+ * - coalesce+more: 再加MSG_MORE，文件前的头部不单独成段
+ */
+
+static const uint16_t kPort = 19170;
+static const size_t kRequestSize = 16;
+static const size_t kBodySize = 1024;
+
+// 替换libc的写函数，只统计loop线程
+static thread_local bool t_countWrites = false;
+static std::atomic<uint64_t> g_writes(0);
+
+template <typename F> static F nextSymbol(const char *name) {
+    return reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+}
+
+extern "C" {
+
+ssize_t write(int fd, const void *buf, size_t count) {
+    static auto real = nextSymbol<ssize_t (*)(int, const void *, size_t)>("write");
+    if (t_countWrites) {
+        g_writes.fetch_add(1, std::memory_order_relaxed);
+    }
+    return real(fd, buf, count);
+}
+
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt) {
+    static auto real =
+        nextSymbol<ssize_t (*)(int, const struct iovec *, int)>("writev");
+    if (t_countWrites) {
+        g_writes.fetch_add(1, std::memory_order_relaxed);
+    }
+    return real(fd, iov, iovcnt);
+}
+
+ssize_t sendmsg(int fd, const struct msghdr *msg, int flags) {
+    static auto real =
+        nextSymbol<ssize_t (*)(int, const struct msghdr *, int)>("sendmsg");
+    if (t_countWrites) {
+        g_writes.fetch_add(1, std::memory_order_relaxed);
+    }
+    return real(fd, msg, flags);
+}
+
+ssize_t sendfile(int outFd, int inFd, off_t *offset, size_t count) {
+    static auto real =
+        nextSymbol<ssize_t (*)(int, int, off_t *, size_t)>("sendfile");
+    if (t_countWrites) {
+        g_writes.fetch_add(1, std::memory_order_relaxed);
+    }
+    return real(outFd, inFd, offset, count);
+}
+
+} // extern "C"
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 200; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    return -1;
+}
+
+enum Mode { kImmediate, kCoalesce, kCoalesceMore };
+static const char *kModeNames[] = {"immediate", "coalesce", "coalesce+more"};
+
+struct Result {
+    double rate;
+    uint64_t dataSegs;
+};
+
+// 客户端：写线程按窗口发请求，主线程读回响应
+static Result run(EventLoop &loop, size_t requests, size_t depth,
+                  size_t responseSize) {
+    Result result{0, 0};
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread client([&]() {
+        int fd = connectTo(kPort);
+        if (fd < 0) {
+            loop.queueInLoop([&]() { loop.quit(); });
+            return;
+        }
+        std::atomic<size_t> answered(0);
+        std::thread writer([&]() {
+            std::string request(kRequestSize, 'q');
+            for (size_t i = 0; i < requests; ++i) {
+                while (i >= answered.load(std::memory_order_acquire) + depth) {
+                    std::this_thread::yield();
+                }
+                if (::send(fd, request.data(), request.size(), 0) !=
+                    static_cast<ssize_t>(request.size())) {
+                    return;
+                }
+            }
+        });
+        std::vector<char> in(256 * 1024);
+        size_t total = requests * responseSize;
+        size_t got = 0;
+        while (got < total) {
+            ssize_t n = ::recv(fd, in.data(), in.size(), 0);
+            if (n <= 0) {
+                break;
+            }
+            got += n;
+            answered.store(got / responseSize, std::memory_order_release);
+        }
+        writer.join();
+
+        struct tcp_info info {};
+        socklen_t len = sizeof info;
+        if (::getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) == 0) {
+            result.dataSegs = info.tcpi_data_segs_in;
+        }
+        ::close(fd);
+        loop.queueInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    client.join();
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    result.rate = static_cast<double>(requests) / seconds;
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    size_t requests = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 200000;
+    size_t depth = argc > 2 ? static_cast<size_t>(atol(argv[2])) : 16;
+
+    Logger::setLogLevel(ERROR);
+
+    const std::string header = "HTTP/1.1 200 OK\r\nContent-Length: 1024\r\n\r\n";
+    const std::string body(kBodySize, 'b');
+    const std::string trailer = "\r\n";
+    const size_t responseSize = header.size() + body.size() + trailer.size();
+
+    char path[] = "/tmp/hpn_bench_coalesce_XXXXXX";
+    int fileFd = mkstemp(path);
+    unlink(path);
+    if (fileFd < 0 || ::pwrite(fileFd, body.data(), body.size(), 0) !=
+                          static_cast<ssize_t>(body.size())) {
+        perror("temp file");
+        return 1;
+    }
+
+    printf("requests=%zu depth=%zu response=%zu bytes\n", requests, depth,
+           responseSize);
+    printf("%-5s %-14s %12s %12s %12s\n", "body", "mode", "req/s",
+           "writes/req", "segs/req");
+    for (bool useFile : {false, true}) {
+        for (int m = kImmediate; m <= kCoalesceMore; ++m) {
+            Mode mode = static_cast<Mode>(m);
+            EventLoop loop;
+            TcpServer server(&loop, InetAddress(kPort, true));
+            server.setWriteCoalescing(mode != kImmediate,
+                                      mode == kCoalesceMore);
+            server.setConnectionCallback(
+                [](const TcpServer::TcpConnectionPtr &conn) {
+                    if (conn->connected()) {
+                        conn->setTcpNoDelay(true);
+                    }
+                });
+            server.setMessageCallback(
+                [&](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+                    while (buf->readableBytes() >= kRequestSize) {
+                        buf->retrieve(kRequestSize);
+                        conn->send(header.data(), header.size());
+                        if (useFile) {
+                            conn->sendFile(fileFd, 0, body.size());
+                        } else {
+                            conn->send(body.data(), body.size());
+                        }
+                        conn->send(trailer.data(), trailer.size());
+                    }
+                });
+            server.start();
+
+            g_writes = 0;
+            t_countWrites = true;
+            Result r = run(loop, requests, depth, responseSize);
+            t_countWrites = false;
+
+            printf("%-5s %-14s %12.0f %12.2f %12.2f\n", useFile ? "file" : "mem",
+                   kModeNames[m], r.rate,
+                   static_cast<double>(g_writes.load()) / requests,
+                   static_cast<double>(r.dataSegs) / requests);
+        }
+    }
+    printf("(writes/req: write/writev/sendmsg/sendfile calls in the loop "
+           "thread; segs/req: data segments received by the client)\n");
+    ::close(fileFd);
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "../include/Buffer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+/**
+ * 长度前缀编解码：拷贝路径 vs 视图路径
+ * 用法: bench_codec [messages] [bodySize]
+ * 编码：
+ * - copy: 先拼出 头部+消息体 的std::string，再append
+ * - view: 直接append消息体，再prependInt32补头部
+ * 解码（缓冲区中攒了一批消息）：
+ * - copy: retrieveAsString 取出头部并手工转换字节序，再retrieveAsString取消息体
+ * - view: readInt32 + consume 得到消息体视图
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static double nsPerOp(BenchClock::time_point start, size_t ops) {
+    return static_cast<double>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   BenchClock::now() - start)
+                   .count()) /
+           static_cast<double>(ops);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 2000000;
+    size_t bodySize = argc > 2 ? static_cast<size_t>(atol(argv[2])) : 64;
+    const size_t kBatch = 64;
+
+    std::string body(bodySize, 'b');
+    size_t checksum = 0;
+
+    // 编码
+    Buffer out;
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t len = htobe32(static_cast<uint32_t>(body.size()));
+        std::string frame(reinterpret_cast<const char *>(&len), sizeof len);
+        frame += body;
+        out.append(frame);
+        checksum += out.readableBytes();
+        out.retrieveAll();
+    }
+    double encodeCopy = nsPerOp(start, n);
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < n; ++i) {
+        out.append(body);
+        out.prependInt32(static_cast<int32_t>(body.size()));
+        checksum += out.readableBytes();
+        out.retrieveAll();
+    }
+    double encodeView = nsPerOp(start, n);
+
+    // 解码：每批kBatch条消息
+    Buffer in;
+    auto fill = [&]() {
+        for (size_t i = 0; i < kBatch; ++i) {
+            in.appendInt32(static_cast<int32_t>(body.size()));
+            in.append(body);
+        }
+    };
+
+    start = BenchClock::now();
+    for (size_t done = 0; done < n; done += kBatch) {
+        fill();
+        while (in.readableBytes() >= sizeof(uint32_t)) {
+            std::string header = in.retrieveAsString(sizeof(uint32_t));
+            uint32_t be;
+            memcpy(&be, header.data(), sizeof be);
+            std::string msg = in.retrieveAsString(be32toh(be));
+            checksum += msg.size();
+        }
+    }
+    double decodeCopy = nsPerOp(start, n);
+
+    start = BenchClock::now();
+    for (size_t done = 0; done < n; done += kBatch) {
+        fill();
+        while (in.readableBytes() >= sizeof(int32_t)) {
+            int32_t len = in.readInt32();
+            std::string_view msg = in.consume(static_cast<size_t>(len));
+            checksum += msg.size();
+        }
+        in.retrieveAll();
+    }
+    double decodeView = nsPerOp(start, n);
+
+    printf("%zu messages, %zu byte body          copy      view\n", n,
+           bodySize);
+    printf("  encode (ns/msg)               %8.1f  %8.1f\n", encodeCopy,
+           encodeView);
+    printf("  decode (ns/msg)               %8.1f  %8.1f\n", decodeCopy,
+           decodeView);
+    printf("  (checksum %zu)\n", checksum);
+    return 0;
+}
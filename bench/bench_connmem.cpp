@@ -0,0 +1,221 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 空闲连接的用户态内存
+ * 用法: bench_connmem [n1,n2,...]（默认100000,1000000）
+ * 1. 不带socket的连接对象，按TcpServer的方式创建，fd上限不限制数量：
+ *    - shared: TcpConnection::create + 共享回调（TcpServer的做法）
+ *    - copied: make_shared + 每个连接各自设置回调（回调复制进连接）
+ * 2. 真实的空闲TCP连接经过TcpServer建立，数量受fd上限限制
+ * 每项在fork出的子进程中测量，RSS不受前一项释放的内存影响；
+ * 报告RSS与malloc占用的增量除以连接数，不含内核socket内存
+ */
+
+static const uint16_t kPort = 19190;
+
+static long rssBytes() {
+    long pages = 0;
+    long resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f != nullptr) {
+        if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(f);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+static long heapInUse() {
+    struct mallinfo2 mi = mallinfo2();
+    return static_cast<long>(mi.uordblks + mi.hblkhd);
+}
+
+static void report(const char *what, size_t n, long rss, long heap) {
+    printf("%-8s %9zu %12.0f %12.0f\n", what, n,
+           static_cast<double>(rss) / n, static_cast<double>(heap) / n);
+    fflush(stdout);
+}
+
+// 回调捕获几个指针，复制时std::function要在堆上分配
+struct Handlers {
+    TcpConnection::Callbacks callbacks;
+    size_t messages = 0;
+    size_t bytes = 0;
+    size_t errors = 0;
+
+    Handlers() {
+        callbacks.connection = [](const TcpConnection::TcpConnectionPtr &) {};
+        callbacks.message = [this, self = this, also = this](
+                                const TcpConnection::TcpConnectionPtr &,
+                                Buffer *buf) {
+            ++messages;
+            bytes += buf->readableBytes();
+            (void)self;
+            (void)also;
+            buf->retrieveAll();
+        };
+        callbacks.close = [this](const TcpConnection::TcpConnectionPtr &) {
+            ++errors;
+        };
+    }
+};
+
+static void objects(size_t n, bool shared) {
+    EventLoop loop;
+    Handlers handlers;
+    auto callbacks =
+        std::make_shared<TcpConnection::Callbacks>(handlers.callbacks);
+    std::vector<TcpConnection::TcpConnectionPtr> conns;
+    conns.reserve(n);
+
+    long rss = rssBytes();
+    long heap = heapInUse();
+    for (size_t i = 0; i < n; ++i) {
+        std::string name = "127.0.0.1:19190#" + std::to_string(i + 1);
+        TcpConnection::TcpConnectionPtr conn;
+        if (shared) {
+            conn = TcpConnection::create(&loop, Socket(-1), name);
+            conn->setCallbacks(callbacks);
+        } else {
+            conn = std::make_shared<TcpConnection>(&loop, Socket(-1), name);
+            conn->setConnectionCallback(handlers.callbacks.connection);
+            conn->setMessageCallback(handlers.callbacks.message);
+            conn->setCloseCallback(handlers.callbacks.close);
+        }
+        conns.push_back(std::move(conn));
+    }
+    // 指针数组本身不算连接的开销
+    long vectorBytes = static_cast<long>(n * sizeof(conns[0]));
+    report(shared ? "shared" : "copied", n, rssBytes() - rss - vectorBytes,
+           heapInUse() - heap - vectorBytes);
+}
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void serverConnections(size_t n) {
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort, true));
+    std::atomic<size_t> established(0);
+    Handlers handlers;
+    server.setConnectionCallback(
+        [&](const TcpServer::TcpConnectionPtr &conn) {
+            if (conn->connected()) {
+                ++established;
+            }
+        });
+    server.setMessageCallback(handlers.callbacks.message);
+    server.start();
+
+    // 先跑一轮让Acceptor、定时器等一次性开销发生在测量之前
+    loop.runAfter(0.01, [&]() { loop.quit(); });
+    loop.loop();
+
+    long rss = rssBytes();
+    long heap = heapInUse();
+    std::vector<int> clients;
+    clients.reserve(n);
+    std::atomic<size_t> connected(0);
+    std::atomic<bool> done(false);
+    std::thread client([&]() {
+        for (size_t i = 0; i < n; ++i) {
+            int fd = connectTo(kPort);
+            if (fd < 0) {
+                break;
+            }
+            clients.push_back(fd);
+            ++connected;
+        }
+        done = true;
+    });
+    // 客户端结束并且连接都已建立后退出
+    std::function<void()> check = [&]() {
+        if (done.load() && established.load() == connected.load()) {
+            loop.quit();
+            return;
+        }
+        loop.runAfter(0.01, check);
+    };
+    loop.runAfter(0.01, check);
+    loop.loop();
+    client.join();
+
+    long vectorBytes = static_cast<long>(n * sizeof(int));
+    report("server", established.load(), rssBytes() - rss - vectorBytes,
+           heapInUse() - heap - vectorBytes);
+    for (int fd : clients) {
+        ::close(fd);
+    }
+}
+
+// 在子进程中执行，互不影响
+template <typename F> static void isolated(F &&f) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        f();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<size_t> counts;
+    std::string arg = argc > 1 ? argv[1] : "100000,1000000";
+    for (size_t pos = 0; pos < arg.size();) {
+        size_t comma = arg.find(',', pos);
+        counts.push_back(static_cast<size_t>(
+            atol(arg.substr(pos, comma - pos).c_str())));
+        pos = comma == std::string::npos ? arg.size() : comma + 1;
+    }
+
+    Logger::setLogLevel(ERROR);
+
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    size_t maxSockets = rl.rlim_cur > 256 ? (rl.rlim_cur - 256) / 2 : 0;
+
+    printf("sizeof(TcpConnection)=%zu\n", sizeof(TcpConnection));
+    printf("%-8s %9s %12s %12s\n", "what", "conns", "rss/conn", "heap/conn");
+    for (size_t n : counts) {
+        isolated([n]() { objects(n, false); });
+        isolated([n]() { objects(n, true); });
+    }
+    isolated([&]() {
+        serverConnections(std::min(counts.front(), maxSockets));
+    });
+    printf("(shared: TcpConnection::create + shared callbacks; copied: "
+           "make_shared + per-connection callbacks;\n server: idle TCP "
+           "connections through TcpServer, limited by RLIMIT_NOFILE=%lu)\n",
+           static_cast<unsigned long>(rl.rlim_cur));
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 回环回显吞吐测试
+ * 用法: bench_echo [ioThreads] [clients] [msgSize] [seconds] [policy]
+ * policy: rr | conn | bytes
+ * 每个客户端一个线程，阻塞式 ping-pong，统计总吞吐
+ */
+
+static const uint16_t kPort = 19100;
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 200; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    return -1;
+}
+
+int main(int argc, char *argv[]) {
+    int ioThreads = argc > 1 ? atoi(argv[1]) : 4;
+    int clients = argc > 2 ? atoi(argv[2]) : 16;
+    size_t msgSize = argc > 3 ? static_cast<size_t>(atol(argv[3])) : 4096;
+    int seconds = argc > 4 ? atoi(argv[4]) : 3;
+    const char *policy = argc > 5 ? argv[5] : "rr";
+
+    Logger::setLogLevel(ERROR);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort, true));
+    server.setThreadNum(ioThreads);
+    if (strcmp(policy, "conn") == 0) {
+        server.setDistribution(EventLoopThreadPool::kLeastConnections);
+    } else if (strcmp(policy, "bytes") == 0) {
+        server.setDistribution(EventLoopThreadPool::kLeastPendingBytes);
+    }
+    server.setMessageCallback(
+        [](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+            conn->send(buf->retrieveAllAsString());
+        });
+    server.start();
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> totalBytes(0);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back([&]() {
+            int fd = connectTo(kPort);
+            if (fd < 0) {
+                return;
+            }
+            std::vector<char> out(msgSize, 'x');
+            std::vector<char> in(msgSize);
+            uint64_t bytes = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (::write(fd, out.data(), out.size()) !=
+                    static_cast<ssize_t>(out.size())) {
+                    break;
+                }
+                size_t got = 0;
+                while (got < msgSize) {
+                    ssize_t n = ::read(fd, in.data() + got, msgSize - got);
+                    if (n <= 0) {
+                        break;
+                    }
+                    got += n;
+                }
+                bytes += got;
+            }
+            totalBytes += bytes;
+            ::close(fd);
+        });
+    }
+
+    std::thread timer([&]() {
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        stop = true;
+        for (auto &t : threads) {
+            t.join();
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    timer.join();
+
+    double mb = static_cast<double>(totalBytes.load()) / (1024 * 1024);
+    printf("ioThreads=%d clients=%d msgSize=%zu policy=%s: %.1f MiB/s, "
+           "%.0f msg/s\n",
+           ioThreads, clients, msgSize, policy, mb / seconds,
+           static_cast<double>(totalBytes.load()) / msgSize / seconds);
+    return 0;
+}
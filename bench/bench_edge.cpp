@@ -0,0 +1,110 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 水平触发 vs 边缘触发 的多路复用系统调用对比
+ * 用法: bench_edge [clients] [requests] [responseSize]
+ * 客户端发16字节请求，服务端回复responseSize字节（远大于socket缓冲区），
+ * 水平触发每次响应都要 EPOLL_CTL_MOD 打开/关闭 EPOLLOUT，边缘触发不需要
+ */
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 200; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    return -1;
+}
+
+static void run(bool edgeTriggered, uint16_t port, int clients, int requests,
+                size_t responseSize) {
+    EventLoop loop(Poller::kEpoll);
+    TcpServer server(&loop, InetAddress(port, true));
+    server.setEdgeTriggered(edgeTriggered);
+
+    const std::string response(responseSize, 'r');
+    server.setMessageCallback(
+        [&](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+            while (buf->readableBytes() >= 16) {
+                buf->retrieve(16);
+                conn->send(response);
+            }
+        });
+    server.start();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back([&]() {
+            int fd = connectTo(port);
+            if (fd < 0) {
+                return;
+            }
+            char request[16] = {0};
+            std::vector<char> buf(65536);
+            for (int r = 0; r < requests; ++r) {
+                if (::write(fd, request, sizeof request) != sizeof request) {
+                    break;
+                }
+                size_t got = 0;
+                while (got < responseSize) {
+                    ssize_t n = ::read(fd, buf.data(), buf.size());
+                    if (n <= 0) {
+                        break;
+                    }
+                    got += n;
+                }
+            }
+            ::close(fd);
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread waiter([&]() {
+        for (auto &t : threads) {
+            t.join();
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    waiter.join();
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    double total = static_cast<double>(clients) * requests;
+    printf("%s: %llu poller syscalls, %.2f per response, %.0f responses/s\n",
+           edgeTriggered ? "edge " : "level",
+           static_cast<unsigned long long>(loop.pollerSyscalls()),
+           loop.pollerSyscalls() / total, total / seconds);
+}
+
+int main(int argc, char *argv[]) {
+    int clients = argc > 1 ? atoi(argv[1]) : 8;
+    int requests = argc > 2 ? atoi(argv[2]) : 2000;
+    size_t responseSize =
+        argc > 3 ? static_cast<size_t>(atol(argv[3])) : 256 * 1024;
+
+    Logger::setLogLevel(ERROR);
+
+    run(false, 19120, clients, requests, responseSize);
+    run(true, 19121, clients, requests, responseSize);
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 读预算：一个灌数据的连接对同一loop上其他连接尾延迟的影响
+ * 用法: bench_fairness [seconds] [pingClients] [workPerMsg]
+ * 服务端只有一个loop；所有连接都发64字节的消息，服务端对每条消息做workPerMsg轮哈希，
+ * 'p'开头的消息原样回复。一个flooder连接不停地发'f'消息，pingClients个连接各自
+ * 一问一答测量往返延迟。客户端在一个线程里用poll驱动所有连接
+ * mode:
+ * - et:            边缘触发，一直读到EAGAIN
+ * - et+bytes:      边缘触发，每轮读预算16KB
+ * - et+bytes+msgs: 再加每次回调最多处理64条消息，其余deferRead()
+ * - lt:            水平触发（默认），每轮读一次但回调处理读到的全部消息
+ * - lt+msgs:       水平触发，读预算16KB并且每次回调最多64条消息
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static const uint16_t kPort = 19180;
+static const size_t kMsgSize = 64;
+static const size_t kReadBudget = 16 * 1024;
+static const size_t kMsgBudget = 64;
+
+struct Mode {
+    const char *name;
+    bool edgeTriggered;
+    size_t readBudget;
+    size_t msgBudget;
+};
+
+static const Mode kModes[] = {
+    {"et", true, 0, 0},
+    {"et+bytes", true, kReadBudget, 0},
+    {"et+bytes+msgs", true, kReadBudget, kMsgBudget},
+    {"lt", false, 0, 0},
+    {"lt+msgs", false, kReadBudget, kMsgBudget},
+};
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 200; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    return -1;
+}
+
+// 模拟解析消息的CPU开销
+static uint64_t work(const char *msg, int rounds) {
+    uint64_t h = 14695981039346656037ULL;
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < kMsgSize; ++i) {
+            h = (h ^ static_cast<unsigned char>(msg[i])) * 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+struct Result {
+    std::vector<int64_t> latencies;
+    uint64_t floodBytes = 0;
+};
+
+static Result runClients(int seconds, int pingClients) {
+    Result result;
+    int flooder = connectTo(kPort);
+    std::vector<int> pingers;
+    for (int i = 0; i < pingClients; ++i) {
+        pingers.push_back(connectTo(kPort));
+    }
+
+    std::vector<struct pollfd> pfds(pingClients + 1);
+    std::vector<BenchClock::time_point> sentAt(pingClients);
+    std::vector<size_t> gotBytes(pingClients, 0);
+    std::vector<char> floodMsg(256 * 1024, 'f');
+    char ping[kMsgSize];
+    std::fill(ping, ping + kMsgSize, 'p');
+    char in[4096];
+
+    for (int i = 0; i < pingClients; ++i) {
+        sentAt[i] = BenchClock::now();
+        (void)::send(pingers[i], ping, kMsgSize, 0);
+    }
+
+    auto deadline = BenchClock::now() + std::chrono::seconds(seconds);
+    while (BenchClock::now() < deadline) {
+        pfds[0] = {flooder, POLLOUT, 0};
+        for (int i = 0; i < pingClients; ++i) {
+            pfds[i + 1] = {pingers[i], POLLIN, 0};
+        }
+        if (::poll(pfds.data(), pfds.size(), 10) <= 0) {
+            continue;
+        }
+        if (pfds[0].revents & POLLOUT) {
+            ssize_t n = ::send(flooder, floodMsg.data(), floodMsg.size(), 0);
+            if (n > 0) {
+                result.floodBytes += n;
+            }
+        }
+        for (int i = 0; i < pingClients; ++i) {
+            if (!(pfds[i + 1].revents & POLLIN)) {
+                continue;
+            }
+            ssize_t n = ::recv(pingers[i], in, sizeof in, 0);
+            if (n <= 0) {
+                continue;
+            }
+            gotBytes[i] += n;
+            if (gotBytes[i] >= kMsgSize) {
+                gotBytes[i] -= kMsgSize;
+                auto now = BenchClock::now();
+                result.latencies.push_back(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - sentAt[i])
+                        .count());
+                sentAt[i] = now;
+                (void)::send(pingers[i], ping, kMsgSize, 0);
+            }
+        }
+    }
+
+    ::close(flooder);
+    for (int fd : pingers) {
+        ::close(fd);
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 3;
+    int pingClients = argc > 2 ? atoi(argv[2]) : 16;
+    int workPerMsg = argc > 3 ? atoi(argv[3]) : 4;
+
+    Logger::setLogLevel(ERROR);
+
+    printf("seconds=%d pingClients=%d workPerMsg=%d\n", seconds, pingClients,
+           workPerMsg);
+    printf("%-14s %10s %10s %10s %10s %10s %12s\n", "mode", "pings",
+           "p50(us)", "p99(us)", "p999(us)", "max(us)", "flood MB/s");
+    for (const Mode &mode : kModes) {
+        EventLoop loop;
+        TcpServer server(&loop, InetAddress(kPort, true));
+        server.setEdgeTriggered(mode.edgeTriggered);
+        server.setConnectionCallback(
+            [&mode](const TcpServer::TcpConnectionPtr &conn) {
+                if (conn->connected()) {
+                    conn->setTcpNoDelay(true);
+                    conn->setReadBudget(mode.readBudget);
+                }
+            });
+        uint64_t sink = 0;
+        server.setMessageCallback(
+            [&](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+                size_t handled = 0;
+                while (buf->readableBytes() >= kMsgSize) {
+                    if (mode.msgBudget > 0 && handled == mode.msgBudget) {
+                        conn->deferRead();
+                        return;
+                    }
+                    sink += work(buf->peek(), workPerMsg);
+                    if (buf->peek()[0] == 'p') {
+                        conn->send(buf->peek(), kMsgSize);
+                    }
+                    buf->retrieve(kMsgSize);
+                    ++handled;
+                }
+            });
+        server.start();
+
+        Result result;
+        std::thread client([&]() {
+            result = runClients(seconds, pingClients);
+            loop.queueInLoop([&]() { loop.quit(); });
+        });
+        loop.loop();
+        client.join();
+
+        std::sort(result.latencies.begin(), result.latencies.end());
+        printf("%-14s %10zu %10ld %10ld %10ld %10ld %12.1f\n", mode.name,
+               result.latencies.size(), percentile(result.latencies, 0.5),
+               percentile(result.latencies, 0.99),
+               percentile(result.latencies, 0.999),
+               result.latencies.empty() ? 0L : result.latencies.back(),
+               result.floodBytes / 1e6 / seconds);
+        (void)sink;
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "../include/Buffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+/**
+ * 分隔符查找微基准
+ * 用法: bench_find [iterations]
+ * 1. 分隔符在行尾，不同行长下查找 "\r\n" 的吞吐(GB/s)：
+ *    逐字节循环 / std::search / ByteSearch 各级实现（scalar 即 memchr+memcmp）
+ * 2. 1KB 的HTTP请求头中查找 "\r\n\r\n"，"\r" 每行都会出现
+ * 3. 64KB 的请求按1KB分批到达，每到一批查找一次 "\r\n"：
+ *    每次从头扫描 vs findCRLF 从上次位置继续
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static double secondsSince(BenchClock::time_point start) {
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+// 防止编译器把查找结果优化掉
+static size_t g_sink = 0;
+
+static const char *byteLoopCRLF(const char *p, size_t len) {
+    for (size_t i = 0; i + 1 < len; ++i) {
+        if (p[i] == '\r' && p[i + 1] == '\n') {
+            return p + i;
+        }
+    }
+    return nullptr;
+}
+
+template <typename F>
+static double throughput(const std::string &data, size_t iterations, F find) {
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        const char *found = find(data.data(), data.size());
+        g_sink += found != nullptr ? static_cast<size_t>(found - data.data())
+                                   : 0;
+    }
+    double bytes = static_cast<double>(data.size()) * iterations;
+    return bytes / secondsSince(start) / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    size_t totalBytes =
+        argc > 1 ? static_cast<size_t>(atol(argv[1])) : (size_t(1) << 31);
+    const ByteSearch::Level best = ByteSearch::detect();
+    printf("cpu: %s\n\n", ByteSearch::levelName(best));
+
+    const size_t lineLengths[] = {32, 256, 4096, 65536};
+    printf("find \"\\r\\n\" at end of line (GB/s)\n");
+    printf("%8s %10s %12s %10s %10s %10s\n", "line", "byte-loop", "std::search",
+           "scalar", "sse2", "avx2");
+    for (size_t len : lineLengths) {
+        std::string data(len - 2, 'a');
+        data += "\r\n";
+        size_t iterations = std::max<size_t>(totalBytes / len, 1);
+        std::string_view crlf("\r\n", 2);
+
+        double loop = throughput(data, iterations, byteLoopCRLF);
+        double search =
+            throughput(data, iterations, [&](const char *p, size_t n) {
+                const char *found =
+                    std::search(p, p + n, crlf.begin(), crlf.end());
+                return found == p + n ? nullptr : found;
+            });
+        double levels[3] = {0, 0, 0};
+        for (int level = ByteSearch::kScalar; level <= best; ++level) {
+            ByteSearch::setLevel(static_cast<ByteSearch::Level>(level));
+            levels[level] =
+                throughput(data, iterations, [&](const char *p, size_t n) {
+                    return ByteSearch::find(p, n, crlf);
+                });
+        }
+        ByteSearch::setLevel(best);
+        printf("%8zu %10.2f %12.2f %10.2f %10.2f %10.2f\n", len, loop, search,
+               levels[0], levels[1], levels[2]);
+    }
+
+    // 典型HTTP请求头：每行几十字节，每行都有"\r\n"，查找头部结尾"\r\n\r\n"
+    std::string header = "GET /index.html HTTP/1.1\r\n";
+    while (header.size() < 1024) {
+        header += "X-Header-" + std::to_string(header.size()) +
+                  ": some-value-of-typical-length\r\n";
+    }
+    header += "\r\n";
+    {
+        size_t iterations = std::max<size_t>(totalBytes / header.size(), 1);
+        std::string_view end("\r\n\r\n", 4);
+        double search =
+            throughput(header, iterations, [&](const char *p, size_t n) {
+                const char *found = std::search(p, p + n, end.begin(), end.end());
+                return found == p + n ? nullptr : found;
+            });
+        double levels[3] = {0, 0, 0};
+        for (int level = ByteSearch::kScalar; level <= best; ++level) {
+            ByteSearch::setLevel(static_cast<ByteSearch::Level>(level));
+            levels[level] =
+                throughput(header, iterations, [&](const char *p, size_t n) {
+                    return ByteSearch::find(p, n, end);
+                });
+        }
+        ByteSearch::setLevel(best);
+        printf("\nfind \"\\r\\n\\r\\n\" in a %zuB request header (GB/s)\n",
+               header.size());
+        printf("%8s %12s %10s %10s %10s\n", "", "std::search", "scalar",
+               "sse2", "avx2");
+        printf("%8s %12.2f %10.2f %10.2f %10.2f\n", "", search, levels[0],
+               levels[1], levels[2]);
+    }
+
+    // 半包场景
+    const size_t kRequest = 64 * 1024;
+    const size_t kChunk = 1024;
+    std::string request(kRequest - 2, 'a');
+    request += "\r\n";
+    size_t rounds = std::max<size_t>(totalBytes / kRequest / 64, 1);
+
+    Buffer buf;
+    auto start = BenchClock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t off = 0; off < kRequest; off += kChunk) {
+            buf.append(request.data() + off, kChunk);
+            g_sink += buf.find(std::string_view("\r\n", 2)) != nullptr;
+        }
+        buf.retrieveAll();
+    }
+    double rescan = secondsSince(start) / rounds * 1e6;
+
+    start = BenchClock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t off = 0; off < kRequest; off += kChunk) {
+            buf.append(request.data() + off, kChunk);
+            g_sink += buf.findCRLF() != nullptr;
+        }
+        buf.retrieveAll();
+    }
+    double resume = secondsSince(start) / rounds * 1e6;
+
+    printf("\n%zuKB request in %zuB chunks (us/request)\n", kRequest / 1024,
+           kChunk);
+    printf("  rescan from start  %8.2f\n", rescan);
+    printf("  resume (findCRLF)  %8.2f\n", resume);
+    printf("(sink %zu)\n", g_sink);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "../include/EventLoop.h"
+#include "../include/TimingWheel.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * 空闲超时热路径开销
+ * 用法: bench_idle [numConnections]
+ * - wheel touch: handleRead中刷新时间轮条目（一次内存写）
+ * - heap reset : 同样的刷新用TimerQueue实现（cancel + runAfter）
+ * - wheel tick : 每个tick摊到每个条目的处理开销
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static double nsPerOp(BenchClock::time_point start, BenchClock::time_point end,
+                      size_t ops) {
+    return static_cast<double>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                   .count()) /
+           static_cast<double>(ops);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 1000000;
+    const size_t kTouches = 10 * n;
+
+    EventLoop loop;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+
+    std::vector<size_t> order(kTouches);
+    for (auto &i : order) {
+        i = pick(rng);
+    }
+
+    // 1. 时间轮：随机连接上的活动刷新
+    TimingWheel wheel(nullptr);
+    std::vector<TimingWheel::Entry> entries(n);
+    for (auto &e : entries) {
+        wheel.add(&e, 60.0);
+    }
+
+    auto start = BenchClock::now();
+    for (size_t i : order) {
+        wheel.touch(&entries[i]);
+    }
+    auto end = BenchClock::now();
+    printf("wheel touch  (%zu conns): %.2f ns/op\n", n,
+           nsPerOp(start, end, kTouches));
+
+    // 2. 对比：每次活动重置一个堆定时器
+    std::vector<TimerId> timers(n);
+    for (size_t i = 0; i < n; ++i) {
+        timers[i] = loop.runAfter(60.0, []() {});
+    }
+    start = BenchClock::now();
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = order[k];
+        loop.cancel(timers[i]);
+        timers[i] = loop.runAfter(60.0, []() {});
+    }
+    end = BenchClock::now();
+    printf("heap reset   (%zu conns): %.2f ns/op\n", n, nsPerOp(start, end, n));
+
+    // 3. 时间轮转过一整个超时周期，全部到期
+    size_t ticks = static_cast<size_t>(60.0 / TimingWheel::kDefaultTickSeconds);
+    start = BenchClock::now();
+    for (size_t t = 0; t <= ticks; ++t) {
+        wheel.tick();
+    }
+    end = BenchClock::now();
+    printf("wheel expire (%zu conns): %.2f ns/conn, remaining=%zu\n", n,
+           nsPerOp(start, end, n), wheel.size());
+
+    return 0;
+}
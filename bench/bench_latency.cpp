@@ -0,0 +1,147 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 阻塞 vs 自旋 的往返延迟
+ * 用法: bench_latency [roundTrips] [gapUs] [msgSize]
+ * 单连接ping-pong，服务端跑在一个子循环上，客户端非阻塞忙读，
+ * 只测量服务端loop的唤醒延迟。gapUs为每次请求之间的空闲时间，
+ * 空闲越长，阻塞模式越可能进入深度睡眠
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static void pinSelf(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof set, &set);
+}
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 200; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    return -1;
+}
+
+static void run(const char *mode, uint16_t port, int spinUs, int busyPollUs,
+                int roundTrips, int gapUs, size_t msgSize) {
+    bool pin = std::thread::hardware_concurrency() >= 3;
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port, true));
+    server.setThreadNum(1);
+    server.threadPool()->setSpinBudget(std::chrono::microseconds(spinUs));
+    if (pin) {
+        server.threadPool()->setCpuAffinity({1});
+    }
+    server.setBusyPoll(busyPollUs);
+    server.setMessageCallback(
+        [](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+            conn->send(buf->retrieveAllAsString());
+        });
+    server.start();
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(roundTrips);
+    std::thread client([&]() {
+        if (pin) {
+            pinSelf(2);
+        }
+        int fd = connectTo(port);
+        if (fd >= 0) {
+            std::vector<char> out(msgSize, 'x');
+            std::vector<char> in(msgSize);
+            for (int i = 0; i < roundTrips; ++i) {
+                if (gapUs > 0) {
+                    // 忙等，避免客户端自己的睡眠唤醒混进测量
+                    auto until = BenchClock::now() +
+                                 std::chrono::microseconds(gapUs);
+                    while (BenchClock::now() < until) {
+                    }
+                }
+                auto start = BenchClock::now();
+                if (::write(fd, out.data(), out.size()) !=
+                    static_cast<ssize_t>(out.size())) {
+                    break;
+                }
+                size_t got = 0;
+                while (got < msgSize) {
+                    ssize_t n = ::read(fd, in.data() + got, msgSize - got);
+                    if (n == 0 || (n < 0 && errno != EAGAIN)) {
+                        break;
+                    }
+                    if (n > 0) {
+                        got += n;
+                    }
+                }
+                latencies.push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        BenchClock::now() - start)
+                        .count());
+            }
+            ::close(fd);
+        }
+        loop.runInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    client.join();
+
+    if (latencies.empty()) {
+        printf("%-16s: no samples\n", mode);
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    size_t n = latencies.size();
+    printf("%-16s: p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+           mode, percentile(latencies, 0.5) / 1000.0,
+           percentile(latencies, 0.99) / 1000.0,
+           percentile(latencies, 0.999) / 1000.0, latencies[n - 1] / 1000.0);
+}
+
+int main(int argc, char *argv[]) {
+    int roundTrips = argc > 1 ? atoi(argv[1]) : 20000;
+    int gapUs = argc > 2 ? atoi(argv[2]) : 50;
+    size_t msgSize = argc > 3 ? static_cast<size_t>(atol(argv[3])) : 64;
+
+    Logger::setLogLevel(ERROR);
+
+    if (std::thread::hardware_concurrency() < 3) {
+        printf("fewer than 3 CPUs: the spinning loop competes with the "
+               "client, spin results are not meaningful\n");
+    }
+
+    run("blocking", 19130, 0, 0, roundTrips, gapUs, msgSize);
+    run("spin 1ms", 19131, 1000, 0, roundTrips, gapUs, msgSize);
+    run("spin+busy_poll", 19132, 1000, 50, roundTrips, gapUs, msgSize);
+    return 0;
+}
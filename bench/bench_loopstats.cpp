@@ -0,0 +1,84 @@
+#include "../include/Channel.h"
+#include "../include/EventLoop.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * EventLoop 运行统计的开销与输出
+ * 用法: bench_loopstats [channels] [callbacks]
+ * channels个eventfd在回调里重新写入自己，每轮都就绪，
+ * 测量每个回调的平均耗时；分别用 -DHPN_LOOP_STATS=ON/OFF 编译对比开销
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static void printHistogram(const char *name,
+                           const LogHistogram::Snapshot &h, double scale,
+                           const char *unit) {
+    printf("  %-22s count %-9llu mean %8.2f  p50 %8.2f  p99 %8.2f  "
+           "max %8.2f %s\n",
+           name, static_cast<unsigned long long>(h.count), h.mean() / scale,
+           h.percentile(0.5) / scale, h.percentile(0.99) / scale,
+           h.max / scale, unit);
+}
+
+int main(int argc, char *argv[]) {
+    int numChannels = argc > 1 ? atoi(argv[1]) : 64;
+    long target = argc > 2 ? atol(argv[2]) : 2000000;
+
+    EventLoop loop;
+    std::vector<int> fds;
+    std::vector<std::unique_ptr<Channel>> channels;
+    long callbacks = 0;
+
+    for (int i = 0; i < numChannels; ++i) {
+        int fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+        fds.push_back(fd);
+        channels.emplace_back(new Channel(&loop, fd));
+        channels.back()->setReadCallback([&, fd]() {
+            uint64_t value;
+            ssize_t n = ::read(fd, &value, sizeof value);
+            n = ::write(fd, &value, sizeof value);
+            (void)n;
+            if (++callbacks == target) {
+                loop.quit();
+            }
+        });
+        channels.back()->enableReading();
+    }
+
+    auto start = BenchClock::now();
+    loop.loop();
+    double ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            BenchClock::now() - start)
+            .count());
+
+    printf("HPN_LOOP_STATS=%d: %ld callbacks, %.1f ns/callback\n",
+           HPN_LOOP_STATS, callbacks, ns / callbacks);
+
+    LoopStats::Snapshot s = loop.stats();
+    if (s.iterations > 0) {
+        printf("  iterations %llu, slow callbacks %llu\n",
+               static_cast<unsigned long long>(s.iterations),
+               static_cast<unsigned long long>(s.slowCallbacks));
+        printHistogram("wait", s.waitNanos, 1000.0, "us");
+        printHistogram("process", s.processNanos, 1000.0, "us");
+        printHistogram("callback", s.callbackNanos, 1.0, "ns");
+        printHistogram("events/iteration", s.eventsPerIteration, 1.0, "");
+    }
+
+    for (auto &channel : channels) {
+        channel->disableAll();
+        channel->remove();
+    }
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * epoll 与 io_uring 后端对比
+ * 用法: bench_poller [clients] [seconds] [msgSize]
+ * 同一份 TcpServer/TcpConnection 回显代码，分别跑两个后端，
+ * 报告每次往返的多路复用系统调用数以及往返延迟 p50/p99
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 200; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    return -1;
+}
+
+static void runBackend(Poller::Type type, uint16_t port, int clients,
+                       int seconds, size_t msgSize) {
+    EventLoop loop(type);
+    TcpServer server(&loop, InetAddress(port, true));
+    server.setMessageCallback(
+        [](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+            conn->send(buf->retrieveAllAsString());
+        });
+    server.start();
+
+    std::atomic<bool> stop(false);
+    std::mutex mutex;
+    std::vector<int64_t> latencies;
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < clients; ++i) {
+        threads.emplace_back([&]() {
+            int fd = connectTo(port);
+            if (fd < 0) {
+                return;
+            }
+            std::vector<char> out(msgSize, 'x');
+            std::vector<char> in(msgSize);
+            std::vector<int64_t> local;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto start = BenchClock::now();
+                if (::write(fd, out.data(), out.size()) !=
+                    static_cast<ssize_t>(out.size())) {
+                    break;
+                }
+                size_t got = 0;
+                while (got < msgSize) {
+                    ssize_t n = ::read(fd, in.data() + got, msgSize - got);
+                    if (n <= 0) {
+                        break;
+                    }
+                    got += n;
+                }
+                local.push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        BenchClock::now() - start)
+                        .count());
+            }
+            ::close(fd);
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+        });
+    }
+
+    std::thread timer([&]() {
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        stop = true;
+        for (auto &t : threads) {
+            t.join();
+        }
+        loop.quit();
+    });
+
+    loop.loop();
+    timer.join();
+
+    if (latencies.empty()) {
+        printf("%-8s: no samples\n", loop.pollerName());
+        return;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    size_t n = latencies.size();
+    printf("%-8s: %zu round trips, %.2f poller syscalls/rt, "
+           "p50 %.1f us, p99 %.1f us\n",
+           loop.pollerName(), n,
+           static_cast<double>(loop.pollerSyscalls()) / n,
+           percentile(latencies, 0.5) / 1000.0,
+           percentile(latencies, 0.99) / 1000.0);
+}
+
+int main(int argc, char *argv[]) {
+    int clients = argc > 1 ? atoi(argv[1]) : 8;
+    int seconds = argc > 2 ? atoi(argv[2]) : 3;
+    size_t msgSize = argc > 3 ? static_cast<size_t>(atol(argv[3])) : 64;
+
+    Logger::setLogLevel(ERROR);
+
+    runBackend(Poller::kEpoll, 19110, clients, seconds, msgSize);
+    runBackend(Poller::kIoUring, 19111, clients, seconds, msgSize);
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include "../include/Buffer.h"
+#include "../include/BufferPool.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+
+/**
+ * readFd 批量读取吞吐与拷贝量
+ * 用法: bench_readfd [totalMB] [consumeEvery]
+ * 写线程持续写socketpair，读端每次readFd后（每consumeEvery次）消费全部数据
+ * - legacy  : 原实现，栈上64KB extrabuf + append 二次拷贝
+ * - adaptive: 自适应预留 + 每线程溢出区
+ * 报告吞吐以及每字节经过溢出区再拷贝的比例
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+// 原实现：固定的栈上溢出区，超出可写空间的部分再append
+static ssize_t legacyReadFd(Buffer &buf, int fd, uint64_t *copied) {
+    char extrabuf[65536];
+    struct iovec vec[2];
+    const size_t writable = buf.writableBytes();
+    vec[0].iov_base = buf.beginWrite();
+    vec[0].iov_len = writable;
+    vec[1].iov_base = extrabuf;
+    vec[1].iov_len = sizeof extrabuf;
+
+    const ssize_t n = ::readv(fd, vec, 2);
+    if (n <= 0) {
+        return n;
+    }
+    if (static_cast<size_t>(n) <= writable) {
+        buf.hasWritten(n);
+    } else {
+        buf.hasWritten(writable);
+        buf.append(extrabuf, n - writable);
+        *copied += n - writable;
+    }
+    return n;
+}
+
+template <typename ReadFn>
+static void run(const char *name, size_t total, ReadFn readOnce) {
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    int size = 1024 * 1024;
+    ::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof size);
+    ::setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof size);
+
+    std::thread writer([&]() {
+        std::string chunk(256 * 1024, 'w');
+        size_t sent = 0;
+        while (sent < total) {
+            ssize_t n = ::write(fds[0], chunk.data(),
+                                std::min(chunk.size(), total - sent));
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+        ::shutdown(fds[0], SHUT_WR);
+    });
+
+    size_t received = 0;
+    uint64_t copied = 0;
+    size_t reads = 0;
+    auto start = BenchClock::now();
+    while (true) {
+        ssize_t n = readOnce(fds[1], &copied);
+        if (n <= 0) {
+            break;
+        }
+        received += n;
+        ++reads;
+    }
+    double seconds =
+        std::chrono::duration<double>(BenchClock::now() - start).count();
+    writer.join();
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    printf("%-18s %8.0f MB/s  %6.0f KB/read  %.3f copies/byte\n", name,
+           received / seconds / 1e6, received / 1024.0 / reads,
+           static_cast<double>(copied) / received);
+}
+
+int main(int argc, char *argv[]) {
+    size_t total = (argc > 1 ? static_cast<size_t>(atol(argv[1])) : 1024) *
+                   1024 * 1024;
+    int consumeEvery = argc > 2 ? atoi(argv[2]) : 1;
+
+    // 读到的数据每consumeEvery次读取后全部消费，模拟解析完整消息
+    {
+        Buffer buf;
+        int count = 0;
+        run("legacy", total,
+            [&](int fd, uint64_t *copied) {
+                ssize_t n = legacyReadFd(buf, fd, copied);
+                if (++count % consumeEvery == 0) {
+                    buf.retrieveAll();
+                }
+                return n;
+            });
+    }
+    {
+        Buffer buf;
+        int count = 0;
+        run("adaptive", total,
+            [&](int fd, uint64_t *copied) {
+                uint64_t before = Buffer::overflowCopiedBytes();
+                int savedErrno = 0;
+                ssize_t n = buf.readFd(fd, &savedErrno);
+                *copied += Buffer::overflowCopiedBytes() - before;
+                if (++count % consumeEvery == 0) {
+                    buf.retrieveAll();
+                }
+                return n;
+            });
+    }
+    {
+        BufferPool pool;
+        Buffer buf(&pool);
+        int count = 0;
+        run("adaptive (pooled)", total,
+            [&](int fd, uint64_t *copied) {
+                uint64_t before = Buffer::overflowCopiedBytes();
+                int savedErrno = 0;
+                ssize_t n = buf.readFd(fd, &savedErrno);
+                *copied += Buffer::overflowCopiedBytes() - before;
+                if (++count % consumeEvery == 0) {
+                    buf.retrieveAll();
+                }
+                return n;
+            });
+    }
+    return 0;
+}
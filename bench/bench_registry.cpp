@@ -0,0 +1,154 @@
+#include "../include/Channel.h"
+#include "../include/EventLoop.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 大量注册Channel下的 epoll 注册表与事件批量
+ * 用法: bench_registry [active] [rounds]
+ * 分别注册 10k / 100k 个eventfd，测量：
+ * - updateChannel（EPOLL_CTL_MOD）的单次开销
+ * - 每轮随机让 active 个fd就绪，统计每次唤醒取回的事件数与事件数组大小
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static double elapsedNs(BenchClock::time_point start) {
+    return static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            BenchClock::now() - start)
+            .count());
+}
+
+// 尽量把fd上限提到需要的数量
+static size_t raiseFdLimit(size_t want) {
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur < want) {
+        rl.rlim_cur = std::min<rlim_t>(want, rl.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+    }
+    return rl.rlim_cur;
+}
+
+static void run(size_t numChannels, size_t active, int rounds) {
+    EventLoop loop(Poller::kEpoll);
+    std::mt19937 rng(42);
+
+    std::vector<int> fds;
+    std::vector<std::unique_ptr<Channel>> channels;
+    fds.reserve(numChannels);
+    channels.reserve(numChannels);
+
+    size_t handled = 0;
+    for (size_t i = 0; i < numChannels; ++i) {
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0) {
+            break;
+        }
+        fds.push_back(fd);
+        channels.emplace_back(new Channel(&loop, fd));
+        channels.back()->setReadCallback([fd, &handled]() {
+            uint64_t value;
+            ssize_t n = ::read(fd, &value, sizeof value);
+            (void)n;
+            ++handled;
+        });
+        channels.back()->enableReading();
+    }
+    numChannels = fds.size();
+    active = std::min(active, numChannels);
+
+    // 1. 在已注册的fd上随机开关可写关注
+    std::uniform_int_distribution<size_t> pick(0, numChannels - 1);
+    const size_t kUpdates = 200000;
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < kUpdates; ++i) {
+        Channel *channel = channels[pick(rng)].get();
+        if (channel->isWriting()) {
+            channel->disableWriting();
+        } else {
+            channel->enableWriting();
+        }
+    }
+    double updateNs = elapsedNs(start) / kUpdates;
+    for (auto &channel : channels) {
+        if (channel->isWriting()) {
+            channel->disableWriting();
+        }
+    }
+
+    // 2. 每轮让active个fd同时就绪，全部处理完再开始下一轮
+    std::vector<size_t> order(numChannels);
+    for (size_t i = 0; i < numChannels; ++i) {
+        order[i] = i;
+    }
+    uint64_t wakeupsBefore = loop.pollerWakeups();
+    uint64_t eventsBefore = loop.pollerEvents();
+    int round = 0;
+    std::function<void()> fire = [&]() {
+        if (round > 0 && handled < active) {
+            loop.queueInLoop(fire);
+            return;
+        }
+        if (round++ == rounds) {
+            loop.quit();
+            return;
+        }
+        handled = 0;
+        // 只打乱前active个位置
+        uint64_t one = 1;
+        for (size_t i = 0; i < active; ++i) {
+            std::uniform_int_distribution<size_t> rest(i, numChannels - 1);
+            std::swap(order[i], order[rest(rng)]);
+            ssize_t n = ::write(fds[order[i]], &one, sizeof one);
+            (void)n;
+        }
+        loop.queueInLoop(fire);
+    };
+
+    // 第一轮在loop()之前直接执行，写入的fd就绪会唤醒第一次poll
+    start = BenchClock::now();
+    fire();
+    loop.loop();
+    double roundUs = elapsedNs(start) / 1000.0 / rounds;
+
+    uint64_t wakeups = loop.pollerWakeups() - wakeupsBefore;
+    uint64_t events = loop.pollerEvents() - eventsBefore;
+    printf("%7zu channels: update %.0f ns/op | %zu ready/round: %.1f us/round, "
+           "%.1f events/wakeup, batch size %zu, full batches %llu\n",
+           numChannels, updateNs, active, roundUs,
+           static_cast<double>(events) / wakeups, loop.pollerBatchSize(),
+           static_cast<unsigned long long>(loop.pollerFullBatches()));
+
+    for (auto &channel : channels) {
+        channel->disableAll();
+        channel->remove();
+    }
+    for (int fd : fds) {
+        ::close(fd);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t active = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 2000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 200;
+
+    size_t limit = raiseFdLimit(100000 + 64);
+    if (limit < 100000 + 64) {
+        printf("RLIMIT_NOFILE=%zu, channel count is capped\n", limit);
+    }
+
+    run(10000, active, rounds);
+    run(100000, active, rounds);
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 短连接：单Acceptor与每个loop各自accept的对比
+ * 用法: bench_reuseport [seconds] [ioThreads] [clientThreads]
+ * 服务端ioThreads个子循环，连接建立后在所属loop上发1字节问候；客户端clientThreads个
+ * 线程不停地connect、等问候、RST关闭。accept延迟为connect开始到收到问候，
+ * 单Acceptor模式下包含baseLoop到子循环的转交
+ * mode:
+ * - single:    baseLoop一个Acceptor，轮询分给子循环（默认）
+ * - reuseport: 每个子循环一个SO_REUSEPORT监听socket
+ * - exclusive: 每个子循环共享监听socket，EPOLLEXCLUSIVE注册
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static const uint16_t kPort = 19210;
+
+struct Mode {
+    const char *name;
+    TcpServer::ListenMode listenMode;
+};
+
+static const Mode kModes[] = {
+    {"single", TcpServer::kSingleAcceptor},
+    {"reuseport", TcpServer::kReusePort},
+    {"exclusive", TcpServer::kExclusive},
+};
+
+// 每个客户端线程：连接、等1字节问候、RST关闭，记录每次的耗时
+static void runClient(BenchClock::time_point deadline,
+                      std::vector<int64_t> *latencies) {
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    while (BenchClock::now() < deadline) {
+        auto start = BenchClock::now();
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            continue;
+        }
+        char c;
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
+            ::recv(fd, &c, 1, 0) == 1) {
+            latencies->push_back(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    BenchClock::now() - start)
+                    .count());
+        }
+        // RST关闭，客户端不留TIME_WAIT，端口不会耗尽
+        struct linger lg {1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        ::close(fd);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 3;
+    int ioThreads = argc > 2 ? atoi(argv[2]) : 4;
+    int clientThreads = argc > 3 ? atoi(argv[3]) : 4;
+
+    Logger::setLogLevel(ERROR);
+
+    printf("seconds=%d ioThreads=%d clientThreads=%d\n", seconds, ioThreads,
+           clientThreads);
+    printf("%-10s %10s %10s %10s %10s %10s %14s\n", "mode", "conns/s",
+           "p50(us)", "p99(us)", "p999(us)", "max(us)", "per-loop min/max");
+    for (const Mode &mode : kModes) {
+        EventLoop loop;
+        TcpServer server(&loop, InetAddress(kPort, true));
+        server.setThreadNum(ioThreads);
+        server.setListenMode(mode.listenMode);
+
+        // 每个子循环建立了多少连接，只在各自的loop线程中累加
+        std::mutex mutex;
+        std::map<EventLoop *, uint64_t> perLoop;
+        server.setConnectionCallback(
+            [&](const TcpServer::TcpConnectionPtr &conn) {
+                if (conn->connected()) {
+                    conn->setTcpNoDelay(true);
+                    conn->send("x", 1);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++perLoop[conn->getLoop()];
+                }
+            });
+        server.start();
+
+        auto deadline = BenchClock::now() + std::chrono::seconds(seconds);
+        std::vector<std::vector<int64_t>> latencies(clientThreads);
+        std::vector<std::thread> clients;
+        for (int i = 0; i < clientThreads; ++i) {
+            clients.emplace_back(runClient, deadline, &latencies[i]);
+        }
+        std::thread waiter([&]() {
+            for (auto &t : clients) {
+                t.join();
+            }
+            loop.queueInLoop([&]() { loop.quit(); });
+        });
+        loop.loop();
+        waiter.join();
+
+        std::vector<int64_t> all;
+        for (auto &l : latencies) {
+            all.insert(all.end(), l.begin(), l.end());
+        }
+        std::sort(all.begin(), all.end());
+        uint64_t minPerLoop = all.size();
+        uint64_t maxPerLoop = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (EventLoop *l : server.threadPool()->getAllLoops()) {
+                uint64_t n = perLoop.count(l) ? perLoop[l] : 0;
+                minPerLoop = std::min(minPerLoop, n);
+                maxPerLoop = std::max(maxPerLoop, n);
+            }
+        }
+        printf("%-10s %10.0f %10ld %10ld %10ld %10ld %7lu/%lu\n", mode.name,
+               static_cast<double>(all.size()) / seconds,
+               percentile(all, 0.5), percentile(all, 0.99),
+               percentile(all, 0.999), all.empty() ? 0L : all.back(),
+               static_cast<unsigned long>(minPerLoop),
+               static_cast<unsigned long>(maxPerLoop));
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 大文件发送吞吐：sendFile vs 读进用户态再send
+ * 用法: bench_sendfile [fileMB] [requests]
+ * 客户端每发1字节请求，服务端回整个文件，客户端读完再发下一个请求
+ * - buffered: 每块256KB pread进std::string，再send(std::string&&)
+ * - sendfile: sendFile(fd, 0, size)，数据不经过用户态
+ * 同时报告loop线程的CPU时间
+ */
+
+static const uint16_t kPort = 19150;
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 200; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    return -1;
+}
+
+static double threadCpuSeconds() {
+    struct rusage usage;
+    ::getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    size_t fileSize =
+        (argc > 1 ? static_cast<size_t>(atol(argv[1])) : 64) * 1024 * 1024;
+    int requests = argc > 2 ? atoi(argv[2]) : 16;
+
+    Logger::setLogLevel(ERROR);
+
+    char path[] = "/tmp/hpn_bench_sendfile_XXXXXX";
+    int fileFd = mkstemp(path);
+    if (fileFd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    unlink(path);
+    std::string chunk(1024 * 1024, 'f');
+    for (size_t written = 0; written < fileSize; written += chunk.size()) {
+        if (::write(fileFd, chunk.data(), chunk.size()) < 0) {
+            perror("write");
+            return 1;
+        }
+    }
+
+    const char *modes[] = {"buffered", "sendfile"};
+    for (int mode = 0; mode < 2; ++mode) {
+        EventLoop loop;
+        TcpServer server(&loop, InetAddress(kPort, true));
+        server.setMessageCallback(
+            [&, mode](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+                size_t n = buf->readableBytes();
+                buf->retrieveAll();
+                for (size_t i = 0; i < n; ++i) {
+                    if (mode == 1) {
+                        conn->sendFile(fileFd, 0, fileSize);
+                        continue;
+                    }
+                    const size_t kChunk = 256 * 1024;
+                    for (size_t off = 0; off < fileSize; off += kChunk) {
+                        std::string data(std::min(kChunk, fileSize - off),
+                                         '\0');
+                        ssize_t r = ::pread(fileFd, &data[0], data.size(),
+                                            static_cast<off_t>(off));
+                        if (r <= 0) {
+                            break;
+                        }
+                        data.resize(r);
+                        conn->send(std::move(data));
+                    }
+                }
+            });
+        server.start();
+
+        auto start = std::chrono::steady_clock::now();
+        std::thread client([&]() {
+            int fd = connectTo(kPort);
+            std::vector<char> in(256 * 1024);
+            for (int r = 0; r < requests && fd >= 0; ++r) {
+                if (::write(fd, "g", 1) != 1) {
+                    break;
+                }
+                size_t got = 0;
+                while (got < fileSize) {
+                    ssize_t n = ::read(fd, in.data(), in.size());
+                    if (n <= 0) {
+                        break;
+                    }
+                    got += n;
+                }
+            }
+            ::close(fd);
+            loop.queueInLoop([&]() { loop.quit(); });
+        });
+
+        double cpuStart = threadCpuSeconds();
+        loop.loop();
+        double cpu = threadCpuSeconds() - cpuStart;
+        client.join();
+
+        double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        double mb = static_cast<double>(fileSize) * requests / (1024 * 1024);
+        printf("%-9s %4zu MB x %d: %8.1f MiB/s, loop cpu %.2fs (%.2f ms/MB)\n",
+               modes[mode], fileSize / (1024 * 1024), requests, mb / seconds,
+               cpu, cpu * 1000 / mb);
+    }
+
+    ::close(fileFd);
+    return 0;
+}
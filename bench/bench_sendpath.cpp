@@ -0,0 +1,195 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/tcp.h>
+#include <new>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * 回显路径上各种send方式的内存分配次数
+ * 用法: bench_sendpath [messages] [smallSize] [largeSize]
+ * 单个客户端：一个线程持续写，另一个线程读回，服务端在主线程的loop中回显
+ * 只统计loop线程中的operator new，按每次消息回调折算；大消息会写不完，走输出队列
+ * mode:
+ * - copy:   send(buf->peek(), n)                   写不完的部分拷贝
+ * - string: send(const std::string&)               取出时分配并拷贝一次，写不完再拷贝
+ * - move:   send(std::string&&)                    取出时分配并拷贝一次，写不完按引用排队
+ * - buffer: send(Buffer*)                          不分配，写不完时与输出缓冲区交换
+ * - shared: send(SharedPayload)                    一次分配，写不完按引用排队
+ */
+
+static const uint16_t kPort = 19140;
+
+// 替换全局operator new计数，GCC内联后会误报new/free不匹配
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+static thread_local bool t_countAllocs = false;
+static std::atomic<uint64_t> g_allocs(0);
+static std::atomic<uint64_t> g_allocBytes(0);
+
+void *operator new(size_t size) {
+    if (t_countAllocs) {
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+        g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    void *p = malloc(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 200; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    return -1;
+}
+
+enum Mode { kCopy, kString, kMove, kBuffer, kShared };
+static const char *kModeNames[] = {"copy", "string", "move", "buffer",
+                                   "shared"};
+
+static void echo(Mode mode, const TcpServer::TcpConnectionPtr &conn,
+                 Buffer *buf) {
+    switch (mode) {
+    case kCopy:
+        conn->send(buf->peek(), buf->readableBytes());
+        buf->retrieveAll();
+        break;
+    case kString: {
+        std::string message = buf->retrieveAllAsString();
+        conn->send(message);
+        break;
+    }
+    case kMove:
+        conn->send(buf->retrieveAllAsString());
+        break;
+    case kBuffer:
+        conn->send(buf);
+        break;
+    case kShared:
+        conn->send(std::make_shared<const std::string>(buf->peek(),
+                                                       buf->readableBytes()));
+        buf->retrieveAll();
+        break;
+    }
+}
+
+// 返回每秒消息数；分配次数从全局计数器读
+static double run(EventLoop &loop, size_t messages, size_t msgSize) {
+    std::string out(msgSize, 'x');
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread client([&]() {
+        int fd = connectTo(kPort);
+        if (fd < 0) {
+            loop.queueInLoop([&]() { loop.quit(); });
+            return;
+        }
+        std::thread writer([&]() {
+            for (size_t i = 0; i < messages; ++i) {
+                size_t written = 0;
+                while (written < out.size()) {
+                    ssize_t n = ::write(fd, out.data() + written,
+                                        out.size() - written);
+                    if (n <= 0) {
+                        return;
+                    }
+                    written += n;
+                }
+            }
+        });
+        std::vector<char> in(64 * 1024);
+        size_t total = messages * msgSize;
+        size_t got = 0;
+        while (got < total) {
+            ssize_t n = ::read(fd, in.data(), in.size());
+            if (n <= 0) {
+                break;
+            }
+            got += n;
+        }
+        writer.join();
+        ::close(fd);
+        loop.queueInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    client.join();
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    return static_cast<double>(messages) / seconds;
+}
+
+int main(int argc, char *argv[]) {
+    size_t messages = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 200000;
+    size_t smallSize = argc > 2 ? static_cast<size_t>(atol(argv[2])) : 64;
+    size_t largeSize =
+        argc > 3 ? static_cast<size_t>(atol(argv[3])) : 256 * 1024;
+
+    Logger::setLogLevel(ERROR);
+
+    printf("%-8s %10s %12s %12s %12s\n", "mode", "size", "msg/s", "allocs/cb",
+           "bytes/cb");
+    for (size_t msgSize : {smallSize, largeSize}) {
+        size_t count = msgSize == smallSize
+                           ? messages
+                           : std::max<size_t>(messages * smallSize / msgSize * 8,
+                                              100);
+        for (int m = kCopy; m <= kShared; ++m) {
+            Mode mode = static_cast<Mode>(m);
+            EventLoop loop;
+            TcpServer server(&loop, InetAddress(kPort, true));
+            // 小消息会被合并读取，按消息回调次数折算
+            uint64_t callbacks = 0;
+            server.setMessageCallback(
+                [mode, &callbacks](const TcpServer::TcpConnectionPtr &conn,
+                                   Buffer *buf) {
+                    ++callbacks;
+                    echo(mode, conn, buf);
+                });
+            server.start();
+
+            g_allocs = 0;
+            g_allocBytes = 0;
+            t_countAllocs = true;
+            double rate = run(loop, count, msgSize);
+            t_countAllocs = false;
+
+            double perCallback =
+                callbacks > 0 ? static_cast<double>(callbacks) : 1;
+            printf("%-8s %10zu %12.0f %12.2f %12.0f\n", kModeNames[m], msgSize,
+                   rate, g_allocs.load() / perCallback,
+                   g_allocBytes.load() / perCallback);
+        }
+    }
+    printf("(allocs/cb and bytes/cb: operator new in the loop thread per "
+           "message callback)\n");
+    return 0;
+}
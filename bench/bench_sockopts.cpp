@@ -0,0 +1,198 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/SocketOptions.h"
+#include "../include/TcpServer.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * socket选项预设在本机回环上的效果
+ * 用法: bench_sockopts [seconds] [bulkMB]
+ * 服务端按profile设置socket选项，客户端始终使用系统默认选项
+ * - rpc:  客户端发64字节请求，服务端分两次send回复16字节头和256字节体，
+ *         客户端收齐后再发下一个，统计往返延迟。默认开启Nagle时第二次send要等
+ *         第一段的ACK，而客户端在延迟确认
+ * - bulk: 连接建立后服务端连续发送bulkMB兆字节，客户端读完为止，统计吞吐
+ * profile:
+ * - default:    不设置任何选项
+ * - lowLatency: SocketOptions::lowLatency()
+ * - bulk:       SocketOptions::bulkTransfer()
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static const uint16_t kPort = 19230;
+static const size_t kRequestSize = 64;
+static const size_t kHeaderSize = 16;
+static const size_t kBodySize = 256;
+static const size_t kChunkSize = 256 * 1024;
+
+struct Profile {
+    const char *name;
+    SocketOptions options;
+};
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 200; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    ::close(fd);
+    return -1;
+}
+
+static bool recvAll(int fd, char *buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = ::recv(fd, buf + got, len - got, 0);
+        if (n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+static std::vector<int64_t> runRpc(const SocketOptions &options, uint16_t port,
+                                   int seconds) {
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port, true));
+    server.setSocketOptions(options);
+    const std::string header(kHeaderSize, 'h');
+    const std::string body(kBodySize, 'b');
+    server.setMessageCallback(
+        [&](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+            while (buf->readableBytes() >= kRequestSize) {
+                buf->retrieve(kRequestSize);
+                conn->send(header.data(), header.size());
+                conn->send(body.data(), body.size());
+            }
+        });
+    server.start();
+
+    std::vector<int64_t> latencies;
+    std::thread client([&]() {
+        int fd = connectTo(port);
+        if (fd >= 0) {
+            char request[kRequestSize] = {};
+            char response[kHeaderSize + kBodySize];
+            auto deadline = BenchClock::now() + std::chrono::seconds(seconds);
+            while (BenchClock::now() < deadline) {
+                auto start = BenchClock::now();
+                if (::send(fd, request, sizeof request, 0) !=
+                        static_cast<ssize_t>(sizeof request) ||
+                    !recvAll(fd, response, sizeof response)) {
+                    break;
+                }
+                latencies.push_back(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        BenchClock::now() - start)
+                        .count());
+            }
+            ::close(fd);
+        }
+        loop.queueInLoop([&]() { loop.quit(); });
+    });
+    loop.loop();
+    client.join();
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+// 返回MB/s
+static double runBulk(const SocketOptions &options, uint16_t port,
+                      size_t totalBytes) {
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port, true));
+    server.setSocketOptions(options);
+    const std::string chunk(kChunkSize, 'd');
+    size_t sent = 0;
+    // 输出缓冲区写空后再追加，用户态只保留一块
+    auto sendMore = [&](const TcpServer::TcpConnectionPtr &conn) {
+        if (sent < totalBytes) {
+            size_t n = std::min(chunk.size(), totalBytes - sent);
+            sent += n;
+            conn->send(chunk.data(), n);
+        }
+    };
+    server.setConnectionCallback([&](const TcpServer::TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            sendMore(conn);
+        }
+    });
+    server.setWriteCompleteCallback(sendMore);
+    server.start();
+
+    double seconds = 0;
+    std::thread client([&]() {
+        int fd = connectTo(port);
+        if (fd >= 0) {
+            std::vector<char> in(kChunkSize);
+            size_t got = 0;
+            auto start = BenchClock::now();
+            while (got < totalBytes) {
+                ssize_t n = ::recv(fd, in.data(), in.size(), 0);
+                if (n <= 0) {
+                    break;
+                }
+                got += n;
+            }
+            seconds = std::chrono::duration<double>(BenchClock::now() - start)
+                          .count();
+            ::close(fd);
+        }
+        loop.queueInLoop([&]() { loop.quit(); });
+    });
+    loop.loop();
+    client.join();
+    return seconds > 0 ? totalBytes / 1e6 / seconds : 0;
+}
+
+int main(int argc, char *argv[]) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 2;
+    size_t bulkMB = argc > 2 ? static_cast<size_t>(atol(argv[2])) : 2048;
+
+    Logger::setLogLevel(ERROR);
+
+    const Profile profiles[] = {
+        {"default", SocketOptions()},
+        {"lowLatency", SocketOptions::lowLatency()},
+        {"bulk", SocketOptions::bulkTransfer()},
+    };
+
+    printf("seconds=%d bulk=%zuMB\n", seconds, bulkMB);
+    printf("%-11s %10s %10s %10s %10s %12s\n", "profile", "rpcs",
+           "p50(us)", "p99(us)", "max(us)", "bulk MB/s");
+    uint16_t port = kPort;
+    for (const Profile &profile : profiles) {
+        // 每次换一个端口，上一个server的监听socket可能还没释放
+        std::vector<int64_t> latencies =
+            runRpc(profile.options, port++, seconds);
+        double rate = runBulk(profile.options, port++, bulkMB << 20);
+        printf("%-11s %10zu %10ld %10ld %10ld %12.1f\n", profile.name,
+               latencies.size(), percentile(latencies, 0.5),
+               percentile(latencies, 0.99),
+               latencies.empty() ? 0L : latencies.back(), rate);
+        fflush(stdout);
+    }
+    printf("(rpc: 64B request, response sent as 16B header + 256B body; "
+           "bulk: server streams %zuMB, client uses default options)\n",
+           bulkMB);
+    return 0;
+}
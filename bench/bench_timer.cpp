@@ -0,0 +1,72 @@
+#include "../include/EventLoop.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * 定时器队列微基准
+ * 用法: bench_timer [numTimers]
+ * 分别测量在N个未到期定时器规模下的 插入 / 取消 / 批量到期 的单次开销
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static double nsPerOp(BenchClock::time_point start, BenchClock::time_point end,
+                      size_t ops) {
+    return static_cast<double>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                   .count()) /
+           static_cast<double>(ops);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? static_cast<size_t>(atol(argv[1])) : 1000000;
+
+    EventLoop loop;
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int64_t> delayUs(1000000, 3600 * 1000000LL);
+
+    // 1. 插入：随机分布在未来1秒到1小时
+    std::vector<TimerId> ids;
+    ids.reserve(n);
+    TimePoint base = TimerClock::now();
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < n; ++i) {
+        ids.push_back(loop.runAt(base + std::chrono::microseconds(delayUs(rng)),
+                                 []() {}));
+    }
+    auto end = BenchClock::now();
+    printf("insert  %zu timers: %.1f ns/op\n", n, nsPerOp(start, end, n));
+
+    // 2. 取消：随机顺序
+    std::shuffle(ids.begin(), ids.end(), rng);
+    start = BenchClock::now();
+    for (const TimerId &id : ids) {
+        loop.cancel(id);
+    }
+    end = BenchClock::now();
+    printf("cancel  %zu timers: %.1f ns/op\n", n, nsPerOp(start, end, n));
+
+    // 3. 到期：N个定时器在1ms窗口内随机到期，最后一个定时器退出loop
+    // 计时从最早到期时刻开始，包含堆弹出和回调执行
+    size_t fired = 0;
+    BenchClock::time_point lastFire;
+    std::uniform_int_distribution<int64_t> spreadUs(0, 1000);
+    TimePoint due = TimerClock::now() + std::chrono::milliseconds(1000);
+    for (size_t i = 0; i < n; ++i) {
+        loop.runAt(due + std::chrono::microseconds(spreadUs(rng)),
+                   [&]() { ++fired; });
+    }
+    loop.runAt(due + std::chrono::milliseconds(2), [&]() {
+        lastFire = BenchClock::now();
+        loop.quit();
+    });
+    loop.loop();
+    printf("expire  %zu timers: %.1f ns/op (fired=%zu)\n", n,
+           nsPerOp(due, lastFire, n), fired);
+
+    return 0;
+}
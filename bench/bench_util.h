@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 基准程序共用的小工具
+
+// 已排序样本的p分位数（0到1），没有样本时返回0
+inline int64_t percentile(const std::vector<int64_t> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1));
+    return sorted[idx];
+}
@@ -0,0 +1,122 @@
+#include "../include/EventLoop.h"
+#include "../include/Logger.h"
+#include "../include/TcpServer.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * MSG_ZEROCOPY 发送的CPU开销
+ * 用法: bench_zerocopy [payloadMB] [totalGB]
+ * 客户端每发1字节请求，服务端回一份共享负载；统计loop线程每GB的CPU时间
+ * 注意：回环上内核无法真正零拷贝，会在投递给接收方时补一次拷贝
+ * （完成通知带SO_EE_CODE_ZEROCOPY_COPIED），真实网卡上收益更明显
+ */
+
+static const uint16_t kPort = 19160;
+
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < 200; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    return -1;
+}
+
+static double threadCpuSeconds() {
+    struct rusage usage;
+    ::getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    size_t payloadSize =
+        (argc > 1 ? static_cast<size_t>(atol(argv[1])) : 8) * 1024 * 1024;
+    double totalGB = argc > 2 ? atof(argv[2]) : 8;
+    int requests = static_cast<int>(totalGB * 1024 * 1024 * 1024 / payloadSize);
+
+    Logger::setLogLevel(ERROR);
+
+    auto payload = std::make_shared<const std::string>(payloadSize, 'z');
+
+    for (int zeroCopy = 0; zeroCopy < 2; ++zeroCopy) {
+        EventLoop loop;
+        TcpServer server(&loop, InetAddress(kPort, true));
+        uint64_t sends = 0;
+        uint64_t copied = 0;
+        server.setConnectionCallback(
+            [&, zeroCopy](const TcpServer::TcpConnectionPtr &conn) {
+                if (conn->connected()) {
+                    conn->setZeroCopy(zeroCopy == 1);
+                } else {
+                    sends = conn->zeroCopySends();
+                    copied = conn->zeroCopyCopiedSends();
+                }
+            });
+        server.setMessageCallback(
+            [&](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+                size_t n = buf->readableBytes();
+                buf->retrieveAll();
+                for (size_t i = 0; i < n; ++i) {
+                    conn->send(payload);
+                }
+            });
+        server.start();
+
+        auto start = std::chrono::steady_clock::now();
+        std::thread client([&]() {
+            int fd = connectTo(kPort);
+            std::vector<char> in(256 * 1024);
+            for (int r = 0; r < requests && fd >= 0; ++r) {
+                if (::write(fd, "g", 1) != 1) {
+                    break;
+                }
+                size_t got = 0;
+                while (got < payloadSize) {
+                    ssize_t n = ::read(fd, in.data(), in.size());
+                    if (n <= 0) {
+                        break;
+                    }
+                    got += n;
+                }
+            }
+            ::close(fd);
+            // 等服务端处理完关闭
+            usleep(50 * 1000);
+            loop.queueInLoop([&]() { loop.quit(); });
+        });
+
+        double cpuStart = threadCpuSeconds();
+        loop.loop();
+        double cpu = threadCpuSeconds() - cpuStart;
+        client.join();
+
+        double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        double gb = static_cast<double>(payloadSize) * requests /
+                    (1024.0 * 1024 * 1024);
+        printf("%-9s %zuMB x %d: %7.2f GiB/s, loop cpu %.3f s/GiB, "
+               "zerocopy sends %lu (kernel copied %lu)\n",
+               zeroCopy ? "zerocopy" : "copy", payloadSize / (1024 * 1024),
+               requests, gb / seconds, cpu / gb,
+               static_cast<unsigned long>(sends),
+               static_cast<unsigned long>(copied));
+    }
+    return 0;
+}
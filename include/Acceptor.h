@@ -1,26 +1,87 @@
 #pragma once
 
 #include "Channel.h"
+#include "EventLoop.h"
 #include "InetAddress.h"
 #include "Socket.h"
+#include "SocketOptions.h"
+#include <cstdint>
 #include <functional>
 
-class EventLoop;
-
+/**
+ * Acceptor 监听socket
+ * - accept4直接拿到非阻塞、CLOEXEC的连接fd，省掉之后的fcntl
+ * - 每次可读最多accept maxAcceptsPerWakeup个，连接风暴时摊薄epoll_wait，
+ *   又不会让一轮迭代只处理新连接；边缘触发时剩下的排到下一轮继续
+ * - 预留一个空闲fd：EMFILE/ENFILE时先关掉它，accept后立即关闭连接再重新打开，
+ *   否则监听socket一直可读，水平触发下会变成忙循环；
+ *   空闲fd也打不开时暂停监听可读，定时重试打开后再恢复
+ * - 多个loop各自accept时，要么每个Acceptor用SO_REUSEPORT绑定自己的socket，
+ *   要么共享一个监听socket（各自dup一份）并用EPOLLEXCLUSIVE注册
+ */
 class Acceptor {
   public:
     using NewConnectionCallback =
         std::function<void(int sockfd, const InetAddress &)>;
-    Acceptor(EventLoop *loop, const InetAddress &listenAddr);
+    static const int kDefaultMaxAcceptsPerWakeup = 64;
+    // 没有空闲fd时暂停accept，每隔这么久重试打开
+    static constexpr double kIdleFdRetrySeconds = 0.1;
+
+    Acceptor(EventLoop *loop, const InetAddress &listenAddr,
+             bool reusePort = false);
+    // 使用已经绑定好的监听socket，例如另一个Acceptor的listenFd()的dup
+    Acceptor(EventLoop *loop, Socket &&listenSocket);
+    ~Acceptor();
+
+    Acceptor(const Acceptor &) = delete;
+    Acceptor &operator=(const Acceptor &) = delete;
 
     void setNewConnectionCallback(NewConnectionCallback cb);
+    // 边缘触发时每次可读都accept到EAGAIN为止，必须在listen之前设置
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    // 用EPOLLEXCLUSIVE注册监听socket，必须在listen之前设置
+    void setExclusive(bool on) { exclusive_ = on; }
+    // 每次可读最多accept的连接数，至少为1
+    void setMaxAcceptsPerWakeup(int n) { maxAccepts_ = n > 0 ? n : 1; }
+    // 立即设置监听socket的选项，见SocketOptions::applyToListener，必须在listen之前调用
+    bool applySocketOptions(const SocketOptions &opts, const std::string &name) {
+        return opts.applyToListener(acceptSocket_, name);
+    }
     void listen();
     bool listening() const;
+    int listenFd() const { return acceptSocket_.fd(); }
+
+    // 已交给回调的连接数，以及因fd耗尽被直接关闭的连接数
+    uint64_t acceptedCount() const { return accepted_; }
+    uint64_t droppedCount() const { return dropped_; }
 
   private:
+    void handleRead();
+    static void handleDeferredAccept(EventLoop::IterationHook *hook);
+    // backlog里可能还有连接时调用，边缘触发下排到下一轮继续accept
+    void retryNextIteration();
+    // fd耗尽时用空闲fd接受并关闭一个连接，失败返回false
+    bool dropOneConnection();
+    // 空闲fd打不开，连接只能留在backlog里：停止关注可读，定时重试
+    void pauseAccepting();
+    void retryIdleFd();
+
     EventLoop *loop_;
     Socket acceptSocket_;
     Channel acceptChannel_;
     NewConnectionCallback newConnectionCallback_;
+    EventLoop::IterationHook acceptHook_;
+    // 暂停期间重试打开空闲fd的定时器
+    TimerId retryTimer_;
+    int idleFd_;
+    int maxAccepts_;
+    uint64_t accepted_;
+    uint64_t dropped_;
+    // 进入fd耗尽状态时的dropped_
+    uint64_t droppedBefore_;
+    bool exhausted_;
+    bool paused_;
     bool listening_;
-};
\ No newline at end of file
+    bool edgeTriggered_;
+    bool exclusive_;
+};
@@ -1,35 +1,111 @@
 #pragma once
 
-#include <vector>
 #include <string>
+#include <string_view>
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <endian.h>
 #include <sys/uio.h>
+#include "BufferPool.h"
+#include "ByteSearch.h"
 
 /**
  * 设计：
- * 1. 使用std::vector<char> 作为底层存储
+ * 1. 底层是一块连续内存，独立使用时new[]，连接上的Buffer从loop的BufferPool取
  * 2. 维护readIndex和writeIndex
  * 3. 预留头部空间用于协议头
  * 4. 自动增长
+ * 5. 使用池的Buffer懒分配：第一次写入才取内存，读空后整块还给池，
+ *    空闲连接不占用缓冲区内存；独立Buffer读空后只收缩超过kMaxRetainedSize的部分
+ * 6. 分隔符查找用SIMD，并记住上次查到的位置，半包陆续到达时不重复扫描
  */
 
 class Buffer{
 public:
     static const size_t kCheapPrepend = 8;
     static const size_t kInitialSize = 1024;
+    // 独立Buffer读空时保留的最大容量
+    static const size_t kMaxRetainedSize = 64 * 1024;
+    // readFd每次预留的可写空间，按实际读到的量自适应
+    static const size_t kMinReadHint = 1024;
+    static const size_t kInitialReadHint = 4096;
+    static const size_t kMaxReadHint = 256 * 1024;
+    // 每线程一块的溢出区，容纳超出预留空间的数据
+    static const size_t kOverflowSize = 64 * 1024;
 
     // 显示构造
     explicit Buffer(size_t initialSize = kInitialSize):
-        buffer_(kCheapPrepend + initialSize),
+        data_(BufferPool::allocateUnpooled(kCheapPrepend + initialSize)),
+        capacity_(kCheapPrepend + initialSize),
+        pool_(nullptr),
         readIndex_(kCheapPrepend),
-        writeIndex_(kCheapPrepend){}
+        writeIndex_(kCheapPrepend),
+        readHint_(kInitialReadHint),
+        smallReads_(0),
+        scanKey_(kScanNone),
+        scanned_(0){}
+
+    // 懒分配，内存来自pool；只能在pool所属的loop线程读写和析构
+    explicit Buffer(BufferPool* pool):
+        data_(emptyStorage()),
+        capacity_(kCheapPrepend),
+        pool_(pool),
+        readIndex_(kCheapPrepend),
+        writeIndex_(kCheapPrepend),
+        readHint_(kInitialReadHint),
+        smallReads_(0),
+        scanKey_(kScanNone),
+        scanned_(0){}
+
+    ~Buffer() { releaseStorage(); }
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    Buffer(Buffer&& other) noexcept:
+        data_(other.data_),
+        capacity_(other.capacity_),
+        pool_(other.pool_),
+        readIndex_(other.readIndex_),
+        writeIndex_(other.writeIndex_),
+        readHint_(other.readHint_),
+        smallReads_(other.smallReads_),
+        scanKey_(other.scanKey_),
+        scanned_(other.scanned_){
+        other.data_ = emptyStorage();
+        other.capacity_ = kCheapPrepend;
+        other.readIndex_ = other.writeIndex_ = kCheapPrepend;
+        other.scanned_ = 0;
+    }
+
+    Buffer& operator=(Buffer&& other) noexcept {
+        if (this != &other) {
+            releaseStorage();
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+            pool_ = other.pool_;
+            readIndex_ = other.readIndex_;
+            writeIndex_ = other.writeIndex_;
+            readHint_ = other.readHint_;
+            smallReads_ = other.smallReads_;
+            scanKey_ = other.scanKey_;
+            scanned_ = other.scanned_;
+            other.data_ = emptyStorage();
+            other.capacity_ = kCheapPrepend;
+            other.readIndex_ = other.writeIndex_ = kCheapPrepend;
+            other.scanned_ = 0;
+        }
+        return *this;
+    }
 
     size_t readableBytes() const {
         return writeIndex_ - readIndex_;
     }
 
     size_t writableBytes() const {
-        return buffer_.size() - writeIndex_;
+        return capacity_ - writeIndex_;
     }
 
     size_t prependableBytes() const {
@@ -45,6 +121,7 @@ public:
     void retrieve(size_t len) {
         if(len < readableBytes()){
             readIndex_ += len;
+            advanceScan(len);
         } else {
             retrieveAll();
         }
@@ -54,6 +131,71 @@ public:
     void retrieveAll() {
         readIndex_ = kCheapPrepend;
         writeIndex_ = kCheapPrepend;
+        scanned_ = 0;
+        if (pool_ != nullptr || capacity_ > kMaxRetainedSize) {
+            shrinkAfterDrain();
+        }
+    }
+
+    // 存储来源，独立Buffer为nullptr
+    BufferPool* pool() const {
+        return pool_;
+    }
+
+    // 当前占用的内存（含预留头部），没有分配时为0
+    size_t capacity() const {
+        return hasStorage() ? capacity_ : 0;
+    }
+
+    // 丢弃数据并立即归还内存
+    void releaseStorage() {
+        if (hasStorage()) {
+            if (pool_ != nullptr) {
+                pool_->deallocate(data_, capacity_);
+            } else {
+                BufferPool::deallocateUnpooled(data_);
+            }
+        }
+        data_ = emptyStorage();
+        capacity_ = kCheapPrepend;
+        readIndex_ = kCheapPrepend;
+        writeIndex_ = kCheapPrepend;
+        scanned_ = 0;
+    }
+
+    // 不拷贝的只读视图，到下一次写入/读取/retrieve之前有效
+    std::string_view toStringView() const {
+        return std::string_view(peek(), readableBytes());
+    }
+
+    // 消费len字节并返回它们的视图；只移动读位置，不收缩也不归还内存，
+    // 视图到下一次写入/读取/retrieve之前有效
+    std::string_view consume(size_t len) {
+        assert(len <= readableBytes());
+        std::string_view result(peek(), len);
+        readIndex_ += len;
+        advanceScan(len);
+        return result;
+    }
+
+    // 在可读数据中查找，返回第一次出现的位置，找不到返回nullptr
+    // findCRLF/findEOL/find(char) 记住上次查到的位置，对同一个分隔符再次调用时
+    // 只扫描新到达的数据；find(string_view) 每次从头扫描
+    const char* findCRLF() const {
+        return findCached(kScanCRLF, std::string_view("\r\n", 2));
+    }
+
+    const char* findEOL() const {
+        return findCached(kScanEOL, std::string_view("\n", 1));
+    }
+
+    const char* find(char c) const {
+        return findCached(kScanChar | static_cast<unsigned char>(c),
+                          std::string_view(&c, 1));
+    }
+
+    const char* find(std::string_view needle) const {
+        return ByteSearch::find(peek(), readableBytes(), needle);
     }
 
     std::string retrieveAsString(size_t len) {
@@ -91,26 +233,159 @@ public:
         hasWritten(len);
     }
 
-    void append(const std::string& str){
+    void append(std::string_view str){
         append(str.data(), str.size());
     }
 
+    void append(const void* data, size_t len){
+        append(static_cast<const char*>(data), len);
+    }
+
+    // 写到可读数据之前，用于事后补协议头；len不能超过prependableBytes()
+    void prepend(const void* data, size_t len){
+        assert(len <= prependableBytes());
+        if (!hasStorage()) {
+            // 懒分配的Buffer还没有自己的内存，不能写共享的空存储
+            reallocate(kCheapPrepend + kMinReadHint);
+        }
+        readIndex_ -= len;
+        memcpy(begin() + readIndex_, data, len);
+        // 新数据在已扫描区之前，重新扫描
+        scanned_ = 0;
+    }
+
+    // 网络字节序整数
+    void appendInt8(int8_t x) { append(&x, sizeof x); }
+    void appendInt16(int16_t x) {
+        uint16_t be = htobe16(static_cast<uint16_t>(x));
+        append(&be, sizeof be);
+    }
+    void appendInt32(int32_t x) {
+        uint32_t be = htobe32(static_cast<uint32_t>(x));
+        append(&be, sizeof be);
+    }
+    void appendInt64(int64_t x) {
+        uint64_t be = htobe64(static_cast<uint64_t>(x));
+        append(&be, sizeof be);
+    }
+
+    void prependInt8(int8_t x) { prepend(&x, sizeof x); }
+    void prependInt16(int16_t x) {
+        uint16_t be = htobe16(static_cast<uint16_t>(x));
+        prepend(&be, sizeof be);
+    }
+    void prependInt32(int32_t x) {
+        uint32_t be = htobe32(static_cast<uint32_t>(x));
+        prepend(&be, sizeof be);
+    }
+    void prependInt64(int64_t x) {
+        uint64_t be = htobe64(static_cast<uint64_t>(x));
+        prepend(&be, sizeof be);
+    }
+
+    // 要求readableBytes()不少于整数大小
+    int8_t peekInt8() const {
+        assert(readableBytes() >= sizeof(int8_t));
+        return static_cast<int8_t>(*peek());
+    }
+    int16_t peekInt16() const {
+        assert(readableBytes() >= sizeof(int16_t));
+        uint16_t be;
+        memcpy(&be, peek(), sizeof be);
+        return static_cast<int16_t>(be16toh(be));
+    }
+    int32_t peekInt32() const {
+        assert(readableBytes() >= sizeof(int32_t));
+        uint32_t be;
+        memcpy(&be, peek(), sizeof be);
+        return static_cast<int32_t>(be32toh(be));
+    }
+    int64_t peekInt64() const {
+        assert(readableBytes() >= sizeof(int64_t));
+        uint64_t be;
+        memcpy(&be, peek(), sizeof be);
+        return static_cast<int64_t>(be64toh(be));
+    }
+
+    int8_t readInt8() {
+        int8_t x = peekInt8();
+        retrieve(sizeof x);
+        return x;
+    }
+    int16_t readInt16() {
+        int16_t x = peekInt16();
+        retrieve(sizeof x);
+        return x;
+    }
+    int32_t readInt32() {
+        int32_t x = peekInt32();
+        retrieve(sizeof x);
+        return x;
+    }
+    int64_t readInt64() {
+        int64_t x = peekInt64();
+        retrieve(sizeof x);
+        return x;
+    }
+
     // 从fd读取数据
+    // 先按readHint预留可写空间让数据直接落进Buffer，超出部分进每线程的溢出区再拷贝
+    // maxBytes限制这一次最多读取的字节数（读预算）
     // 返回读取的字节数， -1表示错误
-    ssize_t readFd(int fd, int* savedErrno);
+    ssize_t readFd(int fd, int* savedErrno, size_t maxBytes = SIZE_MAX);
+
+    // 当前的自适应读取大小
+    size_t readHint() const { return readHint_; }
+
+    // 本线程readFd从溢出区拷贝进Buffer的累计字节数
+    static uint64_t overflowCopiedBytes();
+
+    // 写出可读数据并消费已写出的部分
+    // 返回写出的字节数， -1表示错误
+    ssize_t writeFd(int fd, int* savedErrno);
 
 private:
+    // 查找缓存记录的分隔符种类，kScanChar的低8位是字符本身
+    static const uint32_t kScanNone = 0;
+    static const uint32_t kScanCRLF = 1;
+    static const uint32_t kScanEOL = 2;
+    static const uint32_t kScanChar = 0x100;
+
+    const char* findCached(uint32_t key, std::string_view delim) const;
+
+    // 读位置前移len字节，已扫描的长度相应减少
+    void advanceScan(size_t len) {
+        scanned_ = scanned_ > len ? scanned_ - len : 0;
+    }
+
     char *begin(){
-        return &*buffer_.begin(); 
+        return data_;
     }
 
     const char *begin() const {
-        return &*buffer_.begin();
+        return data_;
+    }
+
+    // 未分配时指向的共享空存储，只有预留头部，不会被写入
+    static char* emptyStorage() {
+        static char empty[kCheapPrepend];
+        return empty;
     }
 
+    bool hasStorage() const {
+        return data_ != emptyStorage();
+    }
+
+    // 读空后：池中的Buffer整块归还，独立Buffer缩回初始大小
+    void shrinkAfterDrain();
+
+    // 换一块至少newCapacity的内存，可读数据搬到新内存的kCheapPrepend处
+    void reallocate(size_t newCapacity);
+
     void makeSpace(size_t len) {
         if(writableBytes() + prependableBytes() < len + kCheapPrepend){
-            buffer_.resize(writeIndex_ + len);
+            // 按2倍增长，避免连续append时反复搬移
+            reallocate(std::max(writeIndex_ + len, capacity_ * 2));
         } else {
             size_t readable = readableBytes();
             std::copy(begin() + readIndex_,
@@ -121,8 +396,15 @@ private:
         }
     }
 
-    std::vector<char> buffer_;
+    char* data_;
+    size_t capacity_;
+    BufferPool* pool_;
     size_t readIndex_;
     size_t writeIndex_;
+    uint32_t readHint_;
+    uint32_t smallReads_;
+    // [peek(), peek() + scanned_) 内确定没有scanKey_对应的分隔符
+    mutable uint32_t scanKey_;
+    mutable size_t scanned_;
 
 };
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Buffer 存储的按大小分级内存池，每个EventLoop一个
+ * - 1KB 到 1MB 按2的幂分级，申请时向上取整到所在级别
+ * - 每级一条侵入式空闲链表，归还的块LIFO复用，缓存热
+ * - 每级缓存的字节数有上限，超出直接释放给malloc，突发流量过后不会长期占用
+ * - 超过最大级别的申请直接malloc，不缓存
+ * 只能在所属loop线程使用
+ */
+class BufferPool {
+  public:
+    static const size_t kMinBlockSize = 1024;
+    static const int kNumClasses = 11; // 1KB .. 1MB
+    static const size_t kMaxBlockSize = kMinBlockSize << (kNumClasses - 1);
+    static const size_t kMaxCachedBytesPerClass = 1024 * 1024;
+
+    BufferPool();
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // 至少size字节，实际大小写入*capacity
+    char *allocate(size_t size, size_t *capacity);
+    // capacity必须是allocate返回的实际大小
+    void deallocate(char *block, size_t capacity);
+
+    // 释放所有缓存的空闲块
+    void trim();
+
+    // 正在被Buffer使用的字节数与空闲链表缓存的字节数
+    size_t inUseBytes() const { return inUseBytes_; }
+    size_t cachedBytes() const { return cachedBytes_; }
+
+    // 没有池时（loop为空或Buffer独立使用）的分配方式
+    static char *allocateUnpooled(size_t size) { return new char[size]; }
+    static void deallocateUnpooled(char *block) { delete[] block; }
+
+    // 向上取整后的块大小
+    static size_t roundUp(size_t size);
+
+  private:
+    struct FreeNode {
+        FreeNode *next;
+    };
+
+    static int classOf(size_t capacity);
+
+    FreeNode *freeLists_[kNumClasses];
+    size_t cachedPerClass_[kNumClasses];
+    size_t inUseBytes_;
+    size_t cachedBytes_;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * Buffer 用的字节/子串查找
+ * - 单字节直接用memchr，glibc已经按CPU选择了向量实现
+ * - 子串按CPU在运行时选择：AVX2一次比较64字节，SSE2一次16字节，
+ *   其他平台与尾部不足一个向量的部分用memchr找首字节再memcmp
+ * 向量实现同时比较首字节和末字节，两者都命中的位置再memcmp，
+ * "\r\n" 这类短分隔符不需要memcmp
+ */
+class ByteSearch {
+  public:
+    enum Level { kScalar, kSse2, kAvx2 };
+
+    // 返回第一次出现的位置，找不到返回nullptr
+    static const char *findChar(const char *data, size_t len, char c);
+    static const char *find(const char *data, size_t len,
+                            std::string_view needle);
+
+    // 当前使用的实现
+    static Level level();
+    static const char *levelName(Level level);
+    // 本机支持的最高实现
+    static Level detect();
+    // 测试与基准用：指定实现，超过detect()时按detect()处理
+    static void setLevel(Level level);
+};
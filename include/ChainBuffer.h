@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * 分段缓冲区：固定大小的块组成单链表
+ * 1. 接口与Buffer一致（append/peek/retrieve/readFd），另有writeFd
+ * 2. append只往尾块写，写满再挂新块，已有数据永不搬移或重新分配
+ * 3. retrieve整块释放，每个块O(1)
+ * 4. writeFd用writev一次写出多个块
+ * 5. 释放的块留几个在本地空闲链表里复用，避免频繁malloc
+ * 适合大块输出；按行/按长度解析的输入仍建议用Buffer
+ */
+class ChainBuffer {
+  public:
+    static const size_t kBlockSize = 16 * 1024;
+    // writev一次最多提交的块数
+    static const int kMaxIovecs = 64;
+    static const size_t kMaxFreeBlocks = 4;
+
+    ChainBuffer();
+    ~ChainBuffer();
+
+    ChainBuffer(const ChainBuffer &) = delete;
+    ChainBuffer &operator=(const ChainBuffer &) = delete;
+
+    ChainBuffer(ChainBuffer &&other) noexcept;
+    ChainBuffer &operator=(ChainBuffer &&other) noexcept;
+
+    size_t readableBytes() const { return readable_; }
+
+    // 尾块剩余可写空间
+    size_t writableBytes() const;
+
+    // 返回全部可读数据的连续视图；数据跨块时先合并到一个块，代价O(n)
+    const char *peek();
+
+    // 第一个块中可读的连续数据，不做合并
+    const char *firstSegment(size_t *len) const;
+
+    // 消费len字节，读完的块整块回收
+    void retrieve(size_t len);
+    void retrieveAll();
+
+    std::string retrieveAsString(size_t len);
+    std::string retrieveAllAsString() {
+        return retrieveAsString(readableBytes());
+    }
+
+    void append(const char *data, size_t len);
+    void append(const std::string &str) { append(str.data(), str.size()); }
+
+    // 从fd读取，尾块剩余空间加一个备用块一起readv
+    // 返回读取的字节数，-1表示错误
+    ssize_t readFd(int fd, int *savedErrno);
+
+    // writev写出尽量多的块并消费已写出的部分
+    // 返回写出的字节数，-1表示错误
+    ssize_t writeFd(int fd, int *savedErrno);
+
+    // 当前链上的块数
+    size_t numBlocks() const { return numBlocks_; }
+
+  private:
+    struct Block {
+        Block *next;
+        size_t readIndex;
+        size_t writeIndex;
+        char data[kBlockSize];
+
+        size_t readable() const { return writeIndex - readIndex; }
+        size_t writable() const { return kBlockSize - writeIndex; }
+    };
+
+    Block *newBlock();
+    void freeBlock(Block *block);
+    void releaseFreeList();
+    void pushBack(Block *block);
+    void clear();
+
+    Block *head_;
+    Block *tail_;
+    size_t numBlocks_;
+    size_t readable_;
+
+    Block *freeList_;
+    size_t numFree_;
+    // peek()合并跨块数据用的连续存储
+    std::string linear_;
+};
@@ -1,14 +1,28 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <sys/epoll.h>
 
 class EventLoop;
 
+/**
+ * 两种回调方式：
+ * - std::function：setXxxCallback，四个回调存在按需分配的一块内存里
+ * - 函数表：setEventHandlers，同类Channel共享一张静态表，owner作为参数传入，
+ *   每个Channel只占两个指针，连接这种数量巨大的对象用这种方式
+ */
 class Channel{
 public:
     using EventCallback = std::function<void()>;
 
+    struct EventHandlers {
+        void (*onRead)(void* owner);
+        void (*onWrite)(void* owner);
+        void (*onError)(void* owner);
+        void (*onClose)(void* owner);
+    };
+
     Channel(EventLoop* loop, int fd);
     ~Channel();
 
@@ -16,10 +30,16 @@ public:
     Channel(const Channel&) = delete;
     Channel& operator=(const Channel&) = delete;
 
-    void setReadCallback(EventCallback cb) {readCallback_ = std::move(cb);}
-    void setWriteCallback(EventCallback cb) {writeCallback_ = std::move(cb);}
-    void setErrorCallback(EventCallback cb) {errorCallback_ = std::move(cb);}
-    void setCloseCallback(EventCallback cb) {closeCallback_ = std::move(cb);}
+    void setReadCallback(EventCallback cb) {callbacks().read = std::move(cb);}
+    void setWriteCallback(EventCallback cb) {callbacks().write = std::move(cb);}
+    void setErrorCallback(EventCallback cb) {callbacks().error = std::move(cb);}
+    void setCloseCallback(EventCallback cb) {callbacks().close = std::move(cb);}
+
+    // handlers必须比Channel活得久（通常是静态常量），设置后std::function回调不再使用
+    void setEventHandlers(const EventHandlers* handlers, void* owner) {
+        handlers_ = handlers;
+        owner_ = owner;
+    }
 
     int fd() const {return fd_;}
 
@@ -27,6 +47,7 @@ public:
 
     // 发生过的事件
     void setRevents(uint32_t revents) {revents_ = revents;}
+    uint32_t revents() const {return revents_;}
 
     void handleEvent();
 
@@ -51,27 +72,95 @@ public:
     }
 
     void disableAll() {
-        events_ = 0;
+        events_ &= kModeFlags;
         update();
     }
 
-    bool isNoneEvent() const {return events_ == 0;}
+    // 边缘触发：只设置标志，随下一次enable*一起注册
+    void setEdgeTriggered(bool on) {
+        if (on) {
+            events_ |= EPOLLET;
+        } else {
+            events_ &= ~EPOLLET;
+        }
+    }
+
+    // 一次注册读写两个事件，边缘触发模式下整个生命期只需要这一次
+    void enableReadingAndWriting() {
+        events_ |= EPOLLIN | EPOLLOUT;
+        update();
+    }
+
+    // EPOLLEXCLUSIVE：同一个fd加入多个epoll时每次只唤醒其中一个（或几个），
+    // 用于多个loop共享一个监听socket。只在注册时生效，之后不能再修改关注的事件；
+    // io_uring后端忽略这个标志
+    void setExclusive(bool on) {
+        if (on) {
+            events_ |= EPOLLEXCLUSIVE;
+        } else {
+            events_ &= ~EPOLLEXCLUSIVE;
+        }
+    }
+
+    // 不关注读写时仍保持注册以收到EPOLLERR（poller总会报告错误，这里只防止被删除），
+    // 用于MSG_ZEROCOPY完成通知这类只经错误队列送达的事件。
+    // 已经关注读写时只设置标志，不需要系统调用
+    void enableErrors() {
+        bool registered = !isNoneEvent();
+        events_ |= EPOLLERR;
+        if (!registered) {
+            update();
+        }
+    }
+
+    void disableErrors() {
+        events_ &= ~EPOLLERR;
+        if (isNoneEvent()) {
+            update();
+        }
+    }
+
+    bool isEdgeTriggered() const {return events_ & EPOLLET;}
+
+    bool isExclusive() const {return events_ & EPOLLEXCLUSIVE;}
+
+    bool isNoneEvent() const {return (events_ & ~kModeFlags) == 0;}
+
+    bool isReading() const {return events_ & EPOLLIN;}
 
     bool isWriting() const {return events_ & EPOLLOUT;}
 
+    bool isWatchingErrors() const {return events_ & EPOLLERR;}
+
     void remove();
 
 
 private:
+    // 注册方式而不是关注的事件，disableAll后保留
+    static const uint32_t kModeFlags = EPOLLET | EPOLLEXCLUSIVE;
+
+    struct Callbacks {
+        EventCallback read;
+        EventCallback write;
+        EventCallback error;
+        EventCallback close;
+    };
+
     void update();
+    Callbacks& callbacks() {
+        if (!callbacks_) {
+            callbacks_.reset(new Callbacks);
+        }
+        return *callbacks_;
+    }
+    void handleEventWithCallbacks();
 
     EventLoop* loop_;
     const int fd_;
     uint32_t events_;
     uint32_t revents_; //发生的事件
 
-    EventCallback readCallback_;
-    EventCallback writeCallback_;
-    EventCallback errorCallback_;
-    EventCallback closeCallback_;
+    const EventHandlers* handlers_;
+    void* owner_;
+    std::unique_ptr<Callbacks> callbacks_;
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Poller.h"
+#include <sys/epoll.h>
+
+class EpollPoller : public Poller {
+  public:
+    explicit EpollPoller(EventLoop *loop);
+    ~EpollPoller() override;
+
+    int poll(int timeoutMs, ChannelList *activeChannels) override;
+    void updateChannel(Channel *channel) override;
+    void removeChannel(Channel *channel) override;
+
+    const char *name() const override { return "epoll"; }
+
+    size_t eventBatchSize() const override { return events_.size(); }
+
+  private:
+    // 以fd为下标的注册表，fd由内核从小到大复用，表是稠密的
+    using ChannelTable = std::vector<Channel *>;
+
+    bool registered(int fd, const Channel *channel) const {
+        return static_cast<size_t>(fd) < channels_.size() &&
+               channels_[fd] == channel;
+    }
+
+    // 事件数组装满则翻倍；连续多次不足四分之一则减半
+    void adjustEventBatch(int numEvents);
+
+    int epollfd_;
+    std::vector<struct epoll_event> events_;
+    ChannelTable channels_;
+    int underfilledPolls_;
+
+    static const size_t kInitEventListSize = 16;
+    static const size_t kMaxEventListSize = 4096;
+    static const int kShrinkAfterPolls = 64;
+};
@@ -1,15 +1,38 @@
 #pragma once
 
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
 #include <vector>
-#include <map>
-#include <sys/epoll.h>
+#include "LoopStats.h"
+#include "MpscQueue.h"
+#include "Poller.h"
+#include "Timer.h"
 
 // 前向说明
+class BufferPool;
 class Channel;
+class TimerQueue;
+class TimingWheel;
 
 class EventLoop{
 public:
-    EventLoop();
+    using Functor = std::function<void()>;
+
+    // 挂在某一轮迭代上执行一次的回调（写合并、推迟的续读），侵入式，排队不分配内存
+    // 同一时刻只能在一个队列中
+    struct IterationHook {
+        using HookFunc = void (*)(IterationHook *);
+
+        HookFunc onRun = nullptr;
+        void *owner = nullptr;
+        bool queued = false;
+    };
+
+    explicit EventLoop(Poller::Type pollerType = Poller::kDefault);
     ~EventLoop();
 
     EventLoop(const EventLoop&) = delete;
@@ -18,23 +41,163 @@ public:
     // 开始循环
     void loop();
 
-    // 退出循环
+    // 退出循环，可在其他线程调用
     void quit();
 
+    // 在loop线程中执行cb：本线程直接调用，其他线程则入队并唤醒
+    void runInLoop(Functor cb);
+
+    // 入队，在下一次循环迭代末尾执行
+    void queueInLoop(Functor cb);
+
+    // 以下只能在loop线程调用，hook已在队列中时不重复加入
+    // 在本轮事件回调与pendingFunctors都执行完之后调用hook->onRun一次
+    void queueFlush(IterationHook *hook) { queueHook(&flushHooks_, hook); }
+    // 推迟到下一轮迭代，与下一轮的就绪事件一起处理；排队期间poll不阻塞
+    void queueNextIteration(IterationHook *hook) {
+        queueHook(&deferredHooks_, hook);
+    }
+    // hook的所有者析构前必须移出队列
+    void cancelHook(IterationHook *hook);
+
+    // 混合自旋模式：最近一次有事件或任务后的budget时间内用零超时poll自旋，
+    // 超过预算再退回阻塞等待。0关闭（默认），线程安全
+    void setSpinBudget(std::chrono::microseconds budget) {
+        spinBudgetNs_.store(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(budget)
+                .count(),
+            std::memory_order_relaxed);
+    }
+
+    // 把loop线程绑定到指定CPU，只能在loop线程调用（例如ThreadInitCallback）
+    bool setCpuAffinity(int cpu);
+
+    // 定时器，线程安全；回调在loop线程执行
+    TimerId runAt(TimePoint time, TimerCallback cb);
+    TimerId runAfter(double delaySeconds, TimerCallback cb);
+    TimerId runEvery(double intervalSeconds, TimerCallback cb);
+    void cancel(TimerId timerId);
+
+    // 本loop上连接的Buffer内存池，只能在loop线程分配/归还
+    BufferPool* bufferPool() const { return bufferPool_.get(); }
+
+    // 空闲连接超时用的时间轮，第一次使用时创建；只能在loop线程调用
+    TimingWheel* idleWheel();
+
     void updateChannel(Channel* channel);
 
     void removeChannel(Channel* channel);
 
+    const char* pollerName() const { return poller_->name(); }
+
+    // 多路复用相关系统调用次数，只能在loop线程读取
+    uint64_t pollerSyscalls() const { return poller_->numSyscalls(); }
+
+    // poll()唤醒次数、返回的事件总数和当前事件数组大小，只能在loop线程读取
+    uint64_t pollerWakeups() const { return poller_->numWakeups(); }
+    uint64_t pollerEvents() const { return poller_->numEvents(); }
+    uint64_t pollerFullBatches() const { return poller_->numFullBatches(); }
+    size_t pollerBatchSize() const { return poller_->eventBatchSize(); }
+
+    // 运行统计快照，任意线程可调用；HPN_LOOP_STATS关闭时全为0
+    LoopStats::Snapshot stats() const {
+#if HPN_LOOP_STATS
+        return stats_.snapshot();
+#else
+        return LoopStats::Snapshot();
+#endif
+    }
+
+    // 单个回调超过阈值视为慢回调，线程安全；0关闭
+    void setSlowCallbackThreshold(std::chrono::microseconds threshold) {
+#if HPN_LOOP_STATS
+        stats_.setSlowCallbackThreshold(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(threshold)
+                .count());
+#else
+        (void)threshold;
+#endif
+    }
+
+    // 慢回调通知(fd, 纳秒)，只能在loop线程设置
+    void setSlowCallbackHandler(LoopStats::SlowCallbackHandler handler) {
+#if HPN_LOOP_STATS
+        stats_.setSlowCallbackHandler(std::move(handler));
+#else
+        (void)handler;
+#endif
+    }
+
+    bool isInLoopThread() const {
+        return threadId_ == std::this_thread::get_id();
+    }
+
+    // 负载统计，供EventLoopThreadPool选择子循环（跨线程读取）
+    size_t numConnections() const {
+        return numConnections_.load(std::memory_order_relaxed);
+    }
+
+    size_t pendingOutputBytes() const {
+        return pendingOutputBytes_.load(std::memory_order_relaxed);
+    }
+
+    void addConnections(long delta) {
+        numConnections_.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    void addPendingOutputBytes(long delta) {
+        pendingOutputBytes_.fetch_add(delta, std::memory_order_relaxed);
+    }
+
 private:
-    using ChannelMap = std::map<int, Channel*>;
+    void wakeup();
+    void handleWakeup();
+    size_t doPendingFunctors();
+    void queueHook(std::vector<IterationHook *> *list, IterationHook *hook) {
+        assert(isInLoopThread());
+        if (!hook->queued) {
+            hook->queued = true;
+            list->push_back(hook);
+        }
+    }
+    // 取走list中当前的hook逐个执行，执行期间新加入的留到下一次
+    size_t runHooks(std::vector<IterationHook *> *list);
+    // 本轮poll的超时：自旋预算内为0，否则-1
+    int pollTimeout();
 
     bool looping_;
-    bool quit_;
-    int epollfd_;
+    std::atomic<bool> quit_;
+    std::atomic<bool> callingPendingFunctors_;
+    // loop正在零超时自旋，其他线程投递任务时不必写eventfd
+    std::atomic<bool> spinning_;
+    std::atomic<int64_t> spinBudgetNs_;
+    int64_t lastBusyNs_;
+    const std::thread::id threadId_;
+    std::unique_ptr<Poller> poller_;
+    // 先于其他成员构造、后于它们析构
+    std::unique_ptr<BufferPool> bufferPool_;
+    Poller::ChannelList activeChannels_;
+
+    // eventfd，用于其他线程唤醒阻塞中的poll
+    int wakeupFd_;
+    std::unique_ptr<Channel> wakeupChannel_;
+
+    std::unique_ptr<TimerQueue> timerQueue_;
+    std::unique_ptr<TimingWheel> idleWheel_;
+
+
+    // 其他线程投递的任务，每轮迭代整体取走一次
+    MpscQueue<Functor> pendingFunctors_;
+    std::vector<IterationHook *> flushHooks_;
+    std::vector<IterationHook *> deferredHooks_;
+    // 正在执行的一批，与上面两个队列交换，避免分配
+    std::vector<IterationHook *> runningHooks_;
 
-    std::vector<struct epoll_event> events_;
-    ChannelMap channels_;
+    std::atomic<size_t> numConnections_;
+    std::atomic<size_t> pendingOutputBytes_;
 
-    static const int kMaxEvents = 16;
+#if HPN_LOOP_STATS
+    LoopStats stats_;
+#endif
 
-};
\ No newline at end of file
+};
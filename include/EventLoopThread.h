@@ -0,0 +1,38 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class EventLoop;
+
+/**
+ * one loop per thread
+ * - 在新线程的栈上创建EventLoop并运行loop()
+ * - startLoop() 阻塞到子线程的EventLoop创建完成
+ * - 析构时quit并join
+ */
+class EventLoopThread {
+  public:
+    using ThreadInitCallback = std::function<void(EventLoop *)>;
+
+    explicit EventLoopThread(ThreadInitCallback cb = ThreadInitCallback());
+    ~EventLoopThread();
+
+    EventLoopThread(const EventLoopThread &) = delete;
+    EventLoopThread &operator=(const EventLoopThread &) = delete;
+
+    EventLoop *startLoop();
+
+  private:
+    void threadFunc();
+
+    EventLoop *loop_;
+    bool exiting_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    ThreadInitCallback callback_;
+};
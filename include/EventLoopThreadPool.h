@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class EventLoop;
+class EventLoopThread;
+
+/**
+ * 多Reactor线程池
+ * - baseLoop 负责accept，子循环负责连接的读写
+ * - numThreads 为0时所有连接都留在baseLoop
+ * - 新连接分发到哪个子循环由可替换的策略决定
+ */
+class EventLoopThreadPool {
+  public:
+    using ThreadInitCallback = std::function<void(EventLoop *)>;
+    // 自定义分发策略：在子循环中挑选一个
+    using LoopSelector =
+        std::function<EventLoop *(const std::vector<EventLoop *> &)>;
+
+    enum Distribution {
+        kRoundRobin,        // 轮询
+        kLeastConnections,  // 当前连接数最少
+        kLeastPendingBytes, // 输出缓冲区积压字节最少
+    };
+
+    explicit EventLoopThreadPool(EventLoop *baseLoop);
+    ~EventLoopThreadPool();
+
+    EventLoopThreadPool(const EventLoopThreadPool &) = delete;
+    EventLoopThreadPool &operator=(const EventLoopThreadPool &) = delete;
+
+    void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+    void setDistribution(Distribution d) { distribution_ = d; }
+    void setLoopSelector(LoopSelector selector) {
+        selector_ = std::move(selector);
+    }
+
+    // 子循环的自旋预算，见EventLoop::setSpinBudget；start()之前调用
+    void setSpinBudget(std::chrono::microseconds budget) {
+        spinBudget_ = budget;
+    }
+    // 第i个子循环绑定到cpus[i % cpus.size()]；没有子线程时绑定baseLoop
+    void setCpuAffinity(std::vector<int> cpus) { cpus_ = std::move(cpus); }
+
+    void start(const ThreadInitCallback &cb = ThreadInitCallback());
+
+    // 只能在baseLoop线程调用
+    EventLoop *getNextLoop();
+
+    std::vector<EventLoop *> getAllLoops() const;
+
+    bool started() const { return started_; }
+
+  private:
+    EventLoop *baseLoop_;
+    bool started_;
+    int numThreads_;
+    size_t next_;
+    Distribution distribution_;
+    LoopSelector selector_;
+    std::chrono::microseconds spinBudget_;
+    std::vector<int> cpus_;
+    std::vector<std::unique_ptr<EventLoopThread>> threads_;
+    std::vector<EventLoop *> loops_;
+};
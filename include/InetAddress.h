@@ -7,6 +7,7 @@ class InetAddress {
 public:
     explicit InetAddress(uint16_t port = 0, bool loopbackOnly = false);
     InetAddress(const std::string& ip, uint16_t port);
+    explicit InetAddress(const struct sockaddr_in& addr): addr_(addr) {}
 
     const sockaddr* getSockAddr() const;
     std::string toIp() const;
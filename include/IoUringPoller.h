@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Poller.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * 基于 io_uring 的 Poller
+ * - 使用一次性 IORING_OP_POLL_ADD，触发后重新提交，保持水平触发语义
+ * - EPOLLET的Channel改用多次触发的poll（IORING_POLL_ADD_MULTI，边缘触发），
+ *   内核结束多次触发时（CQE没有IORING_CQE_F_MORE）再重新提交
+ * - 关注事件的增删改只是往SQ里写SQE，不产生系统调用；
+ *   所有SQE在下一次 poll() 中随等待一起用一次 io_uring_enter 提交
+ * - user_data = (generation << 32) | fd，修改/删除后旧请求的完成事件按代数丢弃
+ * 直接使用系统调用，不依赖liburing
+ */
+class IoUringPoller : public Poller {
+  public:
+    explicit IoUringPoller(EventLoop *loop, unsigned entries = kDefaultEntries);
+    ~IoUringPoller() override;
+
+    // io_uring_setup 失败（内核不支持或被禁用）时返回false
+    bool valid() const { return ringFd_ >= 0; }
+
+    int poll(int timeoutMs, ChannelList *activeChannels) override;
+    void updateChannel(Channel *channel) override;
+    void removeChannel(Channel *channel) override;
+
+    const char *name() const override { return "io_uring"; }
+
+    // CQ环的容量
+    size_t eventBatchSize() const override { return cqMask_ + 1; }
+
+  private:
+    static const unsigned kDefaultEntries = 4096;
+
+    struct FdState {
+        Channel *channel = nullptr;
+        uint32_t events = 0;     // 已提交的poll关注的事件
+        uint32_t generation = 0; // 每次修改/删除递增
+        bool armed = false;      // 是否有未完成的poll请求
+        bool multishot = false;  // 边缘触发
+        uint64_t activeEpoch = 0; // 最近一次出现在活跃列表中的poll轮次
+    };
+
+    FdState &stateOf(int fd);
+    void arm(int fd, FdState &state);
+    void disarm(int fd, FdState &state);
+
+    io_uring_sqe *getSqe();
+    int submitAndWait(unsigned waitNr, int timeoutMs);
+
+    int ringFd_;
+
+    // SQ
+    void *sqRing_;
+    size_t sqRingSize_;
+    unsigned *sqHead_;
+    unsigned *sqTail_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned *sqArray_;
+    io_uring_sqe *sqes_;
+    size_t sqesSize_;
+    unsigned sqeTail_;      // 本地已填写的SQE
+    unsigned sqeSubmitted_; // 已发布给内核的SQE
+
+    // CQ
+    void *cqRing_;
+    size_t cqRingSize_;
+    unsigned *cqHead_;
+    unsigned *cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe *cqes_;
+
+    uint64_t pollEpoch_;
+    std::vector<FdState> fds_;
+};
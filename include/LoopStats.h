@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// 编译期开关：CMake选项 HPN_LOOP_STATS=OFF 时 EventLoop 不做任何计时
+#ifndef HPN_LOOP_STATS
+#define HPN_LOOP_STATS 1
+#endif
+
+/**
+ * 按2的幂分桶的直方图
+ * - 第i个桶统计 [2^i, 2^(i+1)) 的样本，0计入第0个桶
+ * - 只有loop线程写，用relaxed的load+store代替fetch_add，没有锁也没有RMW
+ * - 其他线程随时可以读，读到的各字段之间可能相差几个样本
+ */
+class LogHistogram {
+  public:
+    static const int kBuckets = 64;
+
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+        uint64_t buckets[kBuckets] = {};
+
+        double mean() const {
+            return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+        }
+        // 返回p分位所在桶的上界，p取值(0, 1]
+        uint64_t percentile(double p) const;
+    };
+
+    LogHistogram();
+
+    LogHistogram(const LogHistogram &) = delete;
+    LogHistogram &operator=(const LogHistogram &) = delete;
+
+    // 只能在写线程调用
+    void record(uint64_t value) {
+        int bucket = value == 0 ? 0 : 63 - __builtin_clzll(value);
+        bump(buckets_[bucket], 1);
+        bump(count_, 1);
+        bump(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    // 任意线程
+    Snapshot snapshot() const;
+
+  private:
+    static void bump(std::atomic<uint64_t> &counter, uint64_t delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + delta,
+                      std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> buckets_[kBuckets];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
+
+/**
+ * EventLoop 的运行统计
+ * - 每轮迭代：等待时间（poll阻塞）与处理时间（回调+pendingFunctors）
+ * - 每个Channel回调的耗时，每轮就绪的事件数
+ * - 超过阈值的慢回调：计数、最近一次的fd和耗时，可选的通知回调
+ * 由loop线程写入，snapshot()可以在任意线程调用
+ */
+class LoopStats {
+  public:
+    // 慢回调通知，在loop线程中调用
+    using SlowCallbackHandler = std::function<void(int fd, uint64_t nanos)>;
+
+    struct Snapshot {
+        uint64_t iterations = 0;
+        uint64_t slowCallbacks = 0;
+        int lastSlowFd = -1;
+        uint64_t lastSlowNanos = 0;
+
+        LogHistogram::Snapshot waitNanos;
+        LogHistogram::Snapshot processNanos;
+        LogHistogram::Snapshot callbackNanos;
+        LogHistogram::Snapshot eventsPerIteration;
+    };
+
+    static const int64_t kDefaultSlowCallbackNanos = 10 * 1000 * 1000;
+
+    LoopStats();
+
+    LoopStats(const LoopStats &) = delete;
+    LoopStats &operator=(const LoopStats &) = delete;
+
+    void recordIteration(int64_t waitNanos, int64_t processNanos,
+                         int numEvents) {
+        wait_.record(static_cast<uint64_t>(waitNanos));
+        process_.record(static_cast<uint64_t>(processNanos));
+        events_.record(static_cast<uint64_t>(numEvents));
+        iterations_.store(iterations_.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+    }
+
+    void recordCallback(int fd, int64_t nanos) {
+        callback_.record(static_cast<uint64_t>(nanos));
+        if (nanos >= slowThresholdNanos_.load(std::memory_order_relaxed)) {
+            onSlowCallback(fd, nanos);
+        }
+    }
+
+    // 阈值线程安全，<=0 关闭慢回调检测
+    void setSlowCallbackThreshold(int64_t nanos) {
+        slowThresholdNanos_.store(nanos > 0 ? nanos : INT64_MAX,
+                                  std::memory_order_relaxed);
+    }
+    // 只能在loop线程设置；不设置时写一条日志
+    void setSlowCallbackHandler(SlowCallbackHandler handler) {
+        slowHandler_ = std::move(handler);
+    }
+
+    Snapshot snapshot() const;
+
+  private:
+    void onSlowCallback(int fd, int64_t nanos);
+
+    LogHistogram wait_;
+    LogHistogram process_;
+    LogHistogram callback_;
+    LogHistogram events_;
+    std::atomic<uint64_t> iterations_;
+
+    std::atomic<int64_t> slowThresholdNanos_;
+    std::atomic<uint64_t> slowCallbacks_;
+    std::atomic<int> lastSlowFd_;
+    std::atomic<uint64_t> lastSlowNanos_;
+    SlowCallbackHandler slowHandler_;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+/**
+ * 无锁多生产者单消费者队列
+ * - 生产者：一次CAS把节点压到栈顶
+ * - 消费者：一次exchange取走整条链表，反转后按入队顺序处理
+ * 适合EventLoop这种"其他线程投递，loop线程每轮批量取走"的场景
+ */
+template <typename T>
+class MpscQueue {
+  public:
+    MpscQueue() : head_(nullptr) {}
+
+    ~MpscQueue() {
+        Node *node = head_.exchange(nullptr, std::memory_order_acquire);
+        while (node != nullptr) {
+            Node *next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // 返回入队前队列是否为空，调用方据此决定是否需要唤醒消费者
+    bool push(T value) {
+        Node *node = new Node(std::move(value));
+        Node *old = head_.load(std::memory_order_relaxed);
+        do {
+            node->next = old;
+        } while (!head_.compare_exchange_weak(old, node,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+        return old == nullptr;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == nullptr;
+    }
+
+    // 只能由消费者线程调用；取走当前所有元素，按FIFO顺序交给f
+    template <typename F>
+    size_t consumeAll(F &&f) {
+        Node *node = head_.exchange(nullptr, std::memory_order_acquire);
+
+        // 栈是LIFO，反转成入队顺序
+        Node *reversed = nullptr;
+        while (node != nullptr) {
+            Node *next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+
+        size_t count = 0;
+        while (reversed != nullptr) {
+            Node *next = reversed->next;
+            f(reversed->value);
+            delete reversed;
+            reversed = next;
+            ++count;
+        }
+        return count;
+    }
+
+  private:
+    struct Node {
+        explicit Node(T v) : value(std::move(v)), next(nullptr) {}
+        T value;
+        Node *next;
+    };
+
+    std::atomic<Node *> head_;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Channel;
+class EventLoop;
+
+/**
+ * IO多路复用抽象
+ * - EventLoop 只通过 Poller 与内核交互
+ * - poll() 返回活跃的 Channel，revents 已经设置好
+ * - 统计多路复用相关的系统调用次数，便于对比不同后端
+ * 只能在loop线程调用
+ */
+class Poller {
+  public:
+    using ChannelList = std::vector<Channel *>;
+
+    enum Type {
+        kDefault, // 读取环境变量 HPN_POLLER=epoll|io_uring，缺省为epoll
+        kEpoll,
+        kIoUring,
+    };
+
+    explicit Poller(EventLoop *loop)
+        : ownerLoop_(loop), numSyscalls_(0), numWakeups_(0), numEvents_(0),
+          numFullBatches_(0) {}
+    virtual ~Poller() = default;
+
+    Poller(const Poller &) = delete;
+    Poller &operator=(const Poller &) = delete;
+
+    // timeoutMs: -1 阻塞，0 立即返回
+    virtual int poll(int timeoutMs, ChannelList *activeChannels) = 0;
+
+    virtual void updateChannel(Channel *channel) = 0;
+    virtual void removeChannel(Channel *channel) = 0;
+
+    virtual const char *name() const = 0;
+
+    // epoll_wait/epoll_ctl 或 io_uring_enter 的调用次数
+    uint64_t numSyscalls() const { return numSyscalls_; }
+
+    // poll()返回次数与返回的就绪事件总数，二者相除即每次唤醒的事件数
+    uint64_t numWakeups() const { return numWakeups_; }
+    uint64_t numEvents() const { return numEvents_; }
+
+    // 事件数组被填满的次数，说明一次poll没能取完就绪事件
+    uint64_t numFullBatches() const { return numFullBatches_; }
+
+    // 一次poll最多能返回的事件数
+    virtual size_t eventBatchSize() const = 0;
+
+    // 按类型创建，io_uring不可用时退回epoll
+    static Poller *newPoller(EventLoop *loop, Type type);
+
+  protected:
+    void recordWakeup(int numEvents) {
+        ++numWakeups_;
+        numEvents_ += static_cast<uint64_t>(numEvents);
+        if (static_cast<size_t>(numEvents) >= eventBatchSize()) {
+            ++numFullBatches_;
+        }
+    }
+
+    EventLoop *ownerLoop_;
+    uint64_t numSyscalls_;
+    uint64_t numWakeups_;
+    uint64_t numEvents_;
+    uint64_t numFullBatches_;
+};
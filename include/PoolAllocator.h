@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * 定长对象的内存池，给连接这类数量巨大、大小固定的对象用
+ * - 按块向系统申请，每块容纳kObjectsPerSlab个对象，对象之间没有malloc的头部开销
+ * - 归还的对象进侵入式空闲链表，LIFO复用
+ * - 线程安全：连接在baseLoop线程创建，最后一个引用可能在任意线程释放；
+ *   分配频率与建连频率相同，一把锁足够
+ * - 块只在进程退出时释放，占用由连接数峰值决定
+ * 每个大小一个实例，通过PoolAllocator使用
+ */
+class FixedSizePool {
+  public:
+    static const size_t kObjectsPerSlab = 256;
+
+    explicit FixedSizePool(size_t objectSize)
+        : objectSize_(roundUp(objectSize)), freeList_(nullptr), inUse_(0) {}
+    ~FixedSizePool() {
+        for (char *slab : slabs_) {
+            ::operator delete(slab);
+        }
+    }
+
+    FixedSizePool(const FixedSizePool &) = delete;
+    FixedSizePool &operator=(const FixedSizePool &) = delete;
+
+    void *allocate() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (freeList_ == nullptr) {
+            grow();
+        }
+        FreeNode *node = freeList_;
+        freeList_ = node->next;
+        ++inUse_;
+        return node;
+    }
+
+    void deallocate(void *p) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        FreeNode *node = static_cast<FreeNode *>(p);
+        node->next = freeList_;
+        freeList_ = node;
+        --inUse_;
+    }
+
+    size_t objectSize() const { return objectSize_; }
+    size_t inUse() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inUse_;
+    }
+    size_t reservedBytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return slabs_.size() * kObjectsPerSlab * objectSize_;
+    }
+
+  private:
+    struct FreeNode {
+        FreeNode *next;
+    };
+
+    static size_t roundUp(size_t size) {
+        const size_t align = alignof(std::max_align_t);
+        size = size < sizeof(FreeNode) ? sizeof(FreeNode) : size;
+        return (size + align - 1) / align * align;
+    }
+
+    void grow() {
+        char *slab =
+            static_cast<char *>(::operator new(objectSize_ * kObjectsPerSlab));
+        slabs_.push_back(slab);
+        // 倒序链入，分配顺序与地址顺序一致
+        for (size_t i = kObjectsPerSlab; i > 0; --i) {
+            FreeNode *node =
+                reinterpret_cast<FreeNode *>(slab + (i - 1) * objectSize_);
+            node->next = freeList_;
+            freeList_ = node;
+        }
+    }
+
+    const size_t objectSize_;
+    mutable std::mutex mutex_;
+    FreeNode *freeList_;
+    size_t inUse_;
+    std::vector<char *> slabs_;
+};
+
+// 无状态分配器，同一类型共享一个进程级的池；只有单个对象从池分配
+// 用于std::allocate_shared时，控制块和对象在同一个池块里
+template <typename T> class PoolAllocator {
+  public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template <typename U> PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+    static FixedSizePool &pool() {
+        // 故意不析构：全局对象析构顺序不定，进程退出时可能仍有对象未归还
+        static FixedSizePool *instance = new FixedSizePool(sizeof(T));
+        return *instance;
+    }
+
+    T *allocate(size_t n) {
+        if (n != 1) {
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T *>(pool().allocate());
+    }
+
+    void deallocate(T *p, size_t n) noexcept {
+        if (n != 1) {
+            ::operator delete(p);
+            return;
+        }
+        pool().deallocate(p);
+    }
+
+    template <typename U> bool operator==(const PoolAllocator<U> &) const {
+        return true;
+    }
+    template <typename U> bool operator!=(const PoolAllocator<U> &) const {
+        return false;
+    }
+};
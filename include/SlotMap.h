@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 带代数的槽表：O(1)插入、查找、删除，键在元素删除后失效
+ * - 键 = (generation << 32) | 槽下标；槽的generation插入和删除时各加一，
+ *   奇数表示占用，旧键的generation对不上，查找返回nullptr，不会误指向复用的槽
+ * - 元素连续存放在values_中，删除时把最后一个元素挪到空位，遍历只看有效元素
+ * - 空槽串成空闲链表，LIFO复用
+ * 不加锁，由使用者保证线程安全
+ */
+template <typename T> class SlotMap {
+  public:
+    using Key = uint64_t;
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    // 合法的键generation为奇数，0永远无效
+    static const Key kInvalidKey = 0;
+
+    SlotMap() : freeHead_(kNone) {}
+
+    SlotMap(const SlotMap &) = delete;
+    SlotMap &operator=(const SlotMap &) = delete;
+
+    Key insert(T value) {
+        uint32_t index;
+        if (freeHead_ != kNone) {
+            index = freeHead_;
+            freeHead_ = slots_[index].position;
+        } else {
+            assert(slots_.size() < kNone);
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.push_back(Slot{0, 0});
+        }
+        Slot &slot = slots_[index];
+        ++slot.generation;
+        slot.position = static_cast<uint32_t>(values_.size());
+        values_.push_back(std::move(value));
+        owners_.push_back(index);
+        return makeKey(slot.generation, index);
+    }
+
+    T *find(Key key) {
+        const Slot *slot = lookup(key);
+        return slot == nullptr ? nullptr : &values_[slot->position];
+    }
+    const T *find(Key key) const {
+        const Slot *slot = lookup(key);
+        return slot == nullptr ? nullptr : &values_[slot->position];
+    }
+
+    bool erase(Key key) {
+        if (lookup(key) == nullptr) {
+            return false;
+        }
+        uint32_t index = indexOf(key);
+        Slot &slot = slots_[index];
+        uint32_t position = slot.position;
+        uint32_t last = static_cast<uint32_t>(values_.size() - 1);
+        if (position != last) {
+            values_[position] = std::move(values_[last]);
+            owners_[position] = owners_[last];
+            slots_[owners_[position]].position = position;
+        }
+        values_.pop_back();
+        owners_.pop_back();
+
+        ++slot.generation;
+        slot.position = freeHead_;
+        freeHead_ = index;
+        return true;
+    }
+
+    // 已有的槽保留，之前的键全部失效
+    void clear() {
+        while (!values_.empty()) {
+            uint32_t index = owners_.back();
+            erase(makeKey(slots_[index].generation, index));
+        }
+    }
+
+    size_t size() const { return values_.size(); }
+    bool empty() const { return values_.empty(); }
+
+    // 遍历期间不能插入或删除
+    iterator begin() { return values_.begin(); }
+    iterator end() { return values_.end(); }
+    const_iterator begin() const { return values_.begin(); }
+    const_iterator end() const { return values_.end(); }
+
+    static uint32_t indexOf(Key key) { return static_cast<uint32_t>(key); }
+    static uint32_t generationOf(Key key) {
+        return static_cast<uint32_t>(key >> 32);
+    }
+
+  private:
+    static const uint32_t kNone = UINT32_MAX;
+
+    struct Slot {
+        uint32_t generation; // 奇数表示占用
+        uint32_t position;   // 占用时是values_的下标，空闲时是下一个空槽
+    };
+
+    static Key makeKey(uint32_t generation, uint32_t index) {
+        return (static_cast<Key>(generation) << 32) | index;
+    }
+
+    const Slot *lookup(Key key) const {
+        uint32_t index = indexOf(key);
+        uint32_t generation = generationOf(key);
+        if (index >= slots_.size() || (generation & 1) == 0 ||
+            slots_[index].generation != generation) {
+            return nullptr;
+        }
+        return &slots_[index];
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<T> values_;
+    // owners_[i]是values_[i]所在的槽，删除时挪动最后一个元素要用
+    std::vector<uint32_t> owners_;
+    uint32_t freeHead_;
+};
@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 
+class InetAddress;
+
 class Socket {
 public:
     static std::optional<Socket> createTCP();
@@ -24,6 +26,8 @@ public:
 
     bool bind(uint16_t port_);
 
+    bool bind(const InetAddress& addr);
+
     bool listen(int backlog =128);
 
     std::optional<Socket> accept();
@@ -32,6 +36,43 @@ public:
 
     bool setReuseAddr();
 
+    // SO_REUSEPORT：多个socket绑定同一端口，内核按四元组哈希把新连接分给各个监听socket
+    bool setReusePort(bool on);
+
+    // SO_BUSY_POLL：阻塞读/poll时在设备队列上忙等usec微秒，
+    // 超过 net.core.busy_read 需要CAP_NET_ADMIN
+    bool setBusyPoll(int usec);
+
+    // SO_ZEROCOPY：允许sendmsg使用MSG_ZEROCOPY，内核4.14起支持TCP
+    bool setZeroCopy(bool on);
+
+    // TCP_NODELAY：关闭Nagle算法，小包不等前一个包的ACK
+    bool setTcpNoDelay(bool on);
+
+    // SO_SNDBUF/SO_RCVBUF：设置后内核不再自动调整这个方向的缓冲区，
+    // 上限为 net.core.wmem_max/rmem_max；接收缓冲区要在listen之前设置才影响窗口缩放
+    bool setSendBufferSize(int bytes);
+    bool setRecvBufferSize(int bytes);
+
+    // SO_KEEPALIVE 以及 TCP_KEEPIDLE/TCP_KEEPINTVL/TCP_KEEPCNT（秒、秒、次数），
+    // 关闭时忽略后三个参数
+    bool setKeepAlive(bool on, int idleSeconds = 0, int intervalSeconds = 0,
+                      int probes = 0);
+
+    // TCP_NOTSENT_LOWAT：未发送的数据超过bytes时socket不再可写，
+    // 数据留在用户态缓冲区，后写入的数据不必排在内核里的长队列后面
+    bool setNotSentLowat(int bytes);
+
+    // TCP_DEFER_ACCEPT：收到第一个数据包才让accept返回，最多等seconds秒，只用于监听socket
+    bool setDeferAccept(int seconds);
+
+    // TCP_FASTOPEN：允许SYN携带数据，queueLength为等待三次握手完成的TFO请求上限，
+    // 只用于监听socket，还需要 net.ipv4.tcp_fastopen 打开服务端
+    bool setFastOpen(int queueLength);
+
+    // TCP_QUICKACK：立即回复ACK，不等延迟确认；内核之后可能自行退出quickack模式
+    bool setQuickAck(bool on);
+
     int fd() const {return fd_; }
 
     bool isValid() const { return fd_ >= 0; }
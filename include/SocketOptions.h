@@ -0,0 +1,44 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+class Socket;
+
+/**
+ * SocketOptions 一组socket选项，TcpServer对监听socket和每个新连接应用
+ * - 没有设置的项不改动，保持系统默认值
+ * - 监听socket：TCP_DEFER_ACCEPT、TCP_FASTOPEN，以及缓冲区大小
+ *   （接收缓冲区在listen之前设置，SYN里通告的窗口缩放因子才按它计算）
+ * - 每个连接：其余各项在accept之后设置
+ * 两个预设：
+ * - lowLatency()：小请求一问一答的RPC，关闭Nagle、立即ACK、限制内核里未发送的数据
+ * - bulkTransfer()：大块数据传输，保留Nagle攒满报文段、固定大缓冲区
+ */
+struct SocketOptions {
+    struct KeepAlive {
+        int idleSeconds;     // 空闲多久开始探测
+        int intervalSeconds; // 探测间隔
+        int probes;          // 连续多少次无响应后断开
+    };
+
+    // 每个连接
+    std::optional<bool> noDelay;          // TCP_NODELAY
+    std::optional<bool> quickAck;         // TCP_QUICKACK，只影响连接开始阶段
+    std::optional<int> sendBufferBytes;   // SO_SNDBUF，同时设置在监听socket上
+    std::optional<int> recvBufferBytes;   // SO_RCVBUF，同时设置在监听socket上
+    std::optional<KeepAlive> keepAlive;   // SO_KEEPALIVE及探测参数
+    std::optional<int> notSentLowatBytes; // TCP_NOTSENT_LOWAT
+
+    // 只用于监听socket
+    std::optional<int> deferAcceptSeconds; // TCP_DEFER_ACCEPT，客户端先发数据的协议才能用
+    std::optional<int> fastOpenQueue;      // TCP_FASTOPEN
+
+    static SocketOptions lowLatency();
+    static SocketOptions bulkTransfer();
+
+    // 设置失败的项记录日志并继续设置其余各项，有失败时返回false；
+    // name用于日志，例如连接名
+    bool applyToListener(Socket &socket, const std::string &name) const;
+    bool applyToConnection(Socket &socket, const std::string &name) const;
+};
@@ -2,11 +2,17 @@
 
 #include "Buffer.h"
 #include "Channel.h"
+#include "EventLoop.h"
 #include "Socket.h"
+#include "TimingWheel.h"
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <memory>
-
-class EventLoop;
+#include <string>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <variant>
 
 /**
  * TCP 设计
@@ -15,6 +21,15 @@ class EventLoop;
  * - 管理读写缓冲区
  * - 提供高层回调接口
  * - 使用 shared_ptr 管理生命期
+ * - 输出：先尝试直接写，写不完的部分才进入输出队列
+ *   写合并模式下不直接写，本轮迭代末尾把积压一次writev出去
+ * - 输入：可设每轮迭代的读预算，预算用完或回调deferRead()时续读推迟到下一轮，
+ *   一个灌数据的连接不会拖住同一loop上的其他连接
+ * - 内存：大量空闲连接时每个连接只占一个池块（对象+shared_ptr控制块）
+ *   Channel内嵌并用共享的函数表分发；回调由TcpServer所有连接共享一份；
+ *   缓冲区和输出队列在有数据时才分配
+ *   拷贝来的数据进outputBuffer_；移交所有权的string/Buffer、共享负载和文件区间
+ *   按引用排在后面的outputQueue_中，内存数据用writev一起写出，文件用sendfile
  *
  */
 class TcpConnection : public std::enable_shared_from_this<TcpConnection> {
@@ -24,25 +39,120 @@ class TcpConnection : public std::enable_shared_from_this<TcpConnection> {
     using MessageCallback =
         std::function<void(const TcpConnectionPtr &, Buffer *)>;
     using CloseCallback = std::function<void(const TcpConnectionPtr &)>;
+    using WriteCompleteCallback = std::function<void(const TcpConnectionPtr &)>;
+    // 第二个参数是越过水位线时积压的字节数
+    using HighWaterMarkCallback =
+        std::function<void(const TcpConnectionPtr &, size_t)>;
+    // 不可变的共享负载，广播给多个连接时只有一份数据
+    using SharedPayload = std::shared_ptr<const std::string>;
+    // TcpServer连接表中的位置，带代数，连接移除后旧id不会指向新连接
+    using ConnectionId = uint64_t;
+    static const ConnectionId kInvalidId = 0;
+
+    // writev一次最多提交的分段数
+    static const int kMaxIovecs = 64;
+    // 零拷贝发送的默认最小分段
+    static const size_t kDefaultZeroCopyThreshold = 64 * 1024;
+    // 默认高水位线
+    static const size_t kDefaultHighWaterMark = 64 * 1024 * 1024;
 
     enum State { kConnecting, kConnected, kDisconnecting, kDisconnected };
 
-    TcpConnection(EventLoop *loop, Socket &&socket);
+    // 一组连接共用的回调，TcpServer所有连接共享一份，不在每个连接里复制
+    struct Callbacks {
+        ConnectionCallback connection;
+        MessageCallback message;
+        CloseCallback close;
+        WriteCompleteCallback writeComplete;
+        HighWaterMarkCallback highWaterMark;
+    };
+    using CallbacksPtr = std::shared_ptr<const Callbacks>;
+
+    TcpConnection(EventLoop *loop, Socket &&socket,
+                  const std::string &name = std::string());
     ~TcpConnection();
 
+    // 从进程级的定长池分配，对象和控制块在同一个池块里
+    static TcpConnectionPtr create(EventLoop *loop, Socket &&socket,
+                                   const std::string &name = std::string());
+
     // 删除拷贝构造函数和拷贝赋值运算符
     TcpConnection(const TcpConnection &) = delete;
     TcpConnection &operator=(const TcpConnection &) = delete;
 
+    // 整组替换为共享的回调，在connectEstablished之前或loop线程中设置
+    void setCallbacks(CallbacksPtr callbacks) {
+        callbacks_ = std::move(callbacks);
+        ownsCallbacks_ = false;
+    }
+
+    // 单独设置某个回调：第一次时把共享的回调复制一份归本连接所有
     void setConnectionCallback(ConnectionCallback cb) {
-        connectionCallback_ = std::move(cb);
+        ownCallbacks().connection = std::move(cb);
     }
 
     void setMessageCallback(MessageCallback cb) {
-        messageCallback_ = std::move(cb);
+        ownCallbacks().message = std::move(cb);
+    }
+
+    void setCloseCallback(CloseCallback cb) {
+        ownCallbacks().close = std::move(cb);
+    }
+
+    // 输出积压全部交给内核后回调（包括直接写完的send），在loop线程中排队执行
+    void setWriteCompleteCallback(WriteCompleteCallback cb) {
+        ownCallbacks().writeComplete = std::move(cb);
+    }
+
+    // 积压从低于bytes变为不低于bytes时回调一次，在loop线程中排队执行
+    // 典型用法：代理在下游越过水位线时对上游stopRead()，下游写完后startRead()
+    void setHighWaterMarkCallback(HighWaterMarkCallback cb, size_t bytes) {
+        ownCallbacks().highWaterMark = std::move(cb);
+        highWaterMark_ = bytes;
     }
+    // 只改水位，回调来自setCallbacks
+    void setHighWaterMark(size_t bytes) { highWaterMark_ = bytes; }
 
-    void setCloseCallback(CloseCallback cb) { closeCallback_ = std::move(cb); }
+    // 积压越过高水位线时自动暂停读本连接，降到一半以下时恢复；
+    // 对端只发不收时内存仍然有上界。需要先设置setHighWaterMarkCallback的水位
+    void setPauseReadOnHighWaterMark(bool on) { pauseReadOnHighWater_ = on; }
+
+    // 边缘触发模式，必须在connectEstablished之前设置
+    // - 读写都循环到EAGAIN为止
+    // - EPOLLOUT常驻，不再随输出缓冲区空/非空切换
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    bool edgeTriggered() const { return edgeTriggered_; }
+
+    // 写合并：一轮迭代内的多次send只排队，迭代末尾合成一次writev（通常一次系统调用）
+    // 代价是数据先拷进输出缓冲区、延迟到本轮回调全部结束；适合一条消息分多次send
+    // msgMore：一次写不完全部积压（后面是文件区间或超过kMaxIovecs段）时带MSG_MORE，
+    //   内核把这一段与紧接着的写凑成满的报文段，效果同TCP_CORK但不需要额外的setsockopt
+    // 在connectEstablished之前或loop线程中设置
+    void setWriteCoalescing(bool on, bool msgMore = false) {
+        coalesceWrites_ = on;
+        msgMore_ = msgMore;
+    }
+    bool writeCoalescing() const { return coalesceWrites_; }
+
+    // 读预算：每轮迭代本连接最多从socket读bytes字节，0表示不限制（默认）
+    // - 水平触发只读一次，本来就让出了loop，预算只是把这一次读的量变小
+    // - 边缘触发预算用完时还没读到EAGAIN，续读推迟到下一轮迭代
+    // - 只限制每轮读的量，不限制输入缓冲区里未消费的数据，比预算大的消息
+    //   分几轮读完；需要反压时用stopRead()
+    // 在connectEstablished之前或loop线程中设置
+    void setReadBudget(size_t bytes) { readBudget_ = bytes; }
+    size_t readBudget() const { return readBudget_; }
+
+    // 只能在消息回调中调用：本轮不再处理，输入缓冲区里剩下的数据在下一轮迭代
+    // 再回调一次（即使没有新数据到达）。用于按消息数限制每轮的处理量：
+    // 回调解出N条消息后deferRead()返回，其余连接的事件先得到处理
+    void deferRead() {
+        readDeferred_ = true;
+        loop_->queueNextIteration(&readHook_);
+    }
+
+    // 线程安全
+    void setTcpNoDelay(bool on) { socket_.setTcpNoDelay(on); }
 
     // TcpServer调用，标记连接已建立
     void connectEstablished();
@@ -50,36 +160,265 @@ class TcpConnection : public std::enable_shared_from_this<TcpConnection> {
     // TcpServer调用，连接销毁前的清理
     void connectDestroyed();
 
+    // 以下send都是线程安全的，数据按调用顺序发出
+    // 拷贝发送：loop线程内直接写socket，只有写不完的部分拷进输出缓冲区；
+    // 非loop线程调用时拷贝一次后投递到loop线程
     void send(const std::string &message);
     void send(const char *data, size_t len);
+    // 移交所有权，写不完时整个string进入输出队列，不拷贝
+    void send(std::string &&message);
+    // 发送buf中的全部可读数据，返回后buf为空
+    // loop线程内：输出空闲时与输出缓冲区交换，否则整体移入输出队列；
+    // buf来自其他loop的BufferPool，或在非loop线程调用时拷贝
+    void send(Buffer *buf);
+    // 聚集写，写不完的部分拷贝
+    void sendv(const struct iovec *iov, int iovcnt);
+    // 共享负载按引用排队，写不完时只多一个引用计数
+    void send(const SharedPayload &payload);
+    // 用sendfile发送文件[offset, offset + len)，数据不经过用户态
+    // 内部dup一份fd，调用方可以立即关闭自己的fd；不改变fd的文件偏移
+    // 发送途中文件被截短时丢弃剩余部分并记录错误
+    void sendFile(int fd, off_t offset, size_t len);
 
+    // 线程安全
     void shutdown();
 
+    // 暂停/恢复读取，线程安全；暂停期间内核接收缓冲区写满后对端会被TCP流控阻塞
+    void stopRead();
+    void startRead();
+    // 只能在loop线程读取：当前是否在读（用户暂停或积压暂停时为false）
+    bool isReading() const { return channel_.isReading(); }
+
+    // MSG_ZEROCOPY发送，线程安全
+    // 只对输出队列中不小于minBytes的分段（移交的string/Buffer、共享负载）生效，
+    // 这些分段在内核的完成通知到达前不会释放；拷贝进输出缓冲区的小数据照常发送
+    // 内核不支持时记录错误并保持关闭
+    void setZeroCopy(bool on, size_t minBytes = kDefaultZeroCopyThreshold);
+    bool zeroCopy() const { return zeroCopy_; }
+    // 只能在loop线程读取：零拷贝发送次数，以及其中内核仍然做了拷贝的次数
+    // （回环或网卡不支持时内核会退回拷贝）
+    uint64_t zeroCopySends() const { return zeroCopySends_; }
+    uint64_t zeroCopyCopiedSends() const { return zeroCopyCopied_; }
+
+    // 空闲超时：seconds内没有读写活动则关闭连接，0表示关闭此功能
+    // 线程安全；活动刷新只是一次内存写，不涉及定时器操作
+    void setIdleTimeout(double seconds);
+
     State state() const { return state_; }
     bool connected() const { return state_ == kConnected; }
 
     EventLoop *getLoop() const { return loop_; }
+    const std::string &name() const { return name_; }
+    // 用于getsockopt等查询，不要关闭或改变阻塞模式
+    int fd() const { return socket_.fd(); }
+    // 由TcpServer在加入连接表时设置，不属于任何TcpServer时为kInvalidId
+    ConnectionId id() const { return id_; }
+    void setId(ConnectionId id) { id_ = id; }
 
   private:
+    // 第一次push才分配的deque：libstdc++的deque默认构造就要分配约600字节，
+    // 输出队列只在写阻塞时使用，变空后立即释放
+    template <typename T> class LazyDeque {
+      public:
+        using iterator = typename std::deque<T>::iterator;
+
+        bool empty() const { return !items_ || items_->empty(); }
+        T &front() { return items_->front(); }
+        const T &front() const { return items_->front(); }
+        T &back() { return items_->back(); }
+        void push_back(T &&item) {
+            if (!items_) {
+                items_.reset(new std::deque<T>);
+            }
+            items_->push_back(std::move(item));
+        }
+        void pop_front() {
+            items_->pop_front();
+            if (items_->empty()) {
+                items_.reset();
+            }
+        }
+        void clear() { items_.reset(); }
+        iterator begin() { return items_ ? items_->begin() : none().begin(); }
+        iterator end() { return items_ ? items_->end() : none().end(); }
+
+      private:
+        // 未分配时迭代用的空deque，只读
+        static std::deque<T> &none() {
+            static std::deque<T> empty;
+            return empty;
+        }
+
+        std::unique_ptr<std::deque<T>> items_;
+    };
+
+    static const Channel::EventHandlers kChannelHandlers;
+
+    Callbacks &ownCallbacks();
+
     void handleRead();
+    // deferred为true时即使没有读到新数据也回调（deferRead推迟的输入）
+    void handleReadEdgeTriggered(bool deferred = false);
+    // 推迟的续读，下一轮迭代由EventLoop调用
+    static void handleDeferredRead(EventLoop::IterationHook *hook);
+    void resumeRead();
+    size_t readLimit() const {
+        return readBudget_ > 0 ? readBudget_ : SIZE_MAX;
+    }
     void handleWrite();
+    // 写积压：drain为true时一直写到EAGAIN或写完，否则只写一次
+    void writeBacklog(bool drain);
+    // 写合并模式下每轮迭代末尾由EventLoop调用
+    static void handleFlush(EventLoop::IterationHook *hook);
+    void flushOutput();
     void handleClose();
     void handleError();
+    // EPOLLERR：零拷贝的完成通知也通过错误队列到达，不一定是连接出错
+    void handleErrorEvent();
+
+    void touchIdle() {
+        if (idleWheel_ != nullptr) {
+            idleWheel_->touch(&idleEntry_);
+        }
+    }
+    void setIdleTimeoutInLoop(double seconds);
+    static void handleIdleTimeout(TimingWheel::Entry *entry);
+
+    // sendFile排队的文件区间，持有dup出来的fd
+    class FileRange {
+      public:
+        FileRange(int fd, off_t offset, size_t len)
+            : fd_(fd), offset_(offset), len_(len) {}
+        ~FileRange();
+        FileRange(FileRange &&other) noexcept
+            : fd_(other.fd_), offset_(other.offset_), len_(other.len_) {
+            other.fd_ = -1;
+        }
+        FileRange &operator=(FileRange &&other) noexcept;
+        FileRange(const FileRange &) = delete;
+        FileRange &operator=(const FileRange &) = delete;
+
+        int fd() const { return fd_; }
+        off_t offset() const { return offset_; }
+        size_t len() const { return len_; }
+
+      private:
+        int fd_;
+        off_t offset_;
+        size_t len_;
+    };
+
+    // 输出队列中按引用保存的一段数据，offset之前的部分已经写出
+    struct OutputChunk {
+        std::variant<std::string, SharedPayload, Buffer, FileRange> data;
+        size_t offset;
+        // 以MSG_ZEROCOPY发出的序号区间[zeroCopyFirst, zeroCopyFirst + zeroCopySends)，
+        // 部分写时同一分段会占用多个连续序号；zeroCopyPending是其中还没完成的个数
+        uint32_t zeroCopyFirst = 0;
+        uint32_t zeroCopySends = 0;
+        uint32_t zeroCopyPending = 0;
+
+        bool isFile() const { return std::holds_alternative<FileRange>(data); }
+        // 文件区间没有内存地址，返回nullptr
+        const char *begin() const;
+        size_t size() const;
+    };
 
-    void sendInLoop(const std::string &message);
+    // 输出缓冲区或输出队列中是否还有待发送的数据
+    bool outputPending() const {
+        return outputBuffer_.readableBytes() > 0 || !outputQueue_.empty();
+    }
+    size_t pendingBytes() const {
+        return outputBuffer_.readableBytes() + queuedBytes_;
+    }
+
+    void sendInLoop(const char *data, size_t len);
+    void sendInLoop(std::string &&message);
+    void sendInLoop(Buffer *buf);
+    void sendInLoop(const struct iovec *iov, int iovcnt);
+    void sendInLoop(const SharedPayload &payload);
+    void sendFileInLoop(FileRange &&file);
+    // 写一次积压的数据：队头是文件时sendfile，否则writev到下一个文件区间为止
+    // 返回写出的字节数，-1表示错误
+    ssize_t writeOutput();
+    // 队头文件被截短，丢弃剩余部分
+    void dropTruncatedFile();
+
+    void setZeroCopyInLoop(bool on, size_t minBytes);
+    bool useZeroCopy(size_t len) const {
+        return zeroCopy_ && len >= zeroCopyThreshold_;
+    }
+    // 队头分段足够大时用MSG_ZEROCOPY发出，返回false表示应走普通写
+    bool writeZeroCopy(ssize_t *nwrote);
+    // 从错误队列读取完成通知，释放内核不再引用的分段
+    void readZeroCopyCompletions();
+    // 序号区间[first, last]的发送已完成，计入覆盖到的分段
+    void completeZeroCopy(uint32_t first, uint32_t last);
+    // 没有积压时直接写，返回写出的字节数；出错时已关闭连接并返回-1
+    ssize_t writeDirect(const char *data, size_t len);
+    ssize_t writeDirect(const struct iovec *iov, int iovcnt);
+    // 有积压或写合并时不能直接写，写合并时顺便排上本轮的flush
+    bool canWriteDirect();
+    // 直接写的结果：EAGAIN/EINTR算写了0字节，其他错误关闭连接
+    ssize_t directWritten(ssize_t nwrote);
+    // 写不完的数据排在已有积压之后
+    void queueCopy(const char *data, size_t len);
+    void queueChunk(OutputChunk &&chunk);
+    void notePending(size_t len);
+    // 积压全部写出，或直接写完了本次发送
+    void writeComplete();
+    // 积压减少后检查是否可以恢复读取
+    void checkLowWaterMark();
+    // 按用户意愿与积压暂停两者更新读事件
+    void updateReading();
+    // 消费输出缓冲区和输出队列头部已写出的n字节
+    void consumeOutput(size_t n);
     void shutdownInLoop();
     void setState(State s) { state_ = s; }
 
+    // 标志放在一起，减少对齐填充
     EventLoop *loop_;
+    const std::string name_;
+    ConnectionId id_;
     Socket socket_;
-    std::unique_ptr<Channel> channel_;
-
-    State state_;
+    std::atomic<State> state_;
+    bool edgeTriggered_;
+    bool coalesceWrites_;
+    bool msgMore_;
+    bool zeroCopy_;
+    // 用户调用stopRead后为false
+    bool readWanted_;
+    // 回调调用了deferRead，输入缓冲区里的数据要再回调一次
+    bool readDeferred_;
+    bool pauseReadOnHighWater_;
+    // 因积压超过高水位线而暂停读
+    bool outputPaused_;
+    // callbacks_是本连接独有的一份，可以原地修改
+    bool ownsCallbacks_;
+    // 下一次零拷贝发送的序号，放在这里补齐标志后面的空隙
+    uint32_t zeroCopyNextSeq_;
+    Channel channel_;
 
     Buffer inputBuffer_;
     Buffer outputBuffer_;
+    LazyDeque<OutputChunk> outputQueue_;
+    size_t queuedBytes_;
+
+    EventLoop::IterationHook flushHook_;
+
+    size_t readBudget_;
+    EventLoop::IterationHook readHook_;
+
+    size_t zeroCopyThreshold_;
+    // 已写完、等待内核完成通知的分段，按序号排列
+    LazyDeque<OutputChunk> zeroCopyInflight_;
+    uint64_t zeroCopySends_;
+    uint64_t zeroCopyCopied_;
+
+    size_t highWaterMark_;
+
+    TimingWheel *idleWheel_;
+    TimingWheel::Entry idleEntry_;
 
-    ConnectionCallback connectionCallback_;
-    MessageCallback messageCallback_;
-    CloseCallback closeCallback_;
+    CallbacksPtr callbacks_;
 };
\ No newline at end of file
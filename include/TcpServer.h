@@ -3,31 +3,169 @@
 #include "TcpConnection.h"
 #include "InetAddress.h"
 #include "Acceptor.h"
-#include <map>
+#include "EventLoopThreadPool.h"
+#include "SlotMap.h"
+#include "SocketOptions.h"
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 class EventLoop;
 
+/**
+ * TcpServer 设计
+ * - 默认baseLoop上的Acceptor负责接受新连接
+ * - setThreadNum(n) 后，新连接按分发策略交给n个子循环之一
+ * - kReusePort/kExclusive 模式下每个子循环有自己的Acceptor，
+ *   连接留在accept它的loop上，不经过baseLoop转交
+ * - 连接只在所属的loop线程中读写
+ */
 class TcpServer {
   public:
+    using TcpConnectionPtr = TcpConnection::TcpConnectionPtr;
+    using ConnectionCallback = TcpConnection::ConnectionCallback;
+    using MessageCallback = TcpConnection::MessageCallback;
+    using WriteCompleteCallback = TcpConnection::WriteCompleteCallback;
+    using HighWaterMarkCallback = TcpConnection::HighWaterMarkCallback;
+    using ThreadInitCallback = EventLoopThreadPool::ThreadInitCallback;
+    using ConnectionId = TcpConnection::ConnectionId;
+
+    enum ListenMode {
+        kSingleAcceptor, // baseLoop上一个Acceptor，新连接按分发策略转交（默认）
+        kReusePort,      // 每个子循环一个SO_REUSEPORT监听socket，内核分配连接
+        kExclusive,      // 每个子循环一个Acceptor共享监听socket，EPOLLEXCLUSIVE注册
+    };
+
     TcpServer(EventLoop *loop, const InetAddress &listenAddr);
+    ~TcpServer();
+
+    TcpServer(const TcpServer &) = delete;
+    TcpServer &operator=(const TcpServer &) = delete;
+
+    // 必须在start()之前调用；0表示所有连接都在baseLoop上处理
+    void setThreadNum(int numThreads);
+    void setDistribution(EventLoopThreadPool::Distribution d);
+    void setLoopSelector(EventLoopThreadPool::LoopSelector selector);
+    void setThreadInitCallback(const ThreadInitCallback &cb) {
+        threadInitCallback_ = cb;
+    }
+
+    // 必须在start()之前调用；没有子线程时三种模式都只有baseLoop一个Acceptor。
+    // 分发策略只对kSingleAcceptor有效
+    void setListenMode(ListenMode mode);
+
+    // 监听socket和所有新连接使用边缘触发，必须在start()之前调用
+    void setEdgeTriggered(bool on);
+
+    // 监听socket每次可读最多accept的连接数，见Acceptor，必须在start()之前调用
+    void setMaxAcceptsPerWakeup(int n);
+
+    // 新连接设置SO_BUSY_POLL（微秒），0表示不设置；配合
+    // threadPool()->setSpinBudget() 使用，必须在start()之前调用
+    void setBusyPoll(int usec);
+
+    // 新连接启用写合并，见TcpConnection::setWriteCoalescing，必须在start()之前调用
+    void setWriteCoalescing(bool on, bool msgMore = false);
+
+    // 监听socket和每个新连接的socket选项，例如SocketOptions::lowLatency()，
+    // 必须在start()之前调用
+    void setSocketOptions(const SocketOptions &opts);
+
     void start();
 
-    void setConnectionCallback(const ConnectionCallback &cb);
-    void setMessageCallback(const MessageCallback &cb);
-    void setWriteCompleteCallback(const WriteCompleteCallback &cb);
+    // 回调在所有连接间共享一份，修改后只对之后建立的连接生效；
+    // 不能与新连接建立并发修改
+    void setConnectionCallback(const ConnectionCallback &cb) {
+        connectionCallback_ = cb;
+        resetConnCallbacks();
+    }
+    void setMessageCallback(const MessageCallback &cb) {
+        messageCallback_ = cb;
+        resetConnCallbacks();
+    }
+    void setWriteCompleteCallback(const WriteCompleteCallback &cb) {
+        writeCompleteCallback_ = cb;
+        resetConnCallbacks();
+    }
+    void setHighWaterMarkCallback(const HighWaterMarkCallback &cb,
+                                  size_t bytes) {
+        highWaterMarkCallback_ = cb;
+        highWaterMark_ = bytes;
+        resetConnCallbacks();
+    }
+
+    EventLoop *getLoop() const { return loop_; }
+    EventLoopThreadPool *threadPool() const { return threadPool_.get(); }
+
+    // 按id查找连接，O(1)，线程安全。保存id而不是TcpConnectionPtr不会延长连接的生命期；
+    // 连接已经移除时返回空，id不会误指向之后复用同一位置的连接
+    TcpConnectionPtr getConnection(ConnectionId id) const;
+    // 当前连接数，线程安全
+    size_t numConnections() const;
 
   private:
-    void newConnection(int sockfd, const InetAddress &peerAddr);
+    // 一个接受新连接的loop：kSingleAcceptor只有baseLoop一个，其他模式每个子循环一个。
+    // connections只在loop线程中修改，kSingleAcceptor下连接表在baseLoop上；
+    // 修改和getConnection都持有mutex，其他线程查找不频繁，锁基本没有竞争
+    struct Shard {
+        EventLoop *loop;
+        uint32_t index;
+        std::unique_ptr<Acceptor> acceptor;
+        SlotMap<TcpConnectionPtr> connections;
+        mutable std::mutex mutex;
+    };
+
+    // ConnectionId = 槽的generation(32位) | 分片下标(8位) | 槽下标(24位)
+    static const int kShardShift = 24;
+    static const uint32_t kMaxShards = 256;
+    static const uint32_t kMaxSlotsPerShard = 1u << kShardShift;
+    static ConnectionId makeId(uint32_t shard, SlotMap<TcpConnectionPtr>::Key key);
+    static SlotMap<TcpConnectionPtr>::Key keyOf(ConnectionId id);
+    static uint32_t shardIndexOf(ConnectionId id) {
+        return static_cast<uint32_t>(id) >> kShardShift;
+    }
+
+    void createShards();
+    void newConnection(Shard *shard, int sockfd, const InetAddress &peerAddr);
     void removeConnection(const TcpConnectionPtr &conn);
+    void removeConnectionInLoop(Shard *shard, const TcpConnectionPtr &conn);
+    // 在shard的loop线程中调用：关闭Acceptor并销毁所有连接
+    static void destroyShard(Shard *shard);
+    // 在loop线程中执行cb并等待完成
+    static void runInLoopAndWait(EventLoop *loop,
+                                 const std::function<void()> &cb);
+    Shard *shardOf(ConnectionId id) const;
+    TcpConnection::CallbacksPtr connCallbacks();
+    void resetConnCallbacks() {
+        std::atomic_store(&connCallbacks_, TcpConnection::CallbacksPtr());
+    }
 
     EventLoop *loop_;
-    std::unique_ptr<Acceptor> acceptor_;
-    std::map<std::string, TcpConnectionPtr> connections_;
+    const InetAddress listenAddr_;
+    const std::string ipPort_;
+    std::unique_ptr<EventLoopThreadPool> threadPool_;
+    std::vector<std::unique_ptr<Shard>> shards_;
 
     ConnectionCallback connectionCallback_;
     MessageCallback messageCallback_;
     WriteCompleteCallback writeCompleteCallback_;
-    int nextConnId_;
-};
\ No newline at end of file
+    HighWaterMarkCallback highWaterMarkCallback_;
+    size_t highWaterMark_;
+    // 上面几个回调加上removeConnection，下一个新连接建立时生成；
+    // 分片模式下多个loop同时读取，用atomic_load/atomic_store访问
+    TcpConnection::CallbacksPtr connCallbacks_;
+    ThreadInitCallback threadInitCallback_;
+    ListenMode listenMode_;
+    bool started_;
+    bool edgeTriggered_;
+    int maxAcceptsPerWakeup_;
+    int busyPollUsec_;
+    bool coalesceWrites_;
+    bool msgMore_;
+    SocketOptions socketOptions_;
+    std::atomic<int> nextConnId_;
+    // 析构时释放，排队中的removeConnectionInLoop据此判断server是否还在
+    std::shared_ptr<void> alive_;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+using TimerCallback = std::function<void()>;
+
+// 定时器统一使用单调时钟，不受系统时间调整影响
+using TimerClock = std::chrono::steady_clock;
+using TimePoint = TimerClock::time_point;
+
+/**
+ * 定时器句柄
+ * - 高32位是槽位的代数，低32位是定时器在TimerQueue slab中的槽位，
+ *   取消时直接按槽位找到定时器，代数不符说明已经到期或取消、槽位已被复用
+ * - 代数从1开始，0表示无效句柄
+ * - 可以跨线程传递并用于 EventLoop::cancel
+ */
+class TimerId {
+  public:
+    TimerId() : value_(0) {}
+    TimerId(uint32_t slot, uint32_t generation)
+        : value_(static_cast<uint64_t>(generation) << 32 | slot) {}
+
+    uint32_t slot() const { return static_cast<uint32_t>(value_); }
+    uint32_t generation() const { return static_cast<uint32_t>(value_ >> 32); }
+    uint64_t value() const { return value_; }
+    bool valid() const { return generation() != 0; }
+
+  private:
+    uint64_t value_;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Channel.h"
+#include "Timer.h"
+#include <deque>
+#include <mutex>
+#include <vector>
+
+class EventLoop;
+
+/**
+ * 定时器队列
+ * - 每个EventLoop一个，通过一个timerfd Channel接入epoll
+ * - 4叉最小堆按到期时间排序，堆元素只有24字节，比二叉堆层数少一半
+ * - 定时器对象放在slab中（deque保证地址稳定，空闲槽位复用），
+ *   TimerId带槽位和代数，取消时按槽位直接找到，不需要额外的索引表
+ * - 槽位在调用addTimer的线程分配，句柄可以立即返回；空闲槽位表和代数
+ *   由一个互斥锁保护，只在分配和回收槽位时持有，基本没有竞争
+ * - 一次唤醒处理所有已到期的定时器
+ * - addTimer/cancel 线程安全，其余只能在loop线程调用
+ */
+class TimerQueue {
+  public:
+    explicit TimerQueue(EventLoop *loop);
+    ~TimerQueue();
+
+    TimerQueue(const TimerQueue &) = delete;
+    TimerQueue &operator=(const TimerQueue &) = delete;
+
+    // interval为0表示一次性定时器
+    TimerId addTimer(TimerCallback cb, TimePoint when,
+                     TimerClock::duration interval);
+
+    void cancel(TimerId timerId);
+
+    size_t size() const { return heap_.size(); }
+
+  private:
+    static const uint32_t kNoIndex = UINT32_MAX;
+
+    struct Timer {
+        TimerCallback callback;
+        int64_t interval = 0; // 纳秒，0表示不重复
+        uint64_t id = 0;      // 占用者的TimerId::value()，0表示空闲
+        uint32_t heapIndex = kNoIndex; // 在heap_中的位置，kNoIndex表示不在堆中
+        bool cancelled = false;
+    };
+
+    struct HeapEntry {
+        int64_t when;      // 纳秒，单调时钟
+        uint64_t sequence; // 入堆顺序，到期时间相同时先入堆的先执行
+        uint32_t slot;
+    };
+
+    static bool earlier(const HeapEntry &a, const HeapEntry &b) {
+        return a.when < b.when || (a.when == b.when && a.sequence < b.sequence);
+    }
+
+    void addTimerInLoop(TimerId id, TimerCallback cb, int64_t when,
+                        int64_t interval);
+    void cancelInLoop(TimerId id);
+    void handleRead();
+
+    // 任意线程调用，分配槽位并递增它的代数
+    TimerId allocSlot();
+    // loop线程调用，释放回调并把槽位还给空闲表
+    void freeSlot(uint32_t slot);
+
+    void heapPush(HeapEntry entry);
+    void heapRemove(uint32_t index);
+    void siftUp(uint32_t index);
+    void siftDown(uint32_t index);
+    void place(uint32_t index, const HeapEntry &entry);
+
+    // 把timerfd设置到堆顶的到期时间
+    void rearm();
+
+    EventLoop *loop_;
+    const int timerfd_;
+    Channel timerfdChannel_;
+
+    std::vector<HeapEntry> heap_;
+    // 只在loop线程访问；跨线程分配的槽位可能超出当前大小，加入时再扩展
+    std::deque<Timer> timers_;
+    uint64_t nextSequence_;
+
+    std::mutex slotMutex_;
+    std::vector<uint32_t> freeSlots_;   // slotMutex_保护
+    std::vector<uint32_t> generations_; // slotMutex_保护，每个分配过的槽位一个
+
+    std::vector<uint32_t> expired_;
+    bool callingExpiredTimers_;
+    int64_t armedAt_; // timerfd当前设置的到期时间，0表示未设置
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Timer.h"
+#include <cstdint>
+#include <vector>
+
+class EventLoop;
+
+/**
+ * 哈希时间轮，用于大量连接的空闲超时
+ * - 每个EventLoop一个，由一个runEvery定时器驱动，每tick处理一个槽；
+ *   定时器只在轮中有条目时存在，空轮不会周期性唤醒loop
+ * - 槽内是侵入式双向链表，add/remove O(1)，不分配内存
+ * - touch只记录最近活跃的tick，不移动链表节点；
+ *   槽到期时再检查，未超时的条目懒惰地挂到新的槽
+ * - 超时时间超过一圈时用rounds计数
+ * 只能在loop线程使用
+ */
+class TimingWheel {
+  public:
+    struct Entry {
+        using ExpireFunc = void (*)(Entry *);
+
+        Entry *prev = nullptr;
+        Entry *next = nullptr;
+        uint64_t lastActive = 0; // 最近一次活跃的tick
+        uint32_t timeout = 0;    // 超时tick数
+        uint32_t rounds = 0;     // 还需转过的圈数
+        uint32_t bucket = 0;     // 所在的槽
+        bool linked = false;
+
+        ExpireFunc onExpire = nullptr;
+        void *owner = nullptr;
+    };
+
+    static constexpr double kDefaultTickSeconds = 0.1;
+    static const size_t kDefaultBuckets = 512;
+
+    // loop为nullptr时不注册定时器，由调用方手动tick()
+    explicit TimingWheel(EventLoop *loop,
+                         double tickSeconds = kDefaultTickSeconds,
+                         size_t numBuckets = kDefaultBuckets);
+    ~TimingWheel();
+
+    TimingWheel(const TimingWheel &) = delete;
+    TimingWheel &operator=(const TimingWheel &) = delete;
+
+    // 加入时间轮，timeoutSeconds向上取整到tick
+    void add(Entry *entry, double timeoutSeconds);
+    void remove(Entry *entry);
+
+    // 热路径：一次写内存
+    void touch(Entry *entry) { entry->lastActive = currentTick_; }
+
+    uint64_t currentTick() const { return currentTick_; }
+    size_t size() const { return size_; }
+    bool ticking() const { return tickTimer_.valid(); }
+
+    // 前进一个tick并批量处理到期条目；一般由内部定时器调用
+    void tick();
+
+  private:
+    void link(Entry *entry, uint64_t deadline);
+    void unlink(Entry *entry);
+    // 空轮与非空轮之间切换时启停tick定时器
+    void startTicking();
+    void stopTicking();
+
+    EventLoop *loop_;
+    const double tickSeconds_;
+    std::vector<Entry *> buckets_;
+    uint64_t currentTick_;
+    size_t size_;
+    TimerId tickTimer_;
+    std::vector<Entry *> expired_;
+};
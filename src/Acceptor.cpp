@@ -1,29 +1,201 @@
 #include "Acceptor.h"
 #include "EventLoop.h"
 #include "Logger.h"
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
 #include <unistd.h>
 
-Acceptor::Acceptor(EventLoop *loop, const InetAddress &listenAddr):
-    loop_(loop), 
-    acceptSocket_(Socket::createTCP().value()), 
-    acceptChannel_(loop, acceptSocket_.fd)()),
-    listening_(false){
+namespace {
+
+int openIdleFd() {
+    return ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+} // namespace
+
+Acceptor::Acceptor(EventLoop *loop, const InetAddress &listenAddr, bool reusePort):
+    Acceptor(loop, Socket::createTCP().value()){
     
     // 1. socket设置
     acceptSocket_.setReuseAddr();
     acceptSocket_.setNonBlocking();
+    if(reusePort && !acceptSocket_.setReusePort(true)){
+        LOG_ERROR("Acceptor SO_REUSEPORT failed: %s", acceptSocket_.getLastError().c_str());
+    }
 
     // 2.绑定地址
     if(!acceptSocket_.bind(listenAddr)){
-        LOG_ERROR("Acceptor bind failed");
+        LOG_ERROR("Acceptor bind failed: %s", acceptSocket_.getLastError().c_str());
     }
+}
+
+Acceptor::Acceptor(EventLoop *loop, Socket &&listenSocket):
+    loop_(loop), 
+    acceptSocket_(std::move(listenSocket)), 
+    acceptChannel_(loop, acceptSocket_.fd()),
+    idleFd_(openIdleFd()),
+    maxAccepts_(kDefaultMaxAcceptsPerWakeup),
+    accepted_(0),
+    dropped_(0),
+    droppedBefore_(0),
+    exhausted_(false),
+    paused_(false),
+    listening_(false),
+    edgeTriggered_(false),
+    exclusive_(false){
 
-    // 3. 设置Channel的读回调
+    // 设置Channel的读回调
     acceptChannel_.setReadCallback([this](){
         handleRead();
     });
+
+    acceptHook_.onRun = &Acceptor::handleDeferredAccept;
+    acceptHook_.owner = this;
+}
+
+Acceptor::~Acceptor(){
+    loop_->cancelHook(&acceptHook_);
+    if(paused_){
+        loop_->cancel(retryTimer_);
+    }
+    acceptChannel_.disableAll();
+    acceptChannel_.remove();
+    if(idleFd_ >= 0){
+        ::close(idleFd_);
+    }
 }
 
 void Acceptor::setNewConnectionCallback(NewConnectionCallback cb){
-    
+    newConnectionCallback_ = std::move(cb);
+}
+
+void Acceptor::listen(){
+    assert(loop_->isInLoopThread());
+    listening_ = true;
+    if(!acceptSocket_.listen(SOMAXCONN)){
+        LOG_ERROR("Acceptor listen failed: %s", acceptSocket_.getLastError().c_str());
+    }
+    acceptChannel_.setEdgeTriggered(edgeTriggered_);
+    acceptChannel_.setExclusive(exclusive_);
+    acceptChannel_.enableReading();
+}
+
+bool Acceptor::listening() const{
+    return listening_;
+}
+
+void Acceptor::handleRead(){
+    // 水平触发时没accept完的下一轮poll还会报告；
+    // 边缘触发时没有新的边沿，用完预算后自己排到下一轮
+    for(int i = 0; i < maxAccepts_; ++i){
+        struct sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+
+        int connfd = ::accept4(acceptSocket_.fd(), (struct sockaddr*)&addr, &len,
+                               SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(connfd < 0){
+            int err = errno;
+            switch(err){
+            case EAGAIN:
+                return;
+            case EINTR:
+            // 对端在accept之前已经放弃，换下一个
+            case ECONNABORTED:
+            case EPROTO:
+                continue;
+            case EMFILE:
+            case ENFILE:
+                if(dropOneConnection()){
+                    continue;
+                }
+                if(idleFd_ < 0){
+                    pauseAccepting();
+                } else {
+                    retryNextIteration();
+                }
+                return;
+            default:
+                // ENOBUFS/ENOMEM等，这一轮放弃，下一轮再试
+                LOG_ERROR("Acceptor accept failed: %s", strerror(err));
+                retryNextIteration();
+                return;
+            }
+        }
+
+        if(exhausted_){
+            exhausted_ = false;
+            LOG_ERROR("Acceptor fds available again, dropped %llu connections",
+                      static_cast<unsigned long long>(dropped_ - droppedBefore_));
+        }
+        ++accepted_;
+        InetAddress peerAddr(addr);
+        if(newConnectionCallback_){
+            newConnectionCallback_(connfd, peerAddr);
+        } else {
+            ::close(connfd);
+        }
+    }
+
+    retryNextIteration();
+}
+
+void Acceptor::retryNextIteration(){
+    // 水平触发时backlog非空下一轮poll还会报告；边缘触发不会再有新的边沿，
+    // 除了EAGAIN之外提前返回都要自己排到下一轮，否则监听socket再也不会被处理
+    if(edgeTriggered_){
+        loop_->queueNextIteration(&acceptHook_);
+    }
+}
+
+void Acceptor::pauseAccepting(){
+    // 继续关注可读的话，水平触发下监听socket一直就绪，边缘触发下每轮重排，
+    // 都会变成零超时的忙循环
+    loop_->cancelHook(&acceptHook_);
+    acceptChannel_.disableReading();
+    paused_ = true;
+    retryTimer_ = loop_->runAfter(kIdleFdRetrySeconds, [this](){
+        retryIdleFd();
+    });
+}
+
+void Acceptor::retryIdleFd(){
+    idleFd_ = openIdleFd();
+    if(idleFd_ < 0){
+        retryTimer_ = loop_->runAfter(kIdleFdRetrySeconds, [this](){
+            retryIdleFd();
+        });
+        return;
+    }
+    paused_ = false;
+    acceptChannel_.enableReading();
+    // 重新注册时backlog里的连接不一定带来新的边沿
+    retryNextIteration();
+}
+
+void Acceptor::handleDeferredAccept(EventLoop::IterationHook *hook){
+    static_cast<Acceptor*>(hook->owner)->handleRead();
+}
+
+bool Acceptor::dropOneConnection(){
+    // 只在进入和离开fd耗尽状态时各记一条，连接风暴时不会刷屏
+    if(!exhausted_){
+        exhausted_ = true;
+        droppedBefore_ = dropped_;
+        LOG_ERROR("Acceptor out of fds, dropping new connections");
+    }
+    if(idleFd_ < 0){
+        // 上次没能重新打开，可能别处已经释放了fd
+        idleFd_ = openIdleFd();
+        return false;
+    }
+    ::close(idleFd_);
+    int connfd = ::accept4(acceptSocket_.fd(), nullptr, nullptr, SOCK_CLOEXEC);
+    if(connfd >= 0){
+        ::close(connfd);
+        ++dropped_;
+    }
+    idleFd_ = openIdleFd();
+    return connfd >= 0;
 }
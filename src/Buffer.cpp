@@ -1,31 +1,132 @@
 #include "Buffer.h"
 #include <errno.h>
+#include <memory>
 #include <sys/uio.h>
 #include <unistd.h>
 
-ssize_t Buffer::readFd(int fd, int* savedErrno){
-    char extrabuf[65536];
+namespace {
+
+// 溢出区每线程一块，第一次用到时分配；one loop per thread 下即每个loop一块
+thread_local std::unique_ptr<char[]> t_overflow;
+thread_local uint64_t t_overflowCopied = 0;
+
+char* overflowArea() {
+    if (!t_overflow) {
+        t_overflow.reset(new char[Buffer::kOverflowSize]);
+    }
+    return t_overflow.get();
+}
+
+} // namespace
+
+uint64_t Buffer::overflowCopiedBytes(){
+    return t_overflowCopied;
+}
+
+ssize_t Buffer::readFd(int fd, int* savedErrno, size_t maxBytes){
+    // 预留空间不足一半时才扩容，避免每次读都搬移
+    if (writableBytes() < readHint_ / 2) {
+        ensureWritableBytes(readHint_ - kCheapPrepend);
+    }
+
+    char* overflow = overflowArea();
     struct iovec vec[2];
 
-    const size_t writable = writableBytes();
+    const size_t writable = std::min(writableBytes(), maxBytes);
 
     vec[0].iov_base = begin() + writeIndex_;
     vec[0].iov_len = writable;
 
-    vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof extrabuf;
+    vec[1].iov_base = overflow;
+    vec[1].iov_len = std::min(kOverflowSize, maxBytes - writable);
 
-    const ssize_t n = ::readv(fd, vec, 2);
+    const ssize_t n = ::readv(fd, vec, vec[1].iov_len > 0 ? 2 : 1);
 
     if(n < 0){
         *savedErrno = errno;
-    } else if (static_cast<size_t>(n) <= writable) {
+        return n;
+    }
+
+    if (static_cast<size_t>(n) <= writable) {
         writeIndex_ += n;
     } else {
-        writeIndex_ = buffer_.size();
-        append(extrabuf, n - writable);
+        writeIndex_ += writable;
+        append(overflow, n - writable);
+        t_overflowCopied += n - writable;
+    }
+
+    // 填满预留空间说明还有更多数据，下次多留；连续几次读得很少再缩回
+    if (static_cast<size_t>(n) >= writable && n > 0) {
+        readHint_ = static_cast<uint32_t>(
+            std::min<size_t>(static_cast<size_t>(readHint_) * 2, kMaxReadHint));
+        smallReads_ = 0;
+    } else if (static_cast<size_t>(n) < readHint_ / 4) {
+        if (++smallReads_ >= 4) {
+            readHint_ = static_cast<uint32_t>(
+                std::max<size_t>(readHint_ / 2, kMinReadHint));
+            smallReads_ = 0;
+        }
+    } else {
+        smallReads_ = 0;
+    }
+
+    return n;
+
+}
+
+const char* Buffer::findCached(uint32_t key, std::string_view delim) const{
+    const size_t readable = readableBytes();
+    size_t start = scanKey_ == key ? std::min(scanned_, readable) : 0;
+    const char* found = ByteSearch::find(peek() + start, readable - start, delim);
+    scanKey_ = key;
+    if (found != nullptr) {
+        scanned_ = static_cast<size_t>(found - peek());
+    } else {
+        // 分隔符可能跨越数据末尾，最后delim.size()-1字节下次还要再看
+        scanned_ = readable >= delim.size() ? readable - delim.size() + 1 : 0;
     }
+    return found;
+}
 
+ssize_t Buffer::writeFd(int fd, int* savedErrno){
+    const ssize_t n = ::write(fd, peek(), readableBytes());
+    if (n < 0) {
+        *savedErrno = errno;
+    } else {
+        retrieve(n);
+    }
     return n;
+}
+
+void Buffer::shrinkAfterDrain(){
+    if (pool_ != nullptr) {
+        releaseStorage();
+    } else if (capacity_ > kMaxRetainedSize) {
+        BufferPool::deallocateUnpooled(data_);
+        capacity_ = kCheapPrepend + kInitialSize;
+        data_ = BufferPool::allocateUnpooled(capacity_);
+    }
+}
 
-}
\ No newline at end of file
+void Buffer::reallocate(size_t newCapacity){
+    const size_t readable = readableBytes();
+    char* newData;
+    if (pool_ != nullptr) {
+        newData = pool_->allocate(newCapacity, &newCapacity);
+    } else {
+        newData = BufferPool::allocateUnpooled(newCapacity);
+    }
+    memcpy(newData + kCheapPrepend, peek(), readable);
+
+    if (hasStorage()) {
+        if (pool_ != nullptr) {
+            pool_->deallocate(data_, capacity_);
+        } else {
+            BufferPool::deallocateUnpooled(data_);
+        }
+    }
+    data_ = newData;
+    capacity_ = newCapacity;
+    readIndex_ = kCheapPrepend;
+    writeIndex_ = kCheapPrepend + readable;
+}
@@ -0,0 +1,74 @@
+#include "BufferPool.h"
+#include <cassert>
+
+BufferPool::BufferPool() : inUseBytes_(0), cachedBytes_(0) {
+    for (int i = 0; i < kNumClasses; ++i) {
+        freeLists_[i] = nullptr;
+        cachedPerClass_[i] = 0;
+    }
+}
+
+BufferPool::~BufferPool() { trim(); }
+
+size_t BufferPool::roundUp(size_t size) {
+    if (size <= kMinBlockSize) {
+        return kMinBlockSize;
+    }
+    if (size > kMaxBlockSize) {
+        return size;
+    }
+    return size_t(1) << (64 - __builtin_clzll(size - 1));
+}
+
+int BufferPool::classOf(size_t capacity) {
+    if (capacity > kMaxBlockSize) {
+        return -1;
+    }
+    // capacity是2的幂，kMinBlockSize = 2^10
+    return 63 - __builtin_clzll(capacity) - 10;
+}
+
+char *BufferPool::allocate(size_t size, size_t *capacity) {
+    size_t rounded = roundUp(size);
+    *capacity = rounded;
+    inUseBytes_ += rounded;
+
+    int cls = classOf(rounded);
+    if (cls >= 0 && freeLists_[cls] != nullptr) {
+        FreeNode *node = freeLists_[cls];
+        freeLists_[cls] = node->next;
+        cachedPerClass_[cls] -= rounded;
+        cachedBytes_ -= rounded;
+        return reinterpret_cast<char *>(node);
+    }
+    return allocateUnpooled(rounded);
+}
+
+void BufferPool::deallocate(char *block, size_t capacity) {
+    assert(inUseBytes_ >= capacity);
+    inUseBytes_ -= capacity;
+
+    int cls = classOf(capacity);
+    if (cls < 0 || cachedPerClass_[cls] + capacity > kMaxCachedBytesPerClass) {
+        deallocateUnpooled(block);
+        return;
+    }
+
+    FreeNode *node = reinterpret_cast<FreeNode *>(block);
+    node->next = freeLists_[cls];
+    freeLists_[cls] = node;
+    cachedPerClass_[cls] += capacity;
+    cachedBytes_ += capacity;
+}
+
+void BufferPool::trim() {
+    for (int i = 0; i < kNumClasses; ++i) {
+        while (freeLists_[i] != nullptr) {
+            FreeNode *next = freeLists_[i]->next;
+            deallocateUnpooled(reinterpret_cast<char *>(freeLists_[i]));
+            freeLists_[i] = next;
+        }
+        cachedPerClass_[i] = 0;
+    }
+    cachedBytes_ = 0;
+}
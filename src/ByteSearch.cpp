@@ -0,0 +1,187 @@
+#include "ByteSearch.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HPN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// 标量实现：单字节用libc的memchr，子串用memchr找首字节再比较
+// 首字节很少出现时这种方式很快，但"\r\n"这类每行都出现的首字节会频繁进出memchr
+const char *findCharScalar(const char *data, size_t len, char c) {
+    return static_cast<const char *>(::memchr(data, c, len));
+}
+
+const char *findScalar(const char *data, size_t len, std::string_view needle) {
+    const size_t k = needle.size();
+    const char *p = data;
+    const char *end = data + len;
+    while (static_cast<size_t>(end - p) >= k) {
+        p = static_cast<const char *>(
+            ::memchr(p, needle[0], static_cast<size_t>(end - p) - k + 1));
+        if (p == nullptr) {
+            return nullptr;
+        }
+        if (::memcmp(p + 1, needle.data() + 1, k - 1) == 0) {
+            return p;
+        }
+        ++p;
+    }
+    return nullptr;
+}
+
+#ifdef HPN_X86
+
+// 向量部分之后剩下不足一个向量的尾部交给标量实现
+const char *findSse2(const char *data, size_t len, std::string_view needle) {
+    const size_t k = needle.size();
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[k - 1]);
+    size_t i = 0;
+    for (; i + k - 1 + 16 <= len; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i b = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(data + i + k - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask != 0) {
+            size_t pos = i + __builtin_ctz(mask);
+            if (k <= 2 ||
+                ::memcmp(data + pos + 1, needle.data() + 1, k - 2) == 0) {
+                return data + pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(data + i, len - i, needle);
+}
+
+// 首字节和末字节同时匹配的候选位置，逐个memcmp确认
+__attribute__((target("avx2"))) inline const char *
+verifyAvx2(const char *data, size_t offset, unsigned mask,
+           std::string_view needle) {
+    const size_t k = needle.size();
+    while (mask != 0) {
+        size_t pos = offset + __builtin_ctz(mask);
+        if (k <= 2 || ::memcmp(data + pos + 1, needle.data() + 1, k - 2) == 0) {
+            return data + pos;
+        }
+        mask &= mask - 1;
+    }
+    return nullptr;
+}
+
+__attribute__((target("avx2"))) inline __m256i
+candidatesAvx2(const char *p, size_t k, __m256i first, __m256i last) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + k - 1));
+    return _mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+                            _mm256_cmpeq_epi8(b, last));
+}
+
+__attribute__((target("avx2"))) const char *
+findAvx2(const char *data, size_t len, std::string_view needle) {
+    const size_t k = needle.size();
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[k - 1]);
+    size_t i = 0;
+    // 每轮2个向量，没有候选时只做一次判断
+    for (; i + k - 1 + 64 <= len; i += 64) {
+        __m256i c0 = candidatesAvx2(data + i, k, first, last);
+        __m256i c1 = candidatesAvx2(data + i + 32, k, first, last);
+        __m256i any = _mm256_or_si256(c0, c1);
+        if (_mm256_testz_si256(any, any)) {
+            continue;
+        }
+        const char *found = verifyAvx2(
+            data, i, static_cast<unsigned>(_mm256_movemask_epi8(c0)), needle);
+        if (found == nullptr) {
+            found = verifyAvx2(
+                data, i + 32, static_cast<unsigned>(_mm256_movemask_epi8(c1)),
+                needle);
+        }
+        if (found != nullptr) {
+            return found;
+        }
+    }
+    for (; i + k - 1 + 32 <= len; i += 32) {
+        __m256i c = candidatesAvx2(data + i, k, first, last);
+        const char *found = verifyAvx2(
+            data, i, static_cast<unsigned>(_mm256_movemask_epi8(c)), needle);
+        if (found != nullptr) {
+            return found;
+        }
+    }
+    return findSse2(data + i, len - i, needle);
+}
+
+#endif // HPN_X86
+
+std::atomic<int> g_level(ByteSearch::detect());
+
+} // namespace
+
+ByteSearch::Level ByteSearch::detect() {
+#ifdef HPN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return kAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return kSse2;
+    }
+#endif
+    return kScalar;
+}
+
+ByteSearch::Level ByteSearch::level() {
+    return static_cast<Level>(g_level.load(std::memory_order_relaxed));
+}
+
+const char *ByteSearch::levelName(Level level) {
+    switch (level) {
+    case kAvx2:
+        return "avx2";
+    case kSse2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+void ByteSearch::setLevel(Level level) {
+    g_level.store(std::min(level, detect()), std::memory_order_relaxed);
+}
+
+const char *ByteSearch::findChar(const char *data, size_t len, char c) {
+    // glibc的memchr本身按CPU选择了向量实现，并且做了循环展开，
+    // 单字节查找自己写的内核比不过它
+    return findCharScalar(data, len, c);
+}
+
+const char *ByteSearch::find(const char *data, size_t len,
+                             std::string_view needle) {
+    if (needle.empty()) {
+        return data;
+    }
+    if (needle.size() == 1) {
+        return findChar(data, len, needle[0]);
+    }
+    if (len < needle.size()) {
+        return nullptr;
+    }
+    switch (level()) {
+#ifdef HPN_X86
+    case kAvx2:
+        return findAvx2(data, len, needle);
+    case kSse2:
+        return findSse2(data, len, needle);
+#endif
+    default:
+        return findScalar(data, len, needle);
+    }
+}
@@ -0,0 +1,247 @@
+#include "ChainBuffer.h"
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+ChainBuffer::ChainBuffer()
+    : head_(nullptr), tail_(nullptr), numBlocks_(0), readable_(0),
+      freeList_(nullptr), numFree_(0) {}
+
+ChainBuffer::~ChainBuffer() {
+    clear();
+    releaseFreeList();
+}
+
+ChainBuffer::ChainBuffer(ChainBuffer &&other) noexcept
+    : head_(other.head_), tail_(other.tail_), numBlocks_(other.numBlocks_),
+      readable_(other.readable_), freeList_(other.freeList_),
+      numFree_(other.numFree_), linear_(std::move(other.linear_)) {
+    other.head_ = other.tail_ = other.freeList_ = nullptr;
+    other.numBlocks_ = other.readable_ = other.numFree_ = 0;
+}
+
+ChainBuffer &ChainBuffer::operator=(ChainBuffer &&other) noexcept {
+    if (this != &other) {
+        clear();
+        releaseFreeList();
+        head_ = other.head_;
+        tail_ = other.tail_;
+        numBlocks_ = other.numBlocks_;
+        readable_ = other.readable_;
+        freeList_ = other.freeList_;
+        numFree_ = other.numFree_;
+        linear_ = std::move(other.linear_);
+        other.head_ = other.tail_ = other.freeList_ = nullptr;
+        other.numBlocks_ = other.readable_ = other.numFree_ = 0;
+    }
+    return *this;
+}
+
+size_t ChainBuffer::writableBytes() const {
+    return tail_ == nullptr ? 0 : tail_->writable();
+}
+
+ChainBuffer::Block *ChainBuffer::newBlock() {
+    Block *block;
+    if (freeList_ != nullptr) {
+        block = freeList_;
+        freeList_ = block->next;
+        --numFree_;
+    } else {
+        // 不初始化data
+        block = new Block;
+    }
+    block->next = nullptr;
+    block->readIndex = 0;
+    block->writeIndex = 0;
+    return block;
+}
+
+void ChainBuffer::freeBlock(Block *block) {
+    if (numFree_ < kMaxFreeBlocks) {
+        block->next = freeList_;
+        freeList_ = block;
+        ++numFree_;
+    } else {
+        delete block;
+    }
+}
+
+void ChainBuffer::releaseFreeList() {
+    while (freeList_ != nullptr) {
+        Block *next = freeList_->next;
+        delete freeList_;
+        freeList_ = next;
+    }
+    numFree_ = 0;
+}
+
+void ChainBuffer::pushBack(Block *block) {
+    if (tail_ == nullptr) {
+        head_ = tail_ = block;
+    } else {
+        tail_->next = block;
+        tail_ = block;
+    }
+    ++numBlocks_;
+}
+
+void ChainBuffer::clear() {
+    while (head_ != nullptr) {
+        Block *next = head_->next;
+        freeBlock(head_);
+        head_ = next;
+    }
+    tail_ = nullptr;
+    numBlocks_ = 0;
+    readable_ = 0;
+}
+
+const char *ChainBuffer::firstSegment(size_t *len) const {
+    if (head_ == nullptr) {
+        *len = 0;
+        return nullptr;
+    }
+    *len = head_->readable();
+    return head_->data + head_->readIndex;
+}
+
+const char *ChainBuffer::peek() {
+    if (head_ == nullptr) {
+        return nullptr;
+    }
+    if (head_->readable() == readable_) {
+        return head_->data + head_->readIndex;
+    }
+
+    // 跨块：拷贝到连续存储，保持与Buffer::peek()相同的语义
+    linear_.resize(readable_);
+    size_t offset = 0;
+    for (Block *block = head_; block != nullptr; block = block->next) {
+        memcpy(&linear_[offset], block->data + block->readIndex,
+               block->readable());
+        offset += block->readable();
+    }
+    return linear_.data();
+}
+
+void ChainBuffer::retrieve(size_t len) {
+    if (len >= readable_) {
+        retrieveAll();
+        return;
+    }
+
+    readable_ -= len;
+    while (len > 0) {
+        size_t n = head_->readable();
+        if (len < n) {
+            head_->readIndex += len;
+            break;
+        }
+        // 整块读完，直接摘下
+        len -= n;
+        Block *next = head_->next;
+        freeBlock(head_);
+        head_ = next;
+        --numBlocks_;
+    }
+    if (head_ == nullptr) {
+        tail_ = nullptr;
+    }
+}
+
+void ChainBuffer::retrieveAll() { clear(); }
+
+std::string ChainBuffer::retrieveAsString(size_t len) {
+    len = std::min(len, readable_);
+    std::string result;
+    result.reserve(len);
+    size_t left = len;
+    for (Block *block = head_; block != nullptr && left > 0;
+         block = block->next) {
+        size_t n = std::min(left, block->readable());
+        result.append(block->data + block->readIndex, n);
+        left -= n;
+    }
+    retrieve(len);
+    return result;
+}
+
+void ChainBuffer::append(const char *data, size_t len) {
+    readable_ += len;
+    while (len > 0) {
+        if (tail_ == nullptr || tail_->writable() == 0) {
+            pushBack(newBlock());
+        }
+        size_t n = std::min(len, tail_->writable());
+        memcpy(tail_->data + tail_->writeIndex, data, n);
+        tail_->writeIndex += n;
+        data += n;
+        len -= n;
+    }
+}
+
+ssize_t ChainBuffer::readFd(int fd, int *savedErrno) {
+    Block *spare = newBlock();
+    struct iovec vec[2];
+    int iovcnt = 0;
+
+    const size_t writable = writableBytes();
+    if (writable > 0) {
+        vec[iovcnt].iov_base = tail_->data + tail_->writeIndex;
+        vec[iovcnt].iov_len = writable;
+        ++iovcnt;
+    }
+    vec[iovcnt].iov_base = spare->data;
+    vec[iovcnt].iov_len = kBlockSize;
+    ++iovcnt;
+
+    const ssize_t n = ::readv(fd, vec, iovcnt);
+    if (n < 0) {
+        *savedErrno = errno;
+        freeBlock(spare);
+        return n;
+    }
+    // EOF：空链上tail_为空，不能走下面的分支
+    if (n == 0) {
+        freeBlock(spare);
+        return 0;
+    }
+
+    readable_ += n;
+    if (static_cast<size_t>(n) <= writable) {
+        tail_->writeIndex += n;
+        freeBlock(spare);
+    } else {
+        if (writable > 0) {
+            tail_->writeIndex = kBlockSize;
+        }
+        spare->writeIndex = n - writable;
+        pushBack(spare);
+    }
+    return n;
+}
+
+ssize_t ChainBuffer::writeFd(int fd, int *savedErrno) {
+    struct iovec vec[kMaxIovecs];
+    int iovcnt = 0;
+    for (Block *block = head_; block != nullptr && iovcnt < kMaxIovecs;
+         block = block->next) {
+        vec[iovcnt].iov_base = block->data + block->readIndex;
+        vec[iovcnt].iov_len = block->readable();
+        ++iovcnt;
+    }
+    if (iovcnt == 0) {
+        return 0;
+    }
+
+    const ssize_t n = ::writev(fd, vec, iovcnt);
+    if (n < 0) {
+        *savedErrno = errno;
+        return n;
+    }
+    retrieve(n);
+    return n;
+}
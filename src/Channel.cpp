@@ -5,7 +5,9 @@ Channel::Channel(EventLoop* loop, int fd):
     loop_(loop),
     fd_(fd),
     events_(0),
-    revents_(0) {
+    revents_(0),
+    handlers_(nullptr),
+    owner_(nullptr) {
 }
 
 Channel::~Channel() {
@@ -13,32 +15,57 @@ Channel::~Channel() {
 }
 
 void Channel::handleEvent(){
+    if (handlers_ == nullptr) {
+        handleEventWithCallbacks();
+        return;
+    }
+
+    // 顺序与handleEventWithCallbacks相同
+    if ((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN)) {
+        handlers_->onClose(owner_);
+    }
+    if (revents_ & EPOLLERR) {
+        handlers_->onError(owner_);
+    }
+    if (revents_ & (EPOLLIN | EPOLLPRI | EPOLLRDHUP)) {
+        handlers_->onRead(owner_);
+    }
+    if (revents_ & EPOLLOUT) {
+        handlers_->onWrite(owner_);
+    }
+}
+
+void Channel::handleEventWithCallbacks(){
+    if (!callbacks_) {
+        return;
+    }
+
     // 处理挂断，同时在有数据可读时不触发close
     if((revents_& EPOLLHUP) && !(revents_ & EPOLLIN)){
         
-        if(closeCallback_){
-            closeCallback_();
+        if(callbacks_->close){
+            callbacks_->close();
         }
     }
 
     // 处理错误
     if(revents_ & EPOLLERR) {
-        if (errorCallback_) {
-            errorCallback_();
+        if (callbacks_->error) {
+            callbacks_->error();
         }
     }
 
     // 读
     if (revents_ & (EPOLLIN | EPOLLPRI | EPOLLRDHUP)) {
-        if(readCallback_){
-            readCallback_();
+        if(callbacks_->read){
+            callbacks_->read();
         }
     }
 
     // 写
     if(revents_ & EPOLLOUT) {
-        if(writeCallback_){
-            writeCallback_();
+        if(callbacks_->write){
+            callbacks_->write();
         }
     }
 }
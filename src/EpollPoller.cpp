@@ -0,0 +1,98 @@
+#include "EpollPoller.h"
+#include "Channel.h"
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <unistd.h>
+
+EpollPoller::EpollPoller(EventLoop *loop)
+    : Poller(loop), epollfd_(epoll_create1(EPOLL_CLOEXEC)),
+      events_(kInitEventListSize), underfilledPolls_(0) {
+    assert(epollfd_ >= 0);
+}
+
+EpollPoller::~EpollPoller() {
+    if (epollfd_ >= 0) {
+        close(epollfd_);
+    }
+}
+
+int EpollPoller::poll(int timeoutMs, ChannelList *activeChannels) {
+    int numEvents = epoll_wait(epollfd_, events_.data(),
+                               static_cast<int>(events_.size()), timeoutMs);
+    ++numSyscalls_;
+    if (numEvents < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    for (int i = 0; i < numEvents; ++i) {
+        Channel *channel = static_cast<Channel *>(events_[i].data.ptr);
+        channel->setRevents(events_[i].events); //设置事件返回类型
+        activeChannels->push_back(channel);
+    }
+    recordWakeup(numEvents);
+    adjustEventBatch(numEvents);
+    return numEvents;
+}
+
+void EpollPoller::adjustEventBatch(int numEvents) {
+    size_t size = events_.size();
+    if (static_cast<size_t>(numEvents) == size) {
+        underfilledPolls_ = 0;
+        if (size < kMaxEventListSize) {
+            // 装满说明内核里可能还有就绪事件没取到
+            events_.resize(size * 2);
+        }
+    } else if (static_cast<size_t>(numEvents) < size / 4 &&
+               size > kInitEventListSize) {
+        // 负载回落后逐步缩回，避免一次突发永久占用大数组
+        if (++underfilledPolls_ >= kShrinkAfterPolls) {
+            underfilledPolls_ = 0;
+            events_.resize(std::max(size / 2, kInitEventListSize));
+            events_.shrink_to_fit();
+        }
+    } else {
+        underfilledPolls_ = 0;
+    }
+}
+
+void EpollPoller::updateChannel(Channel *channel) {
+    int fd = channel->fd();
+    assert(fd >= 0);
+
+    struct epoll_event event {};
+    event.events = channel->events();
+    event.data.ptr = channel;
+
+    if (static_cast<size_t>(fd) >= channels_.size()) {
+        channels_.resize(std::max(static_cast<size_t>(fd) + 1,
+                                  channels_.size() * 2),
+                         nullptr);
+    }
+
+    if (channels_[fd] == nullptr) {
+        if (channel->isNoneEvent()) {
+            return;
+        }
+        channels_[fd] = channel;
+        epoll_ctl(epollfd_, EPOLL_CTL_ADD, fd, &event);
+    } else if (channel->isNoneEvent()) {
+        // 从epoll中删除后也移出表，之后重新关注事件时走ADD
+        channels_[fd] = nullptr;
+        epoll_ctl(epollfd_, EPOLL_CTL_DEL, fd, &event);
+    } else {
+        assert(channels_[fd] == channel);
+        epoll_ctl(epollfd_, EPOLL_CTL_MOD, fd, &event);
+    }
+    ++numSyscalls_;
+}
+
+void EpollPoller::removeChannel(Channel *channel) {
+    int fd = channel->fd();
+
+    if (registered(fd, channel)) {
+        channels_[fd] = nullptr;
+        epoll_ctl(epollfd_, EPOLL_CTL_DEL, fd, nullptr);
+        ++numSyscalls_;
+    }
+}
@@ -1,74 +1,286 @@
 #include "EventLoop.h"
+#include "BufferPool.h"
 #include "Channel.h"
+#include "Logger.h"
+#include "TimerQueue.h"
+#include "TimingWheel.h"
 #include <unistd.h>
 #include <cstring>
 #include <cassert>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
 
-EventLoop::EventLoop():
+namespace {
+
+int64_t nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               TimerClock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+EventLoop::EventLoop(Poller::Type pollerType):
     looping_(false),
     quit_(false),
-    epollfd_(epoll_create1(EPOLL_CLOEXEC)),
-    events_(kMaxEvents){
-        assert(epollfd_);
+    callingPendingFunctors_(false),
+    spinning_(false),
+    spinBudgetNs_(0),
+    lastBusyNs_(0),
+    threadId_(std::this_thread::get_id()),
+    poller_(Poller::newPoller(this, pollerType)),
+    bufferPool_(new BufferPool),
+    wakeupFd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+    numConnections_(0),
+    pendingOutputBytes_(0){
+        assert(wakeupFd_ >= 0);
+
+        wakeupChannel_.reset(new Channel(this, wakeupFd_));
+        wakeupChannel_->setReadCallback([this](){
+            handleWakeup();
+        });
+        wakeupChannel_->enableReading();
+
+        timerQueue_.reset(new TimerQueue(this));
 }
 
 EventLoop::~EventLoop(){
-    if(epollfd_ >= 0){
-        close(epollfd_);
-    } 
+    idleWheel_.reset();
+    timerQueue_.reset();
+
+    wakeupChannel_->disableAll();
+    wakeupChannel_->remove();
+    ::close(wakeupFd_);
 }
 
 void EventLoop::loop(){
     assert(!looping_);
+    assert(isInLoopThread());
     looping_ = true;
-    quit_ = false;
 
     while(!quit_){
-        int numEvents = epoll_wait(epollfd_, events_.data(),
-                                    static_cast<int>(events_.size()), -1);
+        activeChannels_.clear();
+#if HPN_LOOP_STATS
+        int64_t pollStart = nowNanos();
+#endif
+        int numEvents = poller_->poll(pollTimeout(), &activeChannels_);
         if (numEvents < 0) {
             break;
         }
 
-        for (int i = 0; i < numEvents; ++i) {
-            Channel* channel = static_cast<Channel*>(events_[i].data.ptr);
-            channel->setRevents(events_[i].events); //设置事件返回类型
+#if HPN_LOOP_STATS
+        // 相邻回调共用一次取时，每个回调只多一次clock_gettime(vDSO)
+        int64_t processStart = nowNanos();
+        int64_t callbackStart = processStart;
+        for (Channel* channel : activeChannels_) {
+            // 回调可能移除并销毁channel，fd要在回调之前取
+            int fd = channel->fd();
             channel->handleEvent();
+            int64_t callbackEnd = nowNanos();
+            stats_.recordCallback(fd, callbackEnd - callbackStart);
+            callbackStart = callbackEnd;
+        }
+#else
+        for (Channel* channel : activeChannels_) {
+            channel->handleEvent();
+        }
+#endif
+        // 上一轮推迟的工作排在本轮就绪事件之后，新到的事件先得到处理
+        size_t numDeferred = runHooks(&deferredHooks_);
+
+        size_t numFunctors = doPendingFunctors();
+        // 放在pendingFunctors之后：跨线程投递的send也合并进这一次flush
+        numFunctors += runHooks(&flushHooks_) + numDeferred;
+
+#if HPN_LOOP_STATS
+        int64_t processEnd = nowNanos();
+        stats_.recordIteration(processStart - pollStart,
+                               processEnd - processStart, numEvents);
+#endif
+
+        if ((numEvents > 0 || numFunctors > 0) &&
+            spinBudgetNs_.load(std::memory_order_relaxed) > 0) {
+            lastBusyNs_ = nowNanos();
         }
     }
+    spinning_.store(false, std::memory_order_relaxed);
+
+    // quit前入队的任务也要执行，比如TcpServer析构时排队的connectDestroyed
+    doPendingFunctors();
+    runHooks(&flushHooks_);
 
     looping_ = false;
+    quit_ = false;
 }
 
 void EventLoop::quit() {
     quit_ = true;
+    // 其他线程调用时，loop可能阻塞在epoll_wait中
+    if (!isInLoopThread()) {
+        wakeup();
+    }
 }
 
-void EventLoop::updateChannel(Channel* channel){
-    int fd = channel->fd();
+void EventLoop::runInLoop(Functor cb) {
+    if (isInLoopThread()) {
+        cb();
+    } else {
+        queueInLoop(std::move(cb));
+    }
+}
 
-    struct epoll_event event{};
-    event.events = channel->events();
-    event.data.ptr = channel;
+void EventLoop::queueInLoop(Functor cb) {
+    bool wasEmpty = pendingFunctors_.push(std::move(cb));
 
-    if(channels_.find(fd) == channels_.end()){
-        channels_[fd] = channel;
-        epoll_ctl(epollfd_, EPOLL_CTL_ADD, fd, &event);
-    } else {
-        if (channel->isNoneEvent()){
-            epoll_ctl(epollfd_, EPOLL_CTL_DEL, fd, &event);
-        } else {
-            epoll_ctl(epollfd_, EPOLL_CTL_MOD, fd, &event);
+    // 与pollTimeout()中的fence配对：要么这里看到loop仍在自旋，
+    // 要么loop在阻塞前看到队列非空
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (spinning_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // 队列原本非空时，之前的投递者已经唤醒过loop，不必重复写eventfd
+    // 正在执行pendingFunctors时新加入的任务，需要再唤醒一次，否则下一轮会阻塞
+    if (wasEmpty && (!isInLoopThread() || callingPendingFunctors_)) {
+        wakeup();
+    }
+}
+
+size_t EventLoop::runHooks(std::vector<IterationHook *> *list) {
+    if (list->empty()) {
+        return 0;
+    }
+    // 执行中可能再次加入（例如flush的回调又发送、续读再次用完预算），留到下一次
+    runningHooks_.swap(*list);
+    size_t n = runningHooks_.size();
+    for (size_t i = 0; i < runningHooks_.size(); ++i) {
+        IterationHook *hook = runningHooks_[i];
+        // 被cancelHook置空
+        if (hook == nullptr) {
+            continue;
         }
+        hook->queued = false;
+        hook->onRun(hook);
     }
+    runningHooks_.clear();
+    return n;
 }
 
-void EventLoop::removeChannel(Channel* channel) {
-    int fd = channel->fd();
+void EventLoop::cancelHook(IterationHook *hook) {
+    if (!hook->queued) {
+        return;
+    }
+    assert(isInLoopThread());
+    hook->queued = false;
+    for (std::vector<IterationHook *> *list :
+         {&flushHooks_, &deferredHooks_, &runningHooks_}) {
+        for (IterationHook *&item : *list) {
+            if (item == hook) {
+                item = nullptr;
+                return;
+            }
+        }
+    }
+}
+
+int EventLoop::pollTimeout() {
+    // flush期间本线程投递的任务（例如写完回调）不会写eventfd，
+    // 合并后又产生的flush、推迟到下一轮的工作也都不能等事件才处理
+    if (!flushHooks_.empty() || !deferredHooks_.empty() ||
+        !pendingFunctors_.empty()) {
+        return 0;
+    }
+    int64_t budget = spinBudgetNs_.load(std::memory_order_relaxed);
+    if (budget > 0 && nowNanos() - lastBusyNs_ < budget) {
+        spinning_.store(true, std::memory_order_relaxed);
+        return 0;
+    }
+    if (!spinning_.load(std::memory_order_relaxed)) {
+        return -1;
+    }
+
+    // 预算用完准备阻塞：先声明不再自旋，再检查自旋期间没写eventfd的任务
+    spinning_.store(false, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return pendingFunctors_.empty() ? -1 : 0;
+}
+
+bool EventLoop::setCpuAffinity(int cpu) {
+    assert(isInLoopThread());
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int ret = ::pthread_setaffinity_np(::pthread_self(), sizeof set, &set);
+    if (ret != 0) {
+        LOG_ERROR("EventLoop::setCpuAffinity(%d) failed: %s", cpu,
+                  strerror(ret));
+        return false;
+    }
+    return true;
+}
+
+TimerId EventLoop::runAt(TimePoint time, TimerCallback cb) {
+    return timerQueue_->addTimer(std::move(cb), time, TimerClock::duration::zero());
+}
+
+TimerId EventLoop::runAfter(double delaySeconds, TimerCallback cb) {
+    auto delay = std::chrono::duration_cast<TimerClock::duration>(
+        std::chrono::duration<double>(delaySeconds));
+    return runAt(TimerClock::now() + delay, std::move(cb));
+}
+
+TimerId EventLoop::runEvery(double intervalSeconds, TimerCallback cb) {
+    auto interval = std::chrono::duration_cast<TimerClock::duration>(
+        std::chrono::duration<double>(intervalSeconds));
+    return timerQueue_->addTimer(std::move(cb), TimerClock::now() + interval, interval);
+}
+
+void EventLoop::cancel(TimerId timerId) {
+    timerQueue_->cancel(timerId);
+}
 
-    auto it = channels_.find(fd);
-    if(it != channels_.end()){
-        channels_.erase(it);
-        epoll_ctl(epollfd_, EPOLL_CTL_DEL, fd, nullptr);
+TimingWheel* EventLoop::idleWheel() {
+    assert(isInLoopThread());
+    if (!idleWheel_) {
+        idleWheel_.reset(new TimingWheel(this));
     }
-}
\ No newline at end of file
+    return idleWheel_.get();
+}
+
+void EventLoop::wakeup() {
+    uint64_t one = 1;
+    ssize_t n = ::write(wakeupFd_, &one, sizeof one);
+    if (n != sizeof one) {
+        LOG_ERROR("EventLoop::wakeup() writes %zd bytes instead of 8", n);
+    }
+}
+
+void EventLoop::handleWakeup() {
+    uint64_t one = 1;
+    ssize_t n = ::read(wakeupFd_, &one, sizeof one);
+    if (n != sizeof one) {
+        LOG_ERROR("EventLoop::handleWakeup() reads %zd bytes instead of 8", n);
+    }
+}
+
+size_t EventLoop::doPendingFunctors() {
+    callingPendingFunctors_ = true;
+
+    // 一次exchange取走整批任务，回调中再次queueInLoop的任务留到下一轮
+    size_t count = pendingFunctors_.consumeAll([](Functor& functor) {
+        functor();
+    });
+
+    callingPendingFunctors_ = false;
+    return count;
+}
+
+void EventLoop::updateChannel(Channel* channel){
+    poller_->updateChannel(channel);
+}
+
+void EventLoop::removeChannel(Channel* channel) {
+    poller_->removeChannel(channel);
+}
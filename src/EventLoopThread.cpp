@@ -0,0 +1,47 @@
+#include "EventLoopThread.h"
+#include "EventLoop.h"
+
+EventLoopThread::EventLoopThread(ThreadInitCallback cb)
+    : loop_(nullptr), exiting_(false), callback_(std::move(cb)) {}
+
+EventLoopThread::~EventLoopThread() {
+    exiting_ = true;
+    {
+        // 子线程在锁内把loop_清空之后才析构EventLoop，持锁调用quit不会访问已析构的loop
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (loop_ != nullptr) {
+            loop_->quit();
+        }
+    }
+    // loop自己退出时loop_已为nullptr，线程仍需要join
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+EventLoop *EventLoopThread::startLoop() {
+    thread_ = std::thread([this]() { threadFunc(); });
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return loop_ != nullptr; });
+    return loop_;
+}
+
+void EventLoopThread::threadFunc() {
+    EventLoop loop;
+
+    if (callback_) {
+        callback_(&loop);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loop_ = &loop;
+        cond_.notify_one();
+    }
+
+    loop.loop();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    loop_ = nullptr;
+}
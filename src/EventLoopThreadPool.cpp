@@ -0,0 +1,89 @@
+#include "EventLoopThreadPool.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include <algorithm>
+#include <cassert>
+
+EventLoopThreadPool::EventLoopThreadPool(EventLoop *baseLoop)
+    : baseLoop_(baseLoop), started_(false), numThreads_(0), next_(0),
+      distribution_(kRoundRobin), spinBudget_(0) {}
+
+// 子线程中的EventLoop是栈上对象，由EventLoopThread负责退出
+EventLoopThreadPool::~EventLoopThreadPool() = default;
+
+void EventLoopThreadPool::start(const ThreadInitCallback &cb) {
+    assert(!started_);
+    assert(baseLoop_->isInLoopThread());
+    started_ = true;
+
+    for (int i = 0; i < numThreads_; ++i) {
+        int cpu = cpus_.empty() ? -1 : cpus_[i % cpus_.size()];
+        std::chrono::microseconds spinBudget = spinBudget_;
+        // 绑核和自旋设置在用户回调之前完成
+        threads_.emplace_back(
+            new EventLoopThread([cb, cpu, spinBudget](EventLoop *loop) {
+                if (cpu >= 0) {
+                    loop->setCpuAffinity(cpu);
+                }
+                loop->setSpinBudget(spinBudget);
+                if (cb) {
+                    cb(loop);
+                }
+            }));
+        loops_.push_back(threads_.back()->startLoop());
+    }
+
+    if (numThreads_ == 0) {
+        if (!cpus_.empty()) {
+            baseLoop_->setCpuAffinity(cpus_[0]);
+        }
+        baseLoop_->setSpinBudget(spinBudget_);
+        if (cb) {
+            cb(baseLoop_);
+        }
+    }
+}
+
+EventLoop *EventLoopThreadPool::getNextLoop() {
+    assert(baseLoop_->isInLoopThread());
+    assert(started_);
+
+    if (loops_.empty()) {
+        return baseLoop_;
+    }
+
+    if (selector_) {
+        return selector_(loops_);
+    }
+
+    switch (distribution_) {
+    case kLeastConnections:
+        return *std::min_element(loops_.begin(), loops_.end(),
+                                 [](EventLoop *a, EventLoop *b) {
+                                     return a->numConnections() <
+                                            b->numConnections();
+                                 });
+    case kLeastPendingBytes:
+        return *std::min_element(loops_.begin(), loops_.end(),
+                                 [](EventLoop *a, EventLoop *b) {
+                                     return a->pendingOutputBytes() <
+                                            b->pendingOutputBytes();
+                                 });
+    case kRoundRobin:
+    default:
+        break;
+    }
+
+    EventLoop *loop = loops_[next_];
+    if (++next_ >= loops_.size()) {
+        next_ = 0;
+    }
+    return loop;
+}
+
+std::vector<EventLoop *> EventLoopThreadPool::getAllLoops() const {
+    if (loops_.empty()) {
+        return std::vector<EventLoop *>(1, baseLoop_);
+    }
+    return loops_;
+}
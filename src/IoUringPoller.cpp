@@ -0,0 +1,314 @@
+#include "IoUringPoller.h"
+#include "Channel.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// POLL_REMOVE 自身的完成事件，直接丢弃
+const uint64_t kRemoveTag = 1ULL << 63;
+
+int sysSetup(unsigned entries, struct io_uring_params *p) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int sysEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags,
+             const void *arg, size_t argsz) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit,
+                                      minComplete, flags, arg, argsz));
+}
+
+// 代数只用31位，最高位留给kRemoveTag
+uint64_t makeUserData(int fd, uint32_t generation) {
+    return (static_cast<uint64_t>(generation & 0x7fffffff) << 32) |
+           static_cast<uint32_t>(fd);
+}
+
+} // namespace
+
+IoUringPoller::IoUringPoller(EventLoop *loop, unsigned entries)
+    : Poller(loop), ringFd_(-1), sqRing_(MAP_FAILED), sqRingSize_(0),
+      sqHead_(nullptr), sqTail_(nullptr), sqMask_(0), sqEntries_(0),
+      sqArray_(nullptr), sqes_(nullptr), sqesSize_(0), sqeTail_(0),
+      sqeSubmitted_(0), cqRing_(MAP_FAILED), cqRingSize_(0), cqHead_(nullptr),
+      cqTail_(nullptr), cqMask_(0), cqes_(nullptr), pollEpoch_(0) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof params);
+
+    int fd = sysSetup(entries, &params);
+    if (fd < 0) {
+        LOG_ERROR("io_uring_setup failed: %s", strerror(errno));
+        return;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    // 新内核SQ和CQ共用一次mmap
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        LOG_ERROR("io_uring mmap sq ring failed: %s", strerror(errno));
+        ::close(fd);
+        return;
+    }
+
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            LOG_ERROR("io_uring mmap cq ring failed: %s", strerror(errno));
+            ::munmap(sqRing_, sqRingSize_);
+            sqRing_ = MAP_FAILED;
+            ::close(fd);
+            return;
+        }
+    }
+
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        LOG_ERROR("io_uring mmap sqes failed: %s", strerror(errno));
+        if (!singleMmap) {
+            ::munmap(cqRing_, cqRingSize_);
+        }
+        ::munmap(sqRing_, sqRingSize_);
+        sqRing_ = cqRing_ = MAP_FAILED;
+        ::close(fd);
+        return;
+    }
+
+    char *sq = static_cast<char *>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    sqArray_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+    char *cq = static_cast<char *>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    // SQ数组与SQE一一对应，之后不再修改
+    for (unsigned i = 0; i < sqEntries_; ++i) {
+        sqArray_[i] = i;
+    }
+    sqeTail_ = sqeSubmitted_ = *sqTail_;
+
+    ringFd_ = fd;
+}
+
+IoUringPoller::~IoUringPoller() {
+    if (ringFd_ < 0) {
+        return;
+    }
+    ::munmap(sqes_, sqesSize_);
+    if (cqRing_ != sqRing_) {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    ::munmap(sqRing_, sqRingSize_);
+    ::close(ringFd_);
+}
+
+IoUringPoller::FdState &IoUringPoller::stateOf(int fd) {
+    assert(fd >= 0);
+    if (static_cast<size_t>(fd) >= fds_.size()) {
+        fds_.resize(std::max(static_cast<size_t>(fd) + 1, fds_.size() * 2));
+    }
+    return fds_[fd];
+}
+
+struct io_uring_sqe *IoUringPoller::getSqe() {
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    if (sqeTail_ - head >= sqEntries_) {
+        // SQ满了，先提交一批，不等待完成
+        submitAndWait(0, 0);
+        head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if (sqeTail_ - head >= sqEntries_) {
+            return nullptr;
+        }
+    }
+
+    struct io_uring_sqe *sqe = &sqes_[sqeTail_ & sqMask_];
+    memset(sqe, 0, sizeof *sqe);
+    ++sqeTail_;
+    return sqe;
+}
+
+int IoUringPoller::submitAndWait(unsigned waitNr, int timeoutMs) {
+    // 发布本地填写的SQE
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+    unsigned toSubmit = sqeTail_ - sqeSubmitted_;
+    sqeSubmitted_ = sqeTail_;
+
+    if (toSubmit == 0 && waitNr == 0) {
+        return 0;
+    }
+
+    unsigned flags = waitNr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int ret;
+    if (waitNr > 0 && timeoutMs > 0) {
+        struct __kernel_timespec ts;
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = (timeoutMs % 1000) * 1000000LL;
+
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof arg);
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        ret = sysEnter(ringFd_, toSubmit, waitNr,
+                       flags | IORING_ENTER_EXT_ARG, &arg, sizeof arg);
+    } else {
+        ret = sysEnter(ringFd_, toSubmit, waitNr, flags, nullptr, 0);
+    }
+    ++numSyscalls_;
+
+    if (ret < 0 && errno != EINTR && errno != ETIME && errno != EBUSY) {
+        LOG_ERROR("io_uring_enter failed: %s", strerror(errno));
+    }
+    return ret;
+}
+
+int IoUringPoller::poll(int timeoutMs, ChannelList *activeChannels) {
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+
+    // CQ中已有完成事件时不再等待，只提交
+    unsigned waitNr = (head == tail && timeoutMs != 0) ? 1 : 0;
+    submitAndWait(waitNr, timeoutMs);
+
+    tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    ++pollEpoch_;
+    int numEvents = 0;
+    for (; head != tail; ++head) {
+        const struct io_uring_cqe *cqe = &cqes_[head & cqMask_];
+        uint64_t userData = cqe->user_data;
+        if (userData & kRemoveTag) {
+            continue;
+        }
+
+        int fd = static_cast<int>(userData & 0xffffffff);
+        uint32_t generation = static_cast<uint32_t>(userData >> 32);
+        if (static_cast<size_t>(fd) >= fds_.size()) {
+            continue;
+        }
+
+        FdState &state = fds_[fd];
+        // 已被修改或删除的旧请求
+        if ((state.generation & 0x7fffffff) != generation ||
+            state.channel == nullptr) {
+            continue;
+        }
+        // 多次触发的poll仍然有效时不需要重新提交；
+        // 否则立即重新挂上，随下一次poll()一起提交
+        state.armed = state.multishot && (cqe->flags & IORING_CQE_F_MORE);
+        if (!state.armed && state.events != 0) {
+            arm(fd, state);
+        }
+
+        uint32_t revents;
+        if (cqe->res < 0) {
+            if (cqe->res == -ECANCELED) {
+                continue;
+            }
+            revents = EPOLLERR;
+        } else {
+            revents = static_cast<uint32_t>(cqe->res);
+        }
+
+        // 多次触发的poll在一批中可能有同一个fd的多个完成事件，合并成一次
+        if (state.activeEpoch == pollEpoch_) {
+            state.channel->setRevents(state.channel->revents() | revents);
+            continue;
+        }
+        state.activeEpoch = pollEpoch_;
+        state.channel->setRevents(revents);
+        activeChannels->push_back(state.channel);
+        ++numEvents;
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    recordWakeup(numEvents);
+    return numEvents;
+}
+
+void IoUringPoller::arm(int fd, FdState &state) {
+    struct io_uring_sqe *sqe = getSqe();
+    if (sqe == nullptr) {
+        LOG_ERROR("io_uring sq full, fd %d not armed", fd);
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = state.events;
+    if (state.multishot) {
+        sqe->len = IORING_POLL_ADD_MULTI;
+    }
+    sqe->user_data = makeUserData(fd, state.generation);
+    state.armed = true;
+}
+
+void IoUringPoller::disarm(int fd, FdState &state) {
+    if (state.armed) {
+        struct io_uring_sqe *sqe = getSqe();
+        if (sqe != nullptr) {
+            sqe->opcode = IORING_OP_POLL_REMOVE;
+            sqe->fd = -1;
+            sqe->addr = makeUserData(fd, state.generation);
+            sqe->user_data = kRemoveTag;
+        }
+        state.armed = false;
+    }
+    // 旧请求即使已经完成，其完成事件也会被丢弃
+    ++state.generation;
+}
+
+void IoUringPoller::updateChannel(Channel *channel) {
+    int fd = channel->fd();
+    FdState &state = stateOf(fd);
+    uint32_t events = channel->events() & ~(EPOLLET | EPOLLEXCLUSIVE);
+    bool multishot = channel->isEdgeTriggered();
+
+    if (state.channel == channel && state.events == events &&
+        state.multishot == multishot && state.armed) {
+        return;
+    }
+
+    disarm(fd, state);
+    state.channel = channel;
+    state.events = events;
+    state.multishot = multishot;
+    if (events != 0) {
+        arm(fd, state);
+    }
+}
+
+void IoUringPoller::removeChannel(Channel *channel) {
+    int fd = channel->fd();
+    if (static_cast<size_t>(fd) >= fds_.size() ||
+        fds_[fd].channel != channel) {
+        return;
+    }
+
+    FdState &state = fds_[fd];
+    disarm(fd, state);
+    state.channel = nullptr;
+    state.events = 0;
+}
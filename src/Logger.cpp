@@ -1,6 +1,7 @@
 #include "Logger.h"
 #include <ctime>
 #include <cstring>
+#include <cstdlib>
 
 static LogLevel g_logLevel = INFO;
 
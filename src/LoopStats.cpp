@@ -0,0 +1,75 @@
+#include "LoopStats.h"
+#include "Logger.h"
+
+LogHistogram::LogHistogram() : count_(0), sum_(0), max_(0) {
+    for (auto &bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+LogHistogram::Snapshot LogHistogram::snapshot() const {
+    Snapshot s;
+    s.count = count_.load(std::memory_order_relaxed);
+    s.sum = sum_.load(std::memory_order_relaxed);
+    s.max = max_.load(std::memory_order_relaxed);
+    for (int i = 0; i < kBuckets; ++i) {
+        s.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+uint64_t LogHistogram::Snapshot::percentile(double p) const {
+    uint64_t total = 0;
+    for (uint64_t n : buckets) {
+        total += n;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(p * total);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // 桶上界不会超过实际最大值
+            uint64_t upper = i == kBuckets - 1 ? UINT64_MAX : (2ULL << i) - 1;
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+LoopStats::LoopStats()
+    : iterations_(0), slowThresholdNanos_(kDefaultSlowCallbackNanos),
+      slowCallbacks_(0), lastSlowFd_(-1), lastSlowNanos_(0) {}
+
+void LoopStats::onSlowCallback(int fd, int64_t nanos) {
+    slowCallbacks_.store(slowCallbacks_.load(std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+    lastSlowFd_.store(fd, std::memory_order_relaxed);
+    lastSlowNanos_.store(static_cast<uint64_t>(nanos),
+                         std::memory_order_relaxed);
+
+    if (slowHandler_) {
+        slowHandler_(fd, static_cast<uint64_t>(nanos));
+    } else {
+        LOG_INFO("slow callback on fd %d took %.3f ms", fd, nanos / 1e6);
+    }
+}
+
+LoopStats::Snapshot LoopStats::snapshot() const {
+    Snapshot s;
+    s.iterations = iterations_.load(std::memory_order_relaxed);
+    s.slowCallbacks = slowCallbacks_.load(std::memory_order_relaxed);
+    s.lastSlowFd = lastSlowFd_.load(std::memory_order_relaxed);
+    s.lastSlowNanos = lastSlowNanos_.load(std::memory_order_relaxed);
+    s.waitNanos = wait_.snapshot();
+    s.processNanos = process_.snapshot();
+    s.callbackNanos = callback_.snapshot();
+    s.eventsPerIteration = events_.snapshot();
+    return s;
+}
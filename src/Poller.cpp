@@ -0,0 +1,25 @@
+#include "Poller.h"
+#include "EpollPoller.h"
+#include "IoUringPoller.h"
+#include "Logger.h"
+#include <cstdlib>
+#include <cstring>
+
+Poller *Poller::newPoller(EventLoop *loop, Type type) {
+    if (type == kDefault) {
+        const char *env = ::getenv("HPN_POLLER");
+        type = (env != nullptr && strcmp(env, "io_uring") == 0) ? kIoUring
+                                                                 : kEpoll;
+    }
+
+    if (type == kIoUring) {
+        IoUringPoller *poller = new IoUringPoller(loop);
+        if (poller->valid()) {
+            return poller;
+        }
+        delete poller;
+        LOG_ERROR("io_uring unavailable, falling back to epoll");
+    }
+
+    return new EpollPoller(loop);
+}
@@ -1,8 +1,10 @@
 #include "Socket.h"
+#include "InetAddress.h"
 #include <unistd.h>
 #include <fcntl.h>
 #include <cstring>
 #include <errno.h>
+#include <netinet/tcp.h>
 
 std::optional<Socket> Socket::createTCP(){
     int fd = socket(AF_INET, SOCK_STREAM, 0);
@@ -46,6 +48,11 @@ bool Socket::bind(uint16_t port){
     return result == 0;
 }
 
+bool Socket::bind(const InetAddress& addr){
+    int result = ::bind(fd_, addr.getSockAddr(), sizeof(struct sockaddr_in));
+    return result == 0;
+}
+
 bool Socket::listen(int backlog){
     int result = ::listen(fd_, backlog);
     return result == 0;
@@ -83,10 +90,125 @@ bool Socket::setReuseAddr() {
     return result == 0;
 }
 
+bool Socket::setReusePort(bool on) {
+    int optval = on ? 1 : 0;
+    int result = setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT,
+                            &optval, sizeof(optval));
+    return result == 0;
+}
+
+bool Socket::setBusyPoll(int usec) {
+#ifdef SO_BUSY_POLL
+    int result = setsockopt(fd_, SOL_SOCKET, SO_BUSY_POLL,
+                            &usec, sizeof(usec));
+    return result == 0;
+#else
+    (void)usec;
+    errno = ENOPROTOOPT;
+    return false;
+#endif
+}
+
+bool Socket::setZeroCopy(bool on) {
+#ifdef SO_ZEROCOPY
+    int optval = on ? 1 : 0;
+    int result = setsockopt(fd_, SOL_SOCKET, SO_ZEROCOPY,
+                            &optval, sizeof(optval));
+    return result == 0;
+#else
+    (void)on;
+    errno = ENOPROTOOPT;
+    return false;
+#endif
+}
+
 std::string Socket::getLastError() const {
     return getSystemError();
 }
 
 std::string Socket::getSystemError() {
     return strerror(errno);
-}
\ No newline at end of file
+}
+
+bool Socket::setTcpNoDelay(bool on) {
+    int optval = on ? 1 : 0;
+    int result = setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY,
+                            &optval, sizeof(optval));
+    return result == 0;
+}
+
+bool Socket::setSendBufferSize(int bytes) {
+    int result = setsockopt(fd_, SOL_SOCKET, SO_SNDBUF,
+                            &bytes, sizeof(bytes));
+    return result == 0;
+}
+
+bool Socket::setRecvBufferSize(int bytes) {
+    int result = setsockopt(fd_, SOL_SOCKET, SO_RCVBUF,
+                            &bytes, sizeof(bytes));
+    return result == 0;
+}
+
+bool Socket::setKeepAlive(bool on, int idleSeconds, int intervalSeconds,
+                          int probes) {
+    int optval = on ? 1 : 0;
+    if (setsockopt(fd_, SOL_SOCKET, SO_KEEPALIVE,
+                   &optval, sizeof(optval)) != 0) {
+        return false;
+    }
+    if (!on) {
+        return true;
+    }
+    // 0表示沿用系统默认值
+    if (idleSeconds > 0 && setsockopt(fd_, IPPROTO_TCP, TCP_KEEPIDLE,
+                                      &idleSeconds, sizeof(idleSeconds)) != 0) {
+        return false;
+    }
+    if (intervalSeconds > 0 &&
+        setsockopt(fd_, IPPROTO_TCP, TCP_KEEPINTVL,
+                   &intervalSeconds, sizeof(intervalSeconds)) != 0) {
+        return false;
+    }
+    if (probes > 0 && setsockopt(fd_, IPPROTO_TCP, TCP_KEEPCNT,
+                                 &probes, sizeof(probes)) != 0) {
+        return false;
+    }
+    return true;
+}
+
+bool Socket::setNotSentLowat(int bytes) {
+#ifdef TCP_NOTSENT_LOWAT
+    int result = setsockopt(fd_, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+                            &bytes, sizeof(bytes));
+    return result == 0;
+#else
+    (void)bytes;
+    errno = ENOPROTOOPT;
+    return false;
+#endif
+}
+
+bool Socket::setDeferAccept(int seconds) {
+    int result = setsockopt(fd_, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+                            &seconds, sizeof(seconds));
+    return result == 0;
+}
+
+bool Socket::setFastOpen(int queueLength) {
+#ifdef TCP_FASTOPEN
+    int result = setsockopt(fd_, IPPROTO_TCP, TCP_FASTOPEN,
+                            &queueLength, sizeof(queueLength));
+    return result == 0;
+#else
+    (void)queueLength;
+    errno = ENOPROTOOPT;
+    return false;
+#endif
+}
+
+bool Socket::setQuickAck(bool on) {
+    int optval = on ? 1 : 0;
+    int result = setsockopt(fd_, IPPROTO_TCP, TCP_QUICKACK,
+                            &optval, sizeof(optval));
+    return result == 0;
+}
@@ -0,0 +1,90 @@
+#include "SocketOptions.h"
+#include "Logger.h"
+#include "Socket.h"
+
+namespace {
+
+bool check(bool ok, Socket &socket, const std::string &name,
+           const char *option) {
+    if (!ok) {
+        LOG_ERROR("SocketOptions [%s] %s failed: %s", name.c_str(), option,
+                  socket.getLastError().c_str());
+    }
+    return ok;
+}
+
+bool applyBuffers(const SocketOptions &opts, Socket &socket,
+                  const std::string &name) {
+    bool ok = true;
+    if (opts.sendBufferBytes) {
+        ok &= check(socket.setSendBufferSize(*opts.sendBufferBytes), socket,
+                    name, "SO_SNDBUF");
+    }
+    if (opts.recvBufferBytes) {
+        ok &= check(socket.setRecvBufferSize(*opts.recvBufferBytes), socket,
+                    name, "SO_RCVBUF");
+    }
+    return ok;
+}
+
+} // namespace
+
+SocketOptions SocketOptions::lowLatency() {
+    SocketOptions opts;
+    opts.noDelay = true;
+    opts.quickAck = true;
+    // 内核里只留少量未发送的数据，socket更早变为不可写，
+    // 排在后面的小响应不必等前面的大块数据先进入发送队列
+    opts.notSentLowatBytes = 16 * 1024;
+    opts.keepAlive = KeepAlive{60, 10, 5};
+    opts.fastOpenQueue = 256;
+    return opts;
+}
+
+SocketOptions SocketOptions::bulkTransfer() {
+    SocketOptions opts;
+    opts.noDelay = false;
+    // 固定大小后内核不再自动调整；按带宽时延积选择，回环上4MB反而比1MB慢
+    opts.sendBufferBytes = 1024 * 1024;
+    opts.recvBufferBytes = 1024 * 1024;
+    opts.keepAlive = KeepAlive{300, 30, 5};
+    return opts;
+}
+
+bool SocketOptions::applyToListener(Socket &socket,
+                                    const std::string &name) const {
+    bool ok = applyBuffers(*this, socket, name);
+    if (deferAcceptSeconds) {
+        ok &= check(socket.setDeferAccept(*deferAcceptSeconds), socket, name,
+                    "TCP_DEFER_ACCEPT");
+    }
+    if (fastOpenQueue) {
+        ok &= check(socket.setFastOpen(*fastOpenQueue), socket, name,
+                    "TCP_FASTOPEN");
+    }
+    return ok;
+}
+
+bool SocketOptions::applyToConnection(Socket &socket,
+                                      const std::string &name) const {
+    bool ok = applyBuffers(*this, socket, name);
+    if (noDelay) {
+        ok &= check(socket.setTcpNoDelay(*noDelay), socket, name,
+                    "TCP_NODELAY");
+    }
+    if (quickAck) {
+        ok &= check(socket.setQuickAck(*quickAck), socket, name,
+                    "TCP_QUICKACK");
+    }
+    if (keepAlive) {
+        ok &= check(socket.setKeepAlive(true, keepAlive->idleSeconds,
+                                        keepAlive->intervalSeconds,
+                                        keepAlive->probes),
+                    socket, name, "SO_KEEPALIVE");
+    }
+    if (notSentLowatBytes) {
+        ok &= check(socket.setNotSentLowat(*notSentLowatBytes), socket, name,
+                    "TCP_NOTSENT_LOWAT");
+    }
+    return ok;
+}
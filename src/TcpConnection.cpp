@@ -1,48 +1,145 @@
 #include "TcpConnection.h"
 #include "EventLoop.h"
+#include "Logger.h"
+#include "PoolAllocator.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <fcntl.h>
 #include <functional>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
-TcpConnection::TcpConnection(EventLoop *loop, Socket &&socket)
-    : loop_(loop), socket_(std::move(socket)),
-      channel_(new Channel(loop, socket_.fd())), state_(kConnecting) {}
+namespace {
+
+// 未设置任何回调的连接共用
+const TcpConnection::CallbacksPtr &emptyCallbacks() {
+    static const TcpConnection::CallbacksPtr empty =
+        std::make_shared<const TcpConnection::Callbacks>();
+    return empty;
+}
+
+} // namespace
+
+const Channel::EventHandlers TcpConnection::kChannelHandlers = {
+    [](void *owner) { static_cast<TcpConnection *>(owner)->handleRead(); },
+    [](void *owner) { static_cast<TcpConnection *>(owner)->handleWrite(); },
+    [](void *owner) {
+        static_cast<TcpConnection *>(owner)->handleErrorEvent();
+    },
+    [](void *owner) { static_cast<TcpConnection *>(owner)->handleClose(); },
+};
+
+TcpConnection::TcpConnection(EventLoop *loop, Socket &&socket,
+                             const std::string &name)
+    : loop_(loop), name_(name), id_(kInvalidId), socket_(std::move(socket)),
+      state_(kConnecting), edgeTriggered_(false), coalesceWrites_(false),
+      msgMore_(false), zeroCopy_(false), readWanted_(true), readDeferred_(false),
+      pauseReadOnHighWater_(false), outputPaused_(false),
+      ownsCallbacks_(false), zeroCopyNextSeq_(0), channel_(loop, socket_.fd()),
+      inputBuffer_(loop->bufferPool()), outputBuffer_(loop->bufferPool()),
+      queuedBytes_(0), readBudget_(0),
+      zeroCopyThreshold_(kDefaultZeroCopyThreshold), zeroCopySends_(0), zeroCopyCopied_(0),
+      highWaterMark_(kDefaultHighWaterMark), idleWheel_(nullptr),
+      callbacks_(emptyCallbacks()) {
+    idleEntry_.onExpire = &TcpConnection::handleIdleTimeout;
+    idleEntry_.owner = this;
+    flushHook_.onRun = &TcpConnection::handleFlush;
+    flushHook_.owner = this;
+    readHook_.onRun = &TcpConnection::handleDeferredRead;
+    readHook_.owner = this;
+}
+
+TcpConnection::TcpConnectionPtr
+TcpConnection::create(EventLoop *loop, Socket &&socket,
+                      const std::string &name) {
+    return std::allocate_shared<TcpConnection>(PoolAllocator<TcpConnection>(),
+                                               loop, std::move(socket), name);
+}
+
+TcpConnection::Callbacks &TcpConnection::ownCallbacks() {
+    if (!ownsCallbacks_) {
+        // 新建的对象不是const，之后可以原地修改
+        auto own = std::make_shared<Callbacks>(*callbacks_);
+        callbacks_ = own;
+        ownsCallbacks_ = true;
+    }
+    return const_cast<Callbacks &>(*callbacks_);
+}
 
 TcpConnection::~TcpConnection() {
     assert(state_ == kDisconnected || state_ == kConnecting);
+    if (idleWheel_ != nullptr) {
+        idleWheel_->remove(&idleEntry_);
+    }
+    loop_->cancelHook(&flushHook_);
+    loop_->cancelHook(&readHook_);
 }
 
 void TcpConnection::connectEstablished() {
     assert(state_ == kConnecting);
     setState(kConnected);
 
-    channel_->setReadCallback(std::bind(&TcpConnection::handleRead, this));
-    channel_->setWriteCallback(std::bind(&TcpConnection::handleWrite, this));
-    channel_->setErrorCallback(std::bind(&TcpConnection::handleError, this));
-    channel_->setCloseCallback(std::bind(&TcpConnection::handleClose, this));
+    channel_.setEventHandlers(&kChannelHandlers, this);
 
-    channel_->enableReading();
+    if (edgeTriggered_) {
+        channel_.setEdgeTriggered(true);
+        channel_.enableReadingAndWriting();
+    } else {
+        channel_.enableReading();
+    }
+    // 建立之前调用过stopRead
+    updateReading();
 
-    if (connectionCallback_) {
-        connectionCallback_(shared_from_this());
+    if (callbacks_->connection) {
+        callbacks_->connection(shared_from_this());
     }
 }
 
 void TcpConnection::connectDestroyed() {
-    if (state_ == kConnected) {
+    if (state_ == kConnected || state_ == kDisconnecting) {
         setState(kDisconnected);
-        channel_->disableAll();
+        channel_.disableAll();
+    }
+    channel_.remove();
+
+    if (idleWheel_ != nullptr) {
+        idleWheel_->remove(&idleEntry_);
     }
-    channel_->remove();
+    loop_->cancelHook(&flushHook_);
+    loop_->cancelHook(&readHook_);
+
+    // 未发出的数据不再计入所属loop的积压统计
+    loop_->addPendingOutputBytes(-static_cast<long>(pendingBytes()));
+
+    // 缓冲区内存在loop线程还给池，之后连接对象可以在任意线程析构
+    inputBuffer_.releaseStorage();
+    outputBuffer_.releaseStorage();
+    outputQueue_.clear();
+    queuedBytes_ = 0;
+    // 内核持有的是页引用，连接关闭后释放用户态内存是安全的
+    zeroCopyInflight_.clear();
 }
 
 void TcpConnection::handleRead() {
+    // 本轮已经由事件触发，排队的续读不再需要
+    loop_->cancelHook(&readHook_);
+    bool deferred = readDeferred_;
+    readDeferred_ = false;
+    if (edgeTriggered_) {
+        handleReadEdgeTriggered(deferred);
+        return;
+    }
+
     int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(socket_.fd(), &savedErrno);
+    ssize_t n = inputBuffer_.readFd(socket_.fd(), &savedErrno, readLimit());
     if (n > 0) {
-        if (messageCallback_) {
-            messageCallback_(shared_from_this(), &inputBuffer_);
+        touchIdle();
+        if (callbacks_->message) {
+            callbacks_->message(shared_from_this(), &inputBuffer_);
         }
     } else if (n == 0) {
         handleClose();
@@ -52,42 +149,221 @@ void TcpConnection::handleRead() {
     }
 }
 
-void TcpConnection::handleWrite() {
-    if (channel_->isWriting()) {
-        ssize_t n = ::write(socket_.fd(), outputBuffer_.peek(),
-                            outputBuffer_.readableBytes());
+// 边缘触发：一直读到EAGAIN或读预算用完，再统一回调一次
+void TcpConnection::handleReadEdgeTriggered(bool deferred) {
+    size_t total = 0;
+    bool peerClosed = false;
+    bool drained = false;
+
+    while (total < readLimit()) {
+        int savedErrno = 0;
+        ssize_t n = inputBuffer_.readFd(socket_.fd(), &savedErrno,
+                                        readLimit() - total);
         if (n > 0) {
-            outputBuffer_.retrieve(n);
+            total += n;
+        } else if (n == 0) {
+            peerClosed = true;
+            break;
+        } else if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+            drained = true;
+            break;
+        } else if (savedErrno != EINTR) {
+            errno = savedErrno;
+            handleError();
+            return;
+        }
+    }
 
-            if (outputBuffer_.readableBytes() == 0) {
-                channel_->disableWriting();
+    if (total > 0) {
+        touchIdle();
+    }
+    // 没有新数据时只在deferRead之后回调，否则回调看到的输入没有变化
+    if ((total > 0 || (deferred && inputBuffer_.readableBytes() > 0)) &&
+        callbacks_->message) {
+        callbacks_->message(shared_from_this(), &inputBuffer_);
+    }
 
-                if (state_ == kDisconnecting) {
-                    shutdownInLoop();
-                }
-            }
+    if (peerClosed) {
+        handleClose();
+    } else if (!drained && state_ != kDisconnected) {
+        // 没有读到EAGAIN就不会再有新的边沿，自己排到下一轮
+        loop_->queueNextIteration(&readHook_);
+    }
+}
+
+void TcpConnection::handleDeferredRead(EventLoop::IterationHook *hook) {
+    static_cast<TcpConnection *>(hook->owner)->resumeRead();
+}
+
+void TcpConnection::resumeRead() {
+    // 暂停读期间不处理；恢复时updateReading会重新排队
+    if (state_ == kDisconnected || !channel_.isReading()) {
+        return;
+    }
+    TcpConnectionPtr guardThis(shared_from_this());
+    bool deferred = readDeferred_;
+    readDeferred_ = false;
+    if (edgeTriggered_) {
+        handleReadEdgeTriggered(deferred);
+    } else if (deferred && inputBuffer_.readableBytes() > 0 &&
+               callbacks_->message) {
+        // 水平触发下socket里还有数据时本轮的事件会先到，这里只处理推迟的输入
+        callbacks_->message(guardThis, &inputBuffer_);
+    }
+}
+
+void TcpConnection::handleWrite() {
+    // 水平触发只写一次，剩下的等下一次EPOLLOUT
+    writeBacklog(edgeTriggered_);
+}
+
+void TcpConnection::writeBacklog(bool drain) {
+    // 水平触发时只有关注了EPOLLOUT才会进来；边缘触发时EPOLLOUT常驻
+    if (!outputPending()) {
+        return;
+    }
+
+    do {
+        ssize_t n = writeOutput();
+        if (n > 0) {
+            consumeOutput(n);
+            loop_->addPendingOutputBytes(-n);
+            touchIdle();
+            checkLowWaterMark();
+        } else if (n == 0 && outputBuffer_.readableBytes() == 0 &&
+                   outputQueue_.front().isFile()) {
+            dropTruncatedFile();
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
         } else {
             handleError();
+            return;
+        }
+    } while (drain && outputPending());
+
+    if (!outputPending()) {
+        if (!edgeTriggered_) {
+            channel_.disableWriting();
+        }
+        writeComplete();
+
+        if (state_ == kDisconnecting) {
+            shutdownInLoop();
         }
     }
 }
 
+void TcpConnection::handleFlush(EventLoop::IterationHook *hook) {
+    static_cast<TcpConnection *>(hook->owner)->flushOutput();
+}
+
+void TcpConnection::flushOutput() {
+    if (state_ == kDisconnected || !outputPending()) {
+        return;
+    }
+    // 写出错时handleClose会回调上层，期间不能析构
+    TcpConnectionPtr guardThis(shared_from_this());
+    writeBacklog(true);
+    // 排队时没有打开EPOLLOUT，写不完的部分交给EPOLLOUT继续
+    if (outputPending() && state_ != kDisconnected && !edgeTriggered_ &&
+        !channel_.isWriting()) {
+        channel_.enableWriting();
+    }
+}
+
+ssize_t TcpConnection::writeOutput() {
+    ssize_t nwrote;
+    if (zeroCopy_ && writeZeroCopy(&nwrote)) {
+        return nwrote;
+    }
+
+    if (outputBuffer_.readableBytes() == 0 && outputQueue_.front().isFile()) {
+        const OutputChunk &chunk = outputQueue_.front();
+        const FileRange &file = std::get<FileRange>(chunk.data);
+        off_t offset = file.offset() + static_cast<off_t>(chunk.offset);
+        return ::sendfile(socket_.fd(), file.fd(), &offset, chunk.size());
+    }
+
+    // 输出缓冲区在前，输出队列在后，一次writev，遇到文件区间为止
+    struct iovec iov[kMaxIovecs];
+    int iovcnt = 0;
+    if (outputBuffer_.readableBytes() > 0) {
+        iov[iovcnt].iov_base = const_cast<char *>(outputBuffer_.peek());
+        iov[iovcnt].iov_len = outputBuffer_.readableBytes();
+        ++iovcnt;
+    }
+    auto it = outputQueue_.begin();
+    for (; it != outputQueue_.end() && !it->isFile() && iovcnt < kMaxIovecs;
+         ++it) {
+        iov[iovcnt].iov_base = const_cast<char *>(it->begin());
+        iov[iovcnt].iov_len = it->size();
+        ++iovcnt;
+    }
+
+    if (msgMore_ && it != outputQueue_.end()) {
+        // 后面还有数据马上要写，告诉内核先不要把不满的报文段发出去
+        struct msghdr msg {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        return ::sendmsg(socket_.fd(), &msg, MSG_MORE);
+    }
+
+    return iovcnt == 1 ? ::write(socket_.fd(), iov[0].iov_base, iov[0].iov_len)
+                       : ::writev(socket_.fd(), iov, iovcnt);
+}
+
+void TcpConnection::dropTruncatedFile() {
+    size_t remaining = outputQueue_.front().size();
+    LOG_ERROR("TcpConnection %s: file truncated, %zu bytes not sent",
+              name_.c_str(), remaining);
+    queuedBytes_ -= remaining;
+    loop_->addPendingOutputBytes(-static_cast<long>(remaining));
+    outputQueue_.pop_front();
+}
+
 void TcpConnection::handleClose() {
-    assert(state_ == kConnected || state_ == kDisconnected);
+    // 同一次事件中可能既有EPOLLHUP又读到0字节，只处理一次
+    if (state_ == kDisconnected) {
+        return;
+    }
+    assert(state_ == kConnected || state_ == kDisconnecting);
     setState(kDisconnected);
-    channel_->disableAll();
+    channel_.disableAll();
+
+    if (idleWheel_ != nullptr) {
+        idleWheel_->remove(&idleEntry_);
+    }
+    loop_->cancelHook(&flushHook_);
+    loop_->cancelHook(&readHook_);
 
     TcpConnectionPtr guardThis(shared_from_this());
 
-    if (connectionCallback_) {
-        connectionCallback_(guardThis);
+    if (callbacks_->connection) {
+        callbacks_->connection(guardThis);
     }
 
-    if (closeCallback_) {
-        closeCallback_(guardThis);
+    if (callbacks_->close) {
+        callbacks_->close(guardThis);
     }
 }
 
+void TcpConnection::handleErrorEvent() {
+    if (zeroCopySends_ > 0) {
+        readZeroCopyCompletions();
+        int err = 0;
+        socklen_t errlen = sizeof(err);
+        if (::getsockopt(socket_.fd(), SOL_SOCKET, SO_ERROR, &err, &errlen) ==
+                0 &&
+            err == 0) {
+            // 只是完成通知
+            return;
+        }
+    }
+    handleError();
+}
+
 void TcpConnection::handleError() {
     int err;
     socklen_t errlen = sizeof(err);
@@ -98,55 +374,644 @@ void TcpConnection::handleError() {
     handleClose();
 }
 
+void TcpConnection::setIdleTimeout(double seconds) {
+    TcpConnectionPtr guardThis(shared_from_this());
+    loop_->runInLoop(
+        [guardThis, seconds]() { guardThis->setIdleTimeoutInLoop(seconds); });
+}
+
+void TcpConnection::setIdleTimeoutInLoop(double seconds) {
+    if (state_ == kDisconnected) {
+        return;
+    }
+
+    if (seconds <= 0) {
+        if (idleWheel_ != nullptr) {
+            idleWheel_->remove(&idleEntry_);
+        }
+        return;
+    }
+
+    idleWheel_ = loop_->idleWheel();
+    idleWheel_->add(&idleEntry_, seconds);
+}
+
+// 时间轮批量回调，每个到期连接调用一次
+void TcpConnection::handleIdleTimeout(TimingWheel::Entry *entry) {
+    TcpConnection *conn = static_cast<TcpConnection *>(entry->owner);
+    if (conn->state_ == kConnected || conn->state_ == kDisconnecting) {
+        TcpConnectionPtr guardThis(conn->shared_from_this());
+        guardThis->handleClose();
+    }
+}
+
+TcpConnection::FileRange::~FileRange() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+TcpConnection::FileRange &
+TcpConnection::FileRange::operator=(FileRange &&other) noexcept {
+    if (this != &other) {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        fd_ = other.fd_;
+        offset_ = other.offset_;
+        len_ = other.len_;
+        other.fd_ = -1;
+    }
+    return *this;
+}
+
+const char *TcpConnection::OutputChunk::begin() const {
+    const char *base;
+    if (const std::string *str = std::get_if<std::string>(&data)) {
+        base = str->data();
+    } else if (const SharedPayload *payload = std::get_if<SharedPayload>(&data)) {
+        base = (*payload)->data();
+    } else if (const Buffer *buf = std::get_if<Buffer>(&data)) {
+        base = buf->peek();
+    } else {
+        return nullptr;
+    }
+    return base + offset;
+}
+
+size_t TcpConnection::OutputChunk::size() const {
+    size_t total;
+    if (const std::string *str = std::get_if<std::string>(&data)) {
+        total = str->size();
+    } else if (const SharedPayload *payload = std::get_if<SharedPayload>(&data)) {
+        total = (*payload)->size();
+    } else if (const Buffer *buf = std::get_if<Buffer>(&data)) {
+        total = buf->readableBytes();
+    } else {
+        total = std::get<FileRange>(data).len();
+    }
+    return total - offset;
+}
+
 void TcpConnection::send(const std::string &message) {
     send(message.data(), message.size());
 }
 
 void TcpConnection::send(const char *data, size_t len) {
     if (state_ == kConnected) {
-        sendInLoop(std::string(data, len));
+        if (loop_->isInLoopThread()) {
+            sendInLoop(data, len);
+        } else {
+            TcpConnectionPtr guardThis(shared_from_this());
+            std::string message(data, len);
+            loop_->runInLoop([guardThis, message = std::move(message)]() mutable {
+                guardThis->sendInLoop(std::move(message));
+            });
+        }
     }
 }
 
-void TcpConnection::sendInLoop(const std::string &message) {
-    ssize_t nwrote = 0;
-    size_t remaining = message.size();
+void TcpConnection::send(std::string &&message) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(std::move(message));
+        } else {
+            TcpConnectionPtr guardThis(shared_from_this());
+            loop_->runInLoop([guardThis, message = std::move(message)]() mutable {
+                guardThis->sendInLoop(std::move(message));
+            });
+        }
+    }
+}
 
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0) {
-        nwrote = ::write(socket_.fd(), message.data(), message.size());
+void TcpConnection::send(Buffer *buf) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(buf);
+        } else {
+            // 池中的Buffer只能在所属loop线程使用，跨线程时拷贝
+            TcpConnectionPtr guardThis(shared_from_this());
+            std::string message = buf->retrieveAllAsString();
+            loop_->runInLoop([guardThis, message = std::move(message)]() mutable {
+                guardThis->sendInLoop(std::move(message));
+            });
+        }
+    }
+}
 
-        if (nwrote >= 0) {
-            remaining = message.size() - nwrote;
+void TcpConnection::sendv(const struct iovec *iov, int iovcnt) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(iov, iovcnt);
         } else {
-            nwrote = 0;
-            if (errno != EWOULDBLOCK) {
-                if (errno == EPIPE || errno == ECONNRESET) {
-                    // 连接断开
-                }
-                handleError();
-                return;
+            TcpConnectionPtr guardThis(shared_from_this());
+            std::string message;
+            for (int i = 0; i < iovcnt; ++i) {
+                message.append(static_cast<const char *>(iov[i].iov_base),
+                               iov[i].iov_len);
             }
+            loop_->runInLoop([guardThis, message = std::move(message)]() mutable {
+                guardThis->sendInLoop(std::move(message));
+            });
+        }
+    }
+}
+
+void TcpConnection::send(const SharedPayload &payload) {
+    if (state_ == kConnected && payload) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(payload);
+        } else {
+            TcpConnectionPtr guardThis(shared_from_this());
+            loop_->runInLoop([guardThis, payload]() {
+                guardThis->sendInLoop(payload);
+            });
         }
     }
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t len) {
+    if (state_ != kConnected || len == 0) {
+        return;
+    }
+    int dupFd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dupFd < 0) {
+        LOG_ERROR("TcpConnection %s: dup fd %d failed: %s", name_.c_str(), fd,
+                  strerror(errno));
+        return;
+    }
+
+    FileRange file(dupFd, offset, len);
+    if (loop_->isInLoopThread()) {
+        sendFileInLoop(std::move(file));
+    } else {
+        // 任务对象必须可拷贝；投递的任务没有执行时fd随shared_ptr关闭
+        TcpConnectionPtr guardThis(shared_from_this());
+        auto shared = std::make_shared<FileRange>(std::move(file));
+        loop_->runInLoop([guardThis, shared]() {
+            guardThis->sendFileInLoop(std::move(*shared));
+        });
+    }
+}
 
+bool TcpConnection::canWriteDirect() {
+    // 已有积压时必须排在后面，保证顺序
+    if (outputPending()) {
+        return false;
+    }
+    if (coalesceWrites_) {
+        // 调用方把数据排进积压，本轮迭代末尾统一写
+        loop_->queueFlush(&flushHook_);
+        return false;
+    }
+    return true;
+}
+
+ssize_t TcpConnection::writeDirect(const char *data, size_t len) {
+    if (!canWriteDirect()) {
+        return 0;
+    }
+    return directWritten(::write(socket_.fd(), data, len));
+}
+
+ssize_t TcpConnection::writeDirect(const struct iovec *iov, int iovcnt) {
+    if (iovcnt == 0 || !canWriteDirect()) {
+        return 0;
+    }
+    iovcnt = std::min(iovcnt, static_cast<int>(kMaxIovecs));
+    return directWritten(::writev(socket_.fd(), iov, iovcnt));
+}
+
+ssize_t TcpConnection::directWritten(ssize_t nwrote) {
+    if (nwrote >= 0) {
+        touchIdle();
+        return nwrote;
+    }
+    if (errno == EWOULDBLOCK || errno == EINTR) {
+        return 0;
+    }
+    if (errno == EPIPE || errno == ECONNRESET) {
+        // 连接断开
+    }
+    handleError();
+    return -1;
+}
+
+void TcpConnection::queueCopy(const char *data, size_t len) {
+    if (len == 0) {
+        return;
+    }
+    if (outputQueue_.empty()) {
+        outputBuffer_.append(data, len);
+    } else if (std::string *tail =
+                   std::get_if<std::string>(&outputQueue_.back().data)) {
+        // 队尾是自己持有的string，接在后面即可
+        tail->append(data, len);
+        queuedBytes_ += len;
+    } else {
+        queueChunk(OutputChunk{std::string(data, len), 0});
+        return;
+    }
+    notePending(len);
+}
+
+void TcpConnection::queueChunk(OutputChunk &&chunk) {
+    size_t len = chunk.size();
+    if (len == 0) {
+        return;
+    }
+    outputQueue_.push_back(std::move(chunk));
+    queuedBytes_ += len;
+    notePending(len);
+}
+
+void TcpConnection::notePending(size_t len) {
+    loop_->addPendingOutputBytes(len);
+    // 边缘触发模式下EPOLLOUT常驻，等待下一次可写边沿即可；
+    // 等待迭代末尾flush时也不必打开，多数情况下一次就能写完
+    if (!edgeTriggered_ && !channel_.isWriting() && !flushHook_.queued) {
+        channel_.enableWriting();
+    }
+
+    size_t pending = pendingBytes();
+    if (pending < highWaterMark_) {
+        return;
+    }
+    if (callbacks_->highWaterMark && pending - len < highWaterMark_) {
+        TcpConnectionPtr guardThis(shared_from_this());
+        loop_->queueInLoop([guardThis, pending]() {
+            guardThis->callbacks_->highWaterMark(guardThis, pending);
+        });
+    }
+    if (pauseReadOnHighWater_ && !outputPaused_) {
+        outputPaused_ = true;
+        updateReading();
+    }
+}
+
+void TcpConnection::writeComplete() {
+    if (callbacks_->writeComplete) {
+        TcpConnectionPtr guardThis(shared_from_this());
+        loop_->queueInLoop([guardThis]() {
+            guardThis->callbacks_->writeComplete(guardThis);
+        });
+    }
+}
+
+void TcpConnection::checkLowWaterMark() {
+    if (outputPaused_ && pendingBytes() <= highWaterMark_ / 2) {
+        outputPaused_ = false;
+        updateReading();
+    }
+}
+
+void TcpConnection::updateReading() {
+    if (state_ != kConnected && state_ != kDisconnecting) {
+        return;
+    }
+    bool want = readWanted_ && !outputPaused_;
+    if (want && !channel_.isReading()) {
+        channel_.enableReading();
+        // 暂停前deferRead推迟的输入没有新事件会再触发
+        if (readDeferred_) {
+            loop_->queueNextIteration(&readHook_);
+        }
+    } else if (!want && channel_.isReading()) {
+        channel_.disableReading();
+    }
+}
+
+void TcpConnection::stopRead() {
+    TcpConnectionPtr guardThis(shared_from_this());
+    loop_->runInLoop([guardThis]() {
+        guardThis->readWanted_ = false;
+        guardThis->updateReading();
+    });
+}
+
+void TcpConnection::startRead() {
+    TcpConnectionPtr guardThis(shared_from_this());
+    loop_->runInLoop([guardThis]() {
+        guardThis->readWanted_ = true;
+        guardThis->updateReading();
+    });
+}
+
+void TcpConnection::consumeOutput(size_t n) {
+    size_t fromBuffer = std::min(n, outputBuffer_.readableBytes());
+    outputBuffer_.retrieve(fromBuffer);
+    n -= fromBuffer;
+
+    while (n > 0) {
+        OutputChunk &chunk = outputQueue_.front();
+        size_t len = chunk.size();
+        if (n < len) {
+            chunk.offset += n;
+            queuedBytes_ -= n;
+            break;
+        }
+        n -= len;
+        queuedBytes_ -= len;
+        // 内核可能还在引用这段内存，等完成通知再释放。完成通知只经错误队列
+        // 送达，停止读且写完后channel不关注任何事件，要保持注册才能收到
+        if (chunk.zeroCopyPending > 0) {
+            zeroCopyInflight_.push_back(std::move(chunk));
+            if (!channel_.isWatchingErrors()) {
+                channel_.enableErrors();
+            }
+        }
+        outputQueue_.pop_front();
+    }
+}
+
+void TcpConnection::setZeroCopy(bool on, size_t minBytes) {
+    TcpConnectionPtr guardThis(shared_from_this());
+    loop_->runInLoop([guardThis, on, minBytes]() {
+        guardThis->setZeroCopyInLoop(on, minBytes);
+    });
+}
+
+void TcpConnection::setZeroCopyInLoop(bool on, size_t minBytes) {
+    if (state_ == kDisconnected) {
+        return;
+    }
+    zeroCopyThreshold_ = minBytes;
+    if (on && !zeroCopy_ && !socket_.setZeroCopy(true)) {
+        LOG_ERROR("TcpConnection %s: SO_ZEROCOPY failed: %s", name_.c_str(),
+                  strerror(errno));
+        return;
+    }
+    // 关闭时保留socket选项，已发出的请求仍会收到完成通知
+    zeroCopy_ = on;
+}
+
+bool TcpConnection::writeZeroCopy(ssize_t *nwrote) {
+    // 只有队头的大分段走零拷贝；它的内存在释放前不会移动
+    // （string足够大不会是SSO，Buffer和共享负载的数据都在堆上）
+    if (outputBuffer_.readableBytes() > 0 || outputQueue_.front().isFile()) {
+        return false;
+    }
+    OutputChunk &chunk = outputQueue_.front();
+    if (!useZeroCopy(chunk.size())) {
+        return false;
+    }
+
+    struct iovec iov = {const_cast<char *>(chunk.begin()), chunk.size()};
+    struct msghdr msg {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    ssize_t n = ::sendmsg(socket_.fd(), &msg, MSG_ZEROCOPY);
+    if (n < 0 && errno == ENOBUFS) {
+        // 锁定页数超过optmem限制，这次退回普通写
+        return false;
+    }
+    if (n >= 0) {
+        if (chunk.zeroCopySends == 0) {
+            chunk.zeroCopyFirst = zeroCopyNextSeq_;
+        }
+        ++chunk.zeroCopySends;
+        ++chunk.zeroCopyPending;
+        ++zeroCopyNextSeq_;
+        ++zeroCopySends_;
+    }
+    *nwrote = n;
+    return true;
+}
+
+void TcpConnection::readZeroCopyCompletions() {
+    char control[128];
+    while (true) {
+        struct msghdr msg {};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof control;
+        if (::recvmsg(socket_.fd(), &msg, MSG_ERRQUEUE) < 0) {
+            break;
+        }
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != nullptr;
+             cm = CMSG_NXTHDR(&msg, cm)) {
+            bool recverr = (cm->cmsg_level == SOL_IP &&
+                            cm->cmsg_type == IP_RECVERR) ||
+                           (cm->cmsg_level == SOL_IPV6 &&
+                            cm->cmsg_type == IPV6_RECVERR);
+            if (!recverr) {
+                continue;
+            }
+            const struct sock_extended_err *err =
+                reinterpret_cast<const struct sock_extended_err *>(
+                    CMSG_DATA(cm));
+            if (err->ee_errno != 0 ||
+                err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            // [ee_info, ee_data] 范围内的发送都已完成
+            if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                zeroCopyCopied_ += err->ee_data - err->ee_info + 1;
+            }
+            completeZeroCopy(err->ee_info, err->ee_data);
+        }
+    }
+
+    // 从队头释放；乱序完成的后续分段等前面的分段完成后一起释放
+    while (!zeroCopyInflight_.empty() &&
+           zeroCopyInflight_.front().zeroCopyPending == 0) {
+        zeroCopyInflight_.pop_front();
+    }
+    if (zeroCopyInflight_.empty() && channel_.isWatchingErrors()) {
+        channel_.disableErrors();
+    }
+}
+
+void TcpConnection::completeZeroCopy(uint32_t first, uint32_t last) {
+    // 通知通常按序到达，但重传、连接关闭等情况下可能乱序，
+    // 不能用一个上界判断，只把区间计入它实际覆盖的分段。同一序号只通知一次
+    auto mark = [first, last](OutputChunk &chunk) {
+        if (chunk.zeroCopyPending == 0) {
+            return;
+        }
+        // 相对分段第一个序号的位置，序号回绕时也成立
+        int64_t lo = static_cast<int32_t>(first - chunk.zeroCopyFirst);
+        int64_t hi = static_cast<int32_t>(last - chunk.zeroCopyFirst);
+        lo = std::max<int64_t>(lo, 0);
+        hi = std::min<int64_t>(hi, chunk.zeroCopySends - 1);
+        if (lo <= hi) {
+            chunk.zeroCopyPending -= static_cast<uint32_t>(hi - lo + 1);
+        }
+    };
+    // 只有输出队列的队头会以零拷贝部分写出
+    if (!outputQueue_.empty()) {
+        mark(outputQueue_.front());
+    }
+    for (OutputChunk &chunk : zeroCopyInflight_) {
+        mark(chunk);
+    }
+}
+
+void TcpConnection::sendInLoop(const char *data, size_t len) {
+    // 跨线程投递的任务执行时连接可能已经关闭
+    if (state_ == kDisconnected) {
+        return;
+    }
+
+    ssize_t nwrote = writeDirect(data, len);
+    if (nwrote < 0) {
+        return;
+    }
     // 如果还没发送完，将剩余数据写入输出缓冲区
-    if (remaining > 0) {
-        outputBuffer_.append(message.data() + nwrote, remaining);
-        if (!channel_->isWriting()) {
-            channel_->enableWriting();
+    queueCopy(data + nwrote, len - nwrote);
+    if (!outputPending()) {
+        writeComplete();
+    }
+}
+
+void TcpConnection::sendInLoop(std::string &&message) {
+    if (state_ == kDisconnected) {
+        return;
+    }
+
+    if (useZeroCopy(message.size())) {
+        // 排进队列，由handleWrite按零拷贝发出
+        queueChunk(OutputChunk{std::move(message), 0});
+        handleWrite();
+        return;
+    }
+
+    ssize_t nwrote = writeDirect(message.data(), message.size());
+    if (nwrote < 0) {
+        return;
+    }
+    queueChunk(OutputChunk{std::move(message), static_cast<size_t>(nwrote)});
+    if (!outputPending()) {
+        writeComplete();
+    }
+}
+
+void TcpConnection::sendInLoop(Buffer *buf) {
+    if (state_ == kDisconnected) {
+        buf->retrieveAll();
+        return;
+    }
+
+    bool zeroCopy = useZeroCopy(buf->readableBytes()) &&
+                    (buf->pool() == nullptr ||
+                     buf->pool() == outputBuffer_.pool());
+    if (zeroCopy) {
+        queueChunk(OutputChunk{std::move(*buf), 0});
+        handleWrite();
+        return;
+    }
+
+    ssize_t nwrote = writeDirect(buf->peek(), buf->readableBytes());
+    if (nwrote < 0) {
+        buf->retrieveAll();
+        return;
+    }
+    buf->retrieve(nwrote);
+    if (buf->readableBytes() == 0) {
+        if (!outputPending()) {
+            writeComplete();
         }
+        return;
+    }
+
+    size_t remaining = buf->readableBytes();
+    if (buf->pool() == outputBuffer_.pool() && !outputPending()) {
+        // 同一个池：交换后buf拿到空的输出缓冲区
+        std::swap(outputBuffer_, *buf);
+        notePending(remaining);
+    } else if (buf->pool() == nullptr || buf->pool() == outputBuffer_.pool()) {
+        queueChunk(OutputChunk{std::move(*buf), 0});
+    } else {
+        // 其他loop的池不能在这里归还，只能拷贝
+        queueCopy(buf->peek(), remaining);
+        buf->retrieveAll();
+    }
+}
+
+void TcpConnection::sendInLoop(const struct iovec *iov, int iovcnt) {
+    if (state_ == kDisconnected) {
+        return;
+    }
+
+    ssize_t nwrote = writeDirect(iov, iovcnt);
+    if (nwrote < 0) {
+        return;
+    }
+    // 跳过已写出的部分，剩下的逐段拷贝
+    size_t skip = static_cast<size_t>(nwrote);
+    for (int i = 0; i < iovcnt; ++i) {
+        const char *base = static_cast<const char *>(iov[i].iov_base);
+        size_t len = iov[i].iov_len;
+        if (skip >= len) {
+            skip -= len;
+            continue;
+        }
+        queueCopy(base + skip, len - skip);
+        skip = 0;
+    }
+    if (!outputPending()) {
+        writeComplete();
+    }
+}
+
+void TcpConnection::sendInLoop(const SharedPayload &payload) {
+    if (state_ == kDisconnected) {
+        return;
+    }
+
+    if (useZeroCopy(payload->size())) {
+        queueChunk(OutputChunk{payload, 0});
+        handleWrite();
+        return;
+    }
+
+    ssize_t nwrote = writeDirect(payload->data(), payload->size());
+    if (nwrote < 0) {
+        return;
+    }
+    queueChunk(OutputChunk{payload, static_cast<size_t>(nwrote)});
+    if (!outputPending()) {
+        writeComplete();
+    }
+}
+
+void TcpConnection::sendFileInLoop(FileRange &&file) {
+    if (state_ == kDisconnected) {
+        return;
+    }
+
+    size_t sent = 0;
+    if (!outputPending()) {
+        off_t offset = file.offset();
+        ssize_t n = ::sendfile(socket_.fd(), file.fd(), &offset, file.len());
+        if (n > 0) {
+            sent = static_cast<size_t>(n);
+            touchIdle();
+        } else if (n == 0) {
+            LOG_ERROR("TcpConnection %s: file shorter than requested range",
+                      name_.c_str());
+            return;
+        } else if (errno != EAGAIN && errno != EINTR) {
+            handleError();
+            return;
+        }
+    }
+    queueChunk(OutputChunk{std::move(file), sent});
+    if (!outputPending()) {
+        writeComplete();
     }
 }
 
 void TcpConnection::shutdown() {
     if (state_ == kConnected) {
         setState(kDisconnecting);
-        shutdownInLoop();
+        TcpConnectionPtr guardThis(shared_from_this());
+        loop_->runInLoop([guardThis]() { guardThis->shutdownInLoop(); });
     }
 }
 
 void TcpConnection::shutdownInLoop() {
-    if (!channel_->isWriting()) {
+    if (!outputPending()) {
         // 关闭写端
         ::shutdown(socket_.fd(), SHUT_WR);
     }
@@ -0,0 +1,297 @@
+#include "TcpServer.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include <cassert>
+#include <future>
+#include <map>
+#include <unistd.h>
+
+TcpServer::TcpServer(EventLoop *loop, const InetAddress &listenAddr)
+    : loop_(loop), listenAddr_(listenAddr), ipPort_(listenAddr.toIpPort()),
+      threadPool_(new EventLoopThreadPool(loop)),
+      highWaterMark_(TcpConnection::kDefaultHighWaterMark),
+      listenMode_(kSingleAcceptor), started_(false), edgeTriggered_(false),
+      maxAcceptsPerWakeup_(Acceptor::kDefaultMaxAcceptsPerWakeup),
+      busyPollUsec_(0), coalesceWrites_(false), msgMore_(false),
+      nextConnId_(1), alive_(std::make_shared<char>()) {}
+
+TcpServer::~TcpServer() {
+    assert(loop_->isInLoopThread());
+
+    for (auto &shard : shards_) {
+        Shard *s = shard.get();
+        runInLoopAndWait(s->loop, [s]() { destroyShard(s); });
+    }
+    // 连接都已销毁，其他线程不会再读alive_
+    alive_.reset();
+}
+
+void TcpServer::destroyShard(Shard *shard) {
+    assert(shard->loop->isInLoopThread());
+    shard->acceptor.reset();
+
+    // 按所在loop逐个销毁连接并等待完成，之后不会再有连接回调访问server
+    std::map<EventLoop *, std::vector<TcpConnectionPtr>> byLoop;
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (TcpConnectionPtr &conn : shard->connections) {
+            byLoop[conn->getLoop()].push_back(std::move(conn));
+        }
+        shard->connections.clear();
+    }
+    for (auto &item : byLoop) {
+        std::vector<TcpConnectionPtr> &conns = item.second;
+        runInLoopAndWait(item.first, [&conns]() {
+            for (const TcpConnectionPtr &conn : conns) {
+                conn->connectDestroyed();
+            }
+        });
+    }
+}
+
+void TcpServer::runInLoopAndWait(EventLoop *loop,
+                                 const std::function<void()> &cb) {
+    if (loop->isInLoopThread()) {
+        cb();
+        return;
+    }
+    std::promise<void> done;
+    loop->runInLoop([&cb, &done]() {
+        cb();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+void TcpServer::setThreadNum(int numThreads) {
+    assert(numThreads >= 0);
+    threadPool_->setThreadNum(numThreads);
+}
+
+void TcpServer::setDistribution(EventLoopThreadPool::Distribution d) {
+    threadPool_->setDistribution(d);
+}
+
+void TcpServer::setLoopSelector(EventLoopThreadPool::LoopSelector selector) {
+    threadPool_->setLoopSelector(std::move(selector));
+}
+
+void TcpServer::setListenMode(ListenMode mode) {
+    assert(!started_);
+    listenMode_ = mode;
+}
+
+void TcpServer::setEdgeTriggered(bool on) {
+    assert(!started_);
+    edgeTriggered_ = on;
+}
+
+void TcpServer::setMaxAcceptsPerWakeup(int n) {
+    assert(!started_);
+    maxAcceptsPerWakeup_ = n;
+}
+
+void TcpServer::setBusyPoll(int usec) {
+    assert(!started_);
+    busyPollUsec_ = usec;
+}
+
+void TcpServer::setWriteCoalescing(bool on, bool msgMore) {
+    assert(!started_);
+    coalesceWrites_ = on;
+    msgMore_ = msgMore;
+}
+
+void TcpServer::setSocketOptions(const SocketOptions &opts) {
+    assert(!started_);
+    socketOptions_ = opts;
+}
+
+void TcpServer::start() {
+    if (started_) {
+        return;
+    }
+    started_ = true;
+
+    threadPool_->start(threadInitCallback_);
+    createShards();
+    for (auto &shard : shards_) {
+        Acceptor *acceptor = shard->acceptor.get();
+        if (shard->loop == loop_) {
+            loop_->runInLoop([acceptor]() { acceptor->listen(); });
+        } else {
+            // 等子循环开始监听再返回，否则先listen的socket会收到所有早到的连接
+            runInLoopAndWait(shard->loop, [acceptor]() { acceptor->listen(); });
+        }
+    }
+}
+
+void TcpServer::createShards() {
+    std::vector<EventLoop *> loops;
+    if (listenMode_ == kSingleAcceptor) {
+        loops.push_back(loop_);
+    } else {
+        loops = threadPool_->getAllLoops();
+    }
+
+    assert(loops.size() <= kMaxShards);
+    for (EventLoop *loop : loops) {
+        std::unique_ptr<Shard> shard(new Shard);
+        shard->loop = loop;
+        shard->index = static_cast<uint32_t>(shards_.size());
+        if (listenMode_ == kExclusive && !shards_.empty()) {
+            // 同一个监听socket，每个loop的epoll各自注册一个dup出来的fd
+            int fd = ::dup(shards_.front()->acceptor->listenFd());
+            if (fd < 0) {
+                LOG_ERROR("TcpServer dup listen socket failed");
+            }
+            shard->acceptor.reset(new Acceptor(loop, Socket(fd)));
+        } else {
+            shard->acceptor.reset(
+                new Acceptor(loop, listenAddr_, listenMode_ == kReusePort));
+        }
+
+        Acceptor *acceptor = shard->acceptor.get();
+        acceptor->setEdgeTriggered(edgeTriggered_);
+        acceptor->setExclusive(listenMode_ == kExclusive);
+        acceptor->setMaxAcceptsPerWakeup(maxAcceptsPerWakeup_);
+        acceptor->applySocketOptions(socketOptions_, ipPort_);
+        Shard *s = shard.get();
+        acceptor->setNewConnectionCallback(
+            [this, s](int sockfd, const InetAddress &peerAddr) {
+                newConnection(s, sockfd, peerAddr);
+            });
+        shards_.push_back(std::move(shard));
+    }
+}
+
+TcpServer::ConnectionId
+TcpServer::makeId(uint32_t shard, SlotMap<TcpConnectionPtr>::Key key) {
+    uint32_t slot = SlotMap<TcpConnectionPtr>::indexOf(key);
+    assert(slot < kMaxSlotsPerShard);
+    return (key & ~static_cast<ConnectionId>(UINT32_MAX)) |
+           (static_cast<ConnectionId>(shard) << kShardShift) | slot;
+}
+
+SlotMap<TcpConnection::TcpConnectionPtr>::Key
+TcpServer::keyOf(ConnectionId id) {
+    return (id & ~static_cast<ConnectionId>(UINT32_MAX)) |
+           (id & (kMaxSlotsPerShard - 1));
+}
+
+TcpServer::Shard *TcpServer::shardOf(ConnectionId id) const {
+    uint32_t index = shardIndexOf(id);
+    return index < shards_.size() ? shards_[index].get() : nullptr;
+}
+
+TcpServer::TcpConnectionPtr TcpServer::getConnection(ConnectionId id) const {
+    Shard *shard = shardOf(id);
+    if (shard == nullptr) {
+        return TcpConnectionPtr();
+    }
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    const TcpConnectionPtr *conn = shard->connections.find(keyOf(id));
+    return conn == nullptr ? TcpConnectionPtr() : *conn;
+}
+
+size_t TcpServer::numConnections() const {
+    size_t n = 0;
+    for (const auto &shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        n += shard->connections.size();
+    }
+    return n;
+}
+
+TcpConnection::CallbacksPtr TcpServer::connCallbacks() {
+    TcpConnection::CallbacksPtr current = std::atomic_load(&connCallbacks_);
+    if (current) {
+        return current;
+    }
+    // 分片模式下几个loop可能同时生成，内容相同，谁写进去都可以
+    auto callbacks = std::make_shared<TcpConnection::Callbacks>();
+    callbacks->connection = connectionCallback_;
+    callbacks->message = messageCallback_;
+    callbacks->close = [this](const TcpConnectionPtr &c) {
+        removeConnection(c);
+    };
+    callbacks->writeComplete = writeCompleteCallback_;
+    callbacks->highWaterMark = highWaterMarkCallback_;
+    current = std::move(callbacks);
+    std::atomic_store(&connCallbacks_, current);
+    return current;
+}
+
+void TcpServer::newConnection(Shard *shard, int sockfd,
+                              const InetAddress &peerAddr) {
+    assert(shard->loop->isInLoopThread());
+
+    // 分片模式下连接留在accept它的loop上
+    EventLoop *ioLoop = listenMode_ == kSingleAcceptor
+                            ? threadPool_->getNextLoop()
+                            : shard->loop;
+    std::string connName =
+        ipPort_ + "#" +
+        std::to_string(nextConnId_.fetch_add(1, std::memory_order_relaxed));
+
+    LOG_TRACE("TcpServer::newConnection [%s] from %s", connName.c_str(),
+              peerAddr.toIpPort().c_str());
+
+    // Acceptor用accept4拿到的fd已经是非阻塞的
+    Socket socket(sockfd);
+    if (busyPollUsec_ > 0 && !socket.setBusyPoll(busyPollUsec_)) {
+        LOG_ERROR("TcpServer::newConnection [%s] SO_BUSY_POLL failed: %s",
+                  connName.c_str(), socket.getLastError().c_str());
+    }
+    socketOptions_.applyToConnection(socket, connName);
+
+    TcpConnectionPtr conn =
+        TcpConnection::create(ioLoop, std::move(socket), connName);
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        conn->setId(makeId(shard->index, shard->connections.insert(conn)));
+    }
+    // 立即计数，避免连接风暴时最少连接策略读到过期的数值
+    ioLoop->addConnections(1);
+
+    conn->setEdgeTriggered(edgeTriggered_);
+    conn->setWriteCoalescing(coalesceWrites_, msgMore_);
+    conn->setCallbacks(connCallbacks());
+    conn->setHighWaterMark(highWaterMark_);
+
+    ioLoop->runInLoop([conn]() { conn->connectEstablished(); });
+}
+
+// 在ioLoop线程中被调用，转回连接表所在的loop修改
+void TcpServer::removeConnection(const TcpConnectionPtr &conn) {
+    Shard *shard = shardOf(conn->id());
+    if (shard->loop->isInLoopThread()) {
+        removeConnectionInLoop(shard, conn);
+        return;
+    }
+    // 排队期间server可能已经析构，连接也已在析构时销毁，这时直接丢弃；
+    // 检查和析构都在shard的loop线程中，不会交错
+    std::weak_ptr<void> alive = alive_;
+    shard->loop->queueInLoop([this, alive, shard, conn]() {
+        if (!alive.expired()) {
+            removeConnectionInLoop(shard, conn);
+        }
+    });
+}
+
+void TcpServer::removeConnectionInLoop(Shard *shard,
+                                       const TcpConnectionPtr &conn) {
+    assert(shard->loop->isInLoopThread());
+
+    bool erased;
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        erased = shard->connections.erase(keyOf(conn->id()));
+    }
+    assert(erased);
+    (void)erased;
+
+    EventLoop *ioLoop = conn->getLoop();
+    ioLoop->addConnections(-1);
+    ioLoop->queueInLoop([conn]() { conn->connectDestroyed(); });
+}
@@ -0,0 +1,272 @@
+#include "TimerQueue.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include <cassert>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+
+int createTimerfd() {
+    int timerfd =
+        ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0) {
+        LOG_ERROR("timerfd_create failed");
+    }
+    return timerfd;
+}
+
+int64_t toNanos(TimePoint tp) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               tp.time_since_epoch())
+        .count();
+}
+
+int64_t nowNanos() { return toNanos(TimerClock::now()); }
+
+} // namespace
+
+TimerQueue::TimerQueue(EventLoop *loop)
+    : loop_(loop), timerfd_(createTimerfd()), timerfdChannel_(loop, timerfd_),
+      nextSequence_(0), callingExpiredTimers_(false), armedAt_(0) {
+    timerfdChannel_.setReadCallback([this]() { handleRead(); });
+    timerfdChannel_.enableReading();
+}
+
+TimerQueue::~TimerQueue() {
+    timerfdChannel_.disableAll();
+    timerfdChannel_.remove();
+    ::close(timerfd_);
+}
+
+TimerId TimerQueue::addTimer(TimerCallback cb, TimePoint when,
+                             TimerClock::duration interval) {
+    // 槽位在调用线程分配，句柄可以立即返回
+    TimerId id = allocSlot();
+    int64_t whenNs = toNanos(when);
+    int64_t intervalNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count();
+
+    if (loop_->isInLoopThread()) {
+        addTimerInLoop(id, std::move(cb), whenNs, intervalNs);
+    } else {
+        loop_->queueInLoop(
+            [this, id, cb = std::move(cb), whenNs, intervalNs]() mutable {
+                addTimerInLoop(id, std::move(cb), whenNs, intervalNs);
+            });
+    }
+    return id;
+}
+
+void TimerQueue::cancel(TimerId timerId) {
+    if (!timerId.valid()) {
+        return;
+    }
+    loop_->runInLoop([this, timerId]() { cancelInLoop(timerId); });
+}
+
+void TimerQueue::addTimerInLoop(TimerId id, TimerCallback cb, int64_t when,
+                                int64_t interval) {
+    uint32_t slot = id.slot();
+    if (slot >= timers_.size()) {
+        // 中间的槽位属于还没执行到的跨线程addTimer，id为0，取消时不会匹配
+        timers_.resize(slot + 1);
+    }
+    Timer &timer = timers_[slot];
+    timer.callback = std::move(cb);
+    timer.interval = interval;
+    timer.id = id.value();
+    timer.heapIndex = kNoIndex;
+    timer.cancelled = false;
+
+    heapPush(HeapEntry{when, nextSequence_++, slot});
+
+    // 处理到期定时器期间统一在最后rearm
+    if (!callingExpiredTimers_ && (armedAt_ == 0 || when < armedAt_)) {
+        rearm();
+    }
+}
+
+void TimerQueue::cancelInLoop(TimerId id) {
+    uint32_t slot = id.slot();
+    if (slot >= timers_.size() || timers_[slot].id != id.value()) {
+        // 已经到期或已经取消，槽位可能已被复用
+        return;
+    }
+
+    Timer &timer = timers_[slot];
+    if (timer.heapIndex == kNoIndex) {
+        // 在本轮到期批次中（可能正在执行自身回调），处理完后再回收
+        timer.cancelled = true;
+        return;
+    }
+
+    heapRemove(timer.heapIndex);
+    freeSlot(slot);
+    // 不主动rearm：timerfd提前触发时handleRead发现没有到期定时器会重新设置
+}
+
+void TimerQueue::handleRead() {
+    assert(loop_->isInLoopThread());
+
+    uint64_t howmany;
+    ssize_t n = ::read(timerfd_, &howmany, sizeof howmany);
+    (void)n;
+    armedAt_ = 0;
+
+    int64_t now = nowNanos();
+
+    // 一次取出所有到期的定时器
+    expired_.clear();
+    while (!heap_.empty() && heap_[0].when <= now) {
+        uint32_t slot = heap_[0].slot;
+        heapRemove(0);
+        expired_.push_back(slot);
+    }
+
+    callingExpiredTimers_ = true;
+    for (uint32_t slot : expired_) {
+        // timers_是deque，回调中新增定时器不会使引用失效
+        Timer &timer = timers_[slot];
+        if (!timer.cancelled) {
+            timer.callback();
+        }
+    }
+    callingExpiredTimers_ = false;
+
+    for (uint32_t slot : expired_) {
+        Timer &timer = timers_[slot];
+        if (timer.interval > 0 && !timer.cancelled) {
+            heapPush(HeapEntry{now + timer.interval, nextSequence_++, slot});
+        } else {
+            freeSlot(slot);
+        }
+    }
+
+    rearm();
+}
+
+TimerId TimerQueue::allocSlot() {
+    std::lock_guard<std::mutex> lock(slotMutex_);
+    uint32_t slot;
+    if (!freeSlots_.empty()) {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(generations_.size());
+        generations_.push_back(0);
+    }
+    // 回绕时跳过0，0留给无效句柄
+    uint32_t generation = ++generations_[slot];
+    if (generation == 0) {
+        generation = ++generations_[slot];
+    }
+    return TimerId(slot, generation);
+}
+
+void TimerQueue::freeSlot(uint32_t slot) {
+    Timer &timer = timers_[slot];
+    // 释放回调持有的资源
+    timer.callback = nullptr;
+    timer.id = 0;
+    timer.heapIndex = kNoIndex;
+    std::lock_guard<std::mutex> lock(slotMutex_);
+    freeSlots_.push_back(slot);
+}
+
+void TimerQueue::place(uint32_t index, const HeapEntry &entry) {
+    heap_[index] = entry;
+    timers_[entry.slot].heapIndex = index;
+}
+
+void TimerQueue::heapPush(HeapEntry entry) {
+    heap_.push_back(entry);
+    uint32_t index = static_cast<uint32_t>(heap_.size() - 1);
+    timers_[entry.slot].heapIndex = index;
+    siftUp(index);
+}
+
+void TimerQueue::heapRemove(uint32_t index) {
+    assert(index < heap_.size());
+    timers_[heap_[index].slot].heapIndex = kNoIndex;
+
+    uint32_t last = static_cast<uint32_t>(heap_.size() - 1);
+    if (index != last) {
+        place(index, heap_[last]);
+        heap_.pop_back();
+        // 被移到index的元素可能需要上浮也可能需要下沉
+        if (index > 0 && earlier(heap_[index], heap_[(index - 1) / 4])) {
+            siftUp(index);
+        } else {
+            siftDown(index);
+        }
+    } else {
+        heap_.pop_back();
+    }
+}
+
+void TimerQueue::siftUp(uint32_t index) {
+    HeapEntry entry = heap_[index];
+    while (index > 0) {
+        uint32_t parent = (index - 1) / 4;
+        if (!earlier(entry, heap_[parent])) {
+            break;
+        }
+        place(index, heap_[parent]);
+        index = parent;
+    }
+    place(index, entry);
+}
+
+void TimerQueue::siftDown(uint32_t index) {
+    const uint32_t size = static_cast<uint32_t>(heap_.size());
+    HeapEntry entry = heap_[index];
+    while (true) {
+        uint32_t first = index * 4 + 1;
+        if (first >= size) {
+            break;
+        }
+        // 4个子节点相邻存放，通常在同一条cache line内
+        uint32_t best = first;
+        uint32_t end = std::min(first + 4, size);
+        for (uint32_t child = first + 1; child < end; ++child) {
+            if (earlier(heap_[child], heap_[best])) {
+                best = child;
+            }
+        }
+        if (!earlier(heap_[best], entry)) {
+            break;
+        }
+        place(index, heap_[best]);
+        index = best;
+    }
+    place(index, entry);
+}
+
+void TimerQueue::rearm() {
+    if (heap_.empty()) {
+        if (armedAt_ != 0) {
+            struct itimerspec disarm {};
+            ::timerfd_settime(timerfd_, TFD_TIMER_ABSTIME, &disarm, nullptr);
+            armedAt_ = 0;
+        }
+        return;
+    }
+
+    int64_t when = heap_[0].when;
+    if (when == armedAt_) {
+        return;
+    }
+
+    struct itimerspec value {};
+    value.it_value.tv_sec = static_cast<time_t>(when / 1000000000);
+    value.it_value.tv_nsec = static_cast<long>(when % 1000000000);
+    // 绝对时间为0会被当作关闭定时器
+    if (value.it_value.tv_sec == 0 && value.it_value.tv_nsec == 0) {
+        value.it_value.tv_nsec = 1;
+    }
+    if (::timerfd_settime(timerfd_, TFD_TIMER_ABSTIME, &value, nullptr) < 0) {
+        LOG_ERROR("timerfd_settime failed");
+    }
+    armedAt_ = when;
+}
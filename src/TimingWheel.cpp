@@ -0,0 +1,134 @@
+#include "TimingWheel.h"
+#include "EventLoop.h"
+#include <cassert>
+#include <cmath>
+
+TimingWheel::TimingWheel(EventLoop *loop, double tickSeconds,
+                         size_t numBuckets)
+    : loop_(loop), tickSeconds_(tickSeconds), buckets_(numBuckets, nullptr),
+      currentTick_(0), size_(0) {
+    assert(numBuckets > 0);
+}
+
+TimingWheel::~TimingWheel() {
+    stopTicking();
+    for (Entry *head : buckets_) {
+        while (head != nullptr) {
+            Entry *next = head->next;
+            head->prev = head->next = nullptr;
+            head->linked = false;
+            head = next;
+        }
+    }
+}
+
+void TimingWheel::add(Entry *entry, double timeoutSeconds) {
+    if (entry->linked) {
+        unlink(entry);
+    }
+
+    double ticks = std::ceil(timeoutSeconds / tickSeconds_);
+    entry->timeout = ticks < 1 ? 1 : static_cast<uint32_t>(ticks);
+    entry->lastActive = currentTick_;
+    link(entry, currentTick_ + entry->timeout);
+    startTicking();
+}
+
+void TimingWheel::remove(Entry *entry) {
+    if (entry->linked) {
+        unlink(entry);
+        if (size_ == 0) {
+            stopTicking();
+        }
+    }
+}
+
+void TimingWheel::tick() {
+    ++currentTick_;
+
+    // 整条链表先摘下来，重新挂回时可能落在同一个槽
+    size_t index = currentTick_ % buckets_.size();
+    Entry *entry = buckets_[index];
+    buckets_[index] = nullptr;
+
+    expired_.clear();
+    while (entry != nullptr) {
+        Entry *next = entry->next;
+        entry->prev = entry->next = nullptr;
+
+        if (entry->rounds > 0) {
+            --entry->rounds;
+            entry->next = buckets_[index];
+            if (entry->next != nullptr) {
+                entry->next->prev = entry;
+            }
+            buckets_[index] = entry;
+        } else {
+            uint64_t deadline = entry->lastActive + entry->timeout;
+            --size_;
+            entry->linked = false;
+            if (deadline <= currentTick_) {
+                expired_.push_back(entry);
+            } else {
+                // 期间有活动，按新的截止时间重新挂入
+                link(entry, deadline);
+            }
+        }
+        entry = next;
+    }
+
+    // 批量回调；回调中可以安全地remove/add其他条目
+    for (Entry *e : expired_) {
+        if (!e->linked && e->onExpire != nullptr) {
+            e->onExpire(e);
+        }
+    }
+
+    if (size_ == 0) {
+        stopTicking();
+    }
+}
+
+void TimingWheel::startTicking() {
+    if (loop_ != nullptr && !tickTimer_.valid()) {
+        tickTimer_ = loop_->runEvery(tickSeconds_, [this]() { tick(); });
+    }
+}
+
+void TimingWheel::stopTicking() {
+    if (tickTimer_.valid()) {
+        loop_->cancel(tickTimer_);
+        tickTimer_ = TimerId();
+    }
+}
+
+void TimingWheel::link(Entry *entry, uint64_t deadline) {
+    assert(deadline > currentTick_);
+    uint64_t delta = deadline - currentTick_;
+    size_t index = deadline % buckets_.size();
+
+    entry->rounds = static_cast<uint32_t>((delta - 1) / buckets_.size());
+    entry->bucket = static_cast<uint32_t>(index);
+    entry->prev = nullptr;
+    entry->next = buckets_[index];
+    if (entry->next != nullptr) {
+        entry->next->prev = entry;
+    }
+    buckets_[index] = entry;
+    entry->linked = true;
+    ++size_;
+}
+
+void TimingWheel::unlink(Entry *entry) {
+    if (entry->prev != nullptr) {
+        entry->prev->next = entry->next;
+    } else {
+        buckets_[entry->bucket] = entry->next;
+    }
+    if (entry->next != nullptr) {
+        entry->next->prev = entry->prev;
+    }
+    entry->prev = entry->next = nullptr;
+    entry->linked = false;
+    --size_;
+}
@@ -1,6 +1,8 @@
 #include "../include/Buffer.h"
 #include <cassert>
+#include <algorithm>
 #include <cstring>
+#include <sys/socket.h>
 #include <unistd.h>
 #include <iostream>
 
@@ -226,6 +228,244 @@ TEST(test_buffer_readfd_large) {
     close(pipefd[1]);
 }
 
+// 测试 10: 使用内存池的Buffer懒分配，读空后归还
+TEST(test_buffer_pooled_lazy) {
+    BufferPool pool;
+    Buffer buf(&pool);
+
+    // 未写入前不占内存，peek仍然有效
+    assert(buf.capacity() == 0);
+    assert(buf.readableBytes() == 0);
+    assert(buf.writableBytes() == 0);
+    assert(buf.peek() != nullptr);
+    assert(pool.inUseBytes() == 0);
+
+    buf.append("hello", 5);
+    assert(buf.capacity() == BufferPool::kMinBlockSize);
+    assert(pool.inUseBytes() == BufferPool::kMinBlockSize);
+
+    // 增长到更大的级别
+    std::string large(5000, 'x');
+    buf.append(large);
+    assert(buf.capacity() == 8192);
+    assert(buf.retrieveAsString(5) == "hello");
+    assert(buf.readableBytes() == 5000);
+
+    // 读空后整块还给池，池缓存下来供下次复用
+    buf.retrieveAll();
+    assert(buf.capacity() == 0);
+    assert(pool.inUseBytes() == 0);
+    assert(pool.cachedBytes() == 8192 + BufferPool::kMinBlockSize);
+
+    buf.append(large);
+    assert(pool.cachedBytes() == BufferPool::kMinBlockSize);
+
+    // 预留头部在懒分配后仍然可用
+    buf.retrieve(4000);
+    buf.append(large);
+    assert(buf.prependableBytes() == Buffer::kCheapPrepend);
+    assert(buf.readableBytes() == 6000);
+
+    buf.releaseStorage();
+    assert(pool.inUseBytes() == 0);
+}
+
+// 测试 11: 独立Buffer读空后收缩过大的容量
+TEST(test_buffer_shrink_after_drain) {
+    Buffer buf;
+    std::string large(Buffer::kMaxRetainedSize * 2, 'x');
+    buf.append(large);
+    assert(buf.capacity() > Buffer::kMaxRetainedSize);
+
+    buf.retrieveAll();
+    assert(buf.capacity() == Buffer::kCheapPrepend + Buffer::kInitialSize);
+    assert(buf.writableBytes() == Buffer::kInitialSize);
+
+    // 小容量读空后保持不变
+    buf.append("abc", 3);
+    buf.retrieveAll();
+    assert(buf.capacity() == Buffer::kCheapPrepend + Buffer::kInitialSize);
+}
+
+// 测试 12: readFd 预留大小随读取量自适应
+TEST(test_buffer_readfd_adaptive) {
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Buffer buf;
+    assert(buf.readHint() == Buffer::kInitialReadHint);
+
+    // 每次都读满预留空间，预留翻倍
+    std::string chunk(64 * 1024, 'x');
+    int savedErrno = 0;
+    for (int i = 0; i < 3; ++i) {
+        assert(write(fds[1], chunk.data(), chunk.size()) ==
+               static_cast<ssize_t>(chunk.size()));
+        size_t got = 0;
+        while (got < chunk.size()) {
+            ssize_t n = buf.readFd(fds[0], &savedErrno);
+            assert(n > 0);
+            got += n;
+        }
+        buf.retrieveAll();
+    }
+    size_t grown = buf.readHint();
+    assert(grown > Buffer::kInitialReadHint);
+
+    // 预留足够后数据直接落进Buffer，不经溢出区
+    uint64_t copiedBefore = Buffer::overflowCopiedBytes();
+    assert(write(fds[1], "hello", 5) == 5);
+    assert(buf.readFd(fds[0], &savedErrno) == 5);
+    assert(Buffer::overflowCopiedBytes() == copiedBefore);
+    assert(buf.retrieveAllAsString() == "hello");
+
+    // 连续的小读取让预留缩回
+    for (int i = 0; i < 40; ++i) {
+        assert(write(fds[1], "x", 1) == 1);
+        assert(buf.readFd(fds[0], &savedErrno) == 1);
+        buf.retrieveAll();
+    }
+    assert(buf.readHint() < grown);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// 测试 13: 视图、prepend 与网络字节序整数
+TEST(test_buffer_view_prepend_int) {
+    Buffer buf;
+    buf.append(std::string_view("payload"));
+
+    // 事后补长度头，不移动数据
+    const char* body = buf.peek();
+    buf.prependInt32(7);
+    assert(buf.peek() + 4 == body);
+    assert(buf.readableBytes() == 11);
+    assert(buf.peekInt32() == 7);
+    // 大端
+    assert(buf.peek()[0] == 0 && buf.peek()[3] == 7);
+
+    assert(buf.readInt32() == 7);
+    std::string_view view = buf.consume(3);
+    assert(view == "pay");
+    assert(buf.toStringView() == "load");
+    buf.retrieveAll();
+
+    buf.appendInt8(-1);
+    buf.appendInt16(0x1234);
+    buf.appendInt32(-123456);
+    buf.appendInt64(0x0102030405060708LL);
+    assert(buf.readableBytes() == 15);
+    assert(static_cast<unsigned char>(buf.peek()[1]) == 0x12);
+    assert(buf.readInt8() == -1);
+    assert(buf.readInt16() == 0x1234);
+    assert(buf.readInt32() == -123456);
+    assert(buf.peekInt64() == 0x0102030405060708LL);
+    assert(buf.readInt64() == 0x0102030405060708LL);
+    assert(buf.readableBytes() == 0);
+
+    // kCheapPrepend 正好放得下一个64位头部
+    buf.appendInt8(1);
+    buf.prependInt64(-2);
+    assert(buf.prependableBytes() == 0);
+    assert(buf.readInt64() == -2);
+    assert(buf.readInt8() == 1);
+}
+
+// 测试 14: 懒分配的Buffer上prepend
+TEST(test_buffer_prepend_lazy) {
+    BufferPool pool;
+    Buffer buf(&pool);
+
+    buf.prependInt32(42);
+    assert(buf.capacity() > 0);
+    assert(buf.readableBytes() == 4);
+    assert(buf.readInt32() == 42);
+
+    // 共享的空存储没有被写
+    Buffer other(&pool);
+    assert(other.capacity() == 0);
+}
+
+// 测试 15: 各级实现的查找结果与std::search一致，覆盖向量边界和尾部
+TEST(test_buffer_find_levels) {
+    const ByteSearch::Level saved = ByteSearch::level();
+    const ByteSearch::Level levels[] = {ByteSearch::kScalar, ByteSearch::kSse2,
+                                        ByteSearch::kAvx2};
+    const std::string needles[] = {"\n", "\r\n", "\r\n\r\n", "abc"};
+
+    for (ByteSearch::Level level : levels) {
+        ByteSearch::setLevel(level);
+        for (size_t len = 0; len < 100; ++len) {
+            for (size_t pos = 0; pos <= len; pos += 7) {
+                for (const std::string& needle : needles) {
+                    // 分隔符的各个字节单独出现不能误判
+                    std::string data(len, 'x');
+                    for (size_t i = 0; i + 1 < len; i += 5) {
+                        data[i] = needle[needle.size() - 1];
+                        data[i + 1] = needle[0];
+                    }
+                    if (pos + needle.size() <= len) {
+                        data.replace(pos, needle.size(), needle);
+                    }
+                    auto it = std::search(data.begin(), data.end(),
+                                          needle.begin(), needle.end());
+                    const char* expect = it == data.end()
+                        ? nullptr : data.data() + (it - data.begin());
+                    const char* got = ByteSearch::find(data.data(), data.size(),
+                                                       needle);
+                    assert(got == expect);
+                }
+            }
+        }
+    }
+    ByteSearch::setLevel(saved);
+}
+
+// 测试 16: findCRLF/findEOL/find 以及分多次到达时不重复扫描
+TEST(test_buffer_find) {
+    Buffer buf;
+    assert(buf.findCRLF() == nullptr);
+
+    buf.append("GET / HTTP/1.1\r");
+    assert(buf.findCRLF() == nullptr);
+    assert(buf.findEOL() == nullptr);
+    // 跨两次到达的\r\n
+    buf.append("\nHost: a\r\n\r\n");
+    const char* crlf = buf.findCRLF();
+    assert(crlf == buf.peek() + 14);
+    assert(buf.findEOL() == buf.peek() + 15);
+    assert(buf.find('H') == buf.peek() + 6);
+    assert(buf.find(std::string_view("\r\n\r\n")) == buf.peek() + 23);
+    assert(buf.find(std::string_view("nope")) == nullptr);
+
+    // 逐行取出
+    std::string_view line = buf.consume(crlf - buf.peek());
+    assert(line == "GET / HTTP/1.1");
+    buf.retrieve(2);
+    crlf = buf.findCRLF();
+    assert(std::string_view(buf.peek(), crlf - buf.peek()) == "Host: a");
+    buf.retrieve(crlf - buf.peek() + 2);
+    assert(buf.findCRLF() == buf.peek());
+    buf.retrieveAll();
+
+    // 逐字节到达的长行，结果不受缓存影响
+    std::string longLine(5000, 'a');
+    for (char c : longLine) {
+        buf.append(&c, 1);
+        assert(buf.findCRLF() == nullptr);
+    }
+    buf.append("\r\n");
+    assert(buf.findCRLF() == buf.peek() + 5000);
+
+    // 前面插入数据后重新扫描
+    buf.retrieveAll();
+    buf.append("abc");
+    assert(buf.find('\n') == nullptr);
+    buf.prepend("\n", 1);
+    assert(buf.find('\n') == buf.peek());
+}
+
 int main() {
     RUN_TEST(test_buffer_append_retrieve);
     RUN_TEST(test_buffer_growth);
@@ -236,6 +476,13 @@ int main() {
     RUN_TEST(test_buffer_empty);
     RUN_TEST(test_buffer_retrieve_partial);
     RUN_TEST(test_buffer_readfd_large);
+    RUN_TEST(test_buffer_pooled_lazy);
+    RUN_TEST(test_buffer_shrink_after_drain);
+    RUN_TEST(test_buffer_readfd_adaptive);
+    RUN_TEST(test_buffer_view_prepend_int);
+    RUN_TEST(test_buffer_prepend_lazy);
+    RUN_TEST(test_buffer_find_levels);
+    RUN_TEST(test_buffer_find);
 
     std::cout << "\n=== All Buffer Tests Passed ===" << std::endl;
     return 0;
@@ -0,0 +1,184 @@
+#include "../include/ChainBuffer.h"
+#include <cassert>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define TEST(name) void name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " << #name << "..."; \
+    name(); \
+    std::cout << " PASSED" << std::endl; \
+} while(0)
+
+static std::string pattern(size_t len) {
+    std::string s(len, '\0');
+    for (size_t i = 0; i < len; ++i) {
+        s[i] = static_cast<char>('a' + i % 26);
+    }
+    return s;
+}
+
+// 测试 1: 基本的 append 和 retrieve
+TEST(test_chainbuffer_append_retrieve) {
+    ChainBuffer buf;
+    assert(buf.readableBytes() == 0);
+    assert(buf.numBlocks() == 0);
+
+    buf.append("hello", 5);
+    assert(buf.readableBytes() == 5);
+    assert(buf.numBlocks() == 1);
+    assert(std::string(buf.peek(), 5) == "hello");
+
+    buf.retrieve(2);
+    assert(buf.retrieveAllAsString() == "llo");
+    assert(buf.readableBytes() == 0);
+    assert(buf.numBlocks() == 0);
+}
+
+// 测试 2: 跨块追加，已有数据不搬移
+TEST(test_chainbuffer_span_blocks) {
+    ChainBuffer buf;
+    std::string data = pattern(ChainBuffer::kBlockSize * 3 + 100);
+
+    buf.append(data.data(), 10);
+    size_t len;
+    const char *first = buf.firstSegment(&len);
+    buf.append(data.data() + 10, data.size() - 10);
+
+    // 第一个块的地址不变
+    assert(buf.firstSegment(&len) == first);
+    assert(len == ChainBuffer::kBlockSize);
+    assert(buf.numBlocks() == 4);
+    assert(buf.readableBytes() == data.size());
+
+    // peek合并后得到完整的连续数据
+    assert(std::string(buf.peek(), buf.readableBytes()) == data);
+}
+
+// 测试 3: retrieve 整块释放
+TEST(test_chainbuffer_retrieve_blocks) {
+    ChainBuffer buf;
+    std::string data = pattern(ChainBuffer::kBlockSize * 4);
+    buf.append(data);
+    assert(buf.numBlocks() == 4);
+
+    buf.retrieve(ChainBuffer::kBlockSize + 1);
+    assert(buf.numBlocks() == 3);
+    assert(buf.readableBytes() == data.size() - ChainBuffer::kBlockSize - 1);
+
+    std::string rest = buf.retrieveAsString(ChainBuffer::kBlockSize);
+    assert(rest == data.substr(ChainBuffer::kBlockSize + 1,
+                               ChainBuffer::kBlockSize));
+    assert(buf.numBlocks() == 2);
+
+    assert(buf.retrieveAllAsString() ==
+           data.substr(ChainBuffer::kBlockSize * 2 + 1));
+    assert(buf.numBlocks() == 0);
+}
+
+// 测试 4: readFd 超过尾块剩余空间
+TEST(test_chainbuffer_readfd) {
+    ChainBuffer buf;
+    buf.append(pattern(ChainBuffer::kBlockSize - 10));
+
+    int pipefd[2];
+    assert(pipe(pipefd) == 0);
+    std::string msg = pattern(100);
+    assert(write(pipefd[1], msg.data(), msg.size()) ==
+           static_cast<ssize_t>(msg.size()));
+
+    int savedErrno = 0;
+    ssize_t n = buf.readFd(pipefd[0], &savedErrno);
+    assert(n == 100);
+    assert(buf.numBlocks() == 2);
+    assert(buf.readableBytes() == ChainBuffer::kBlockSize + 90);
+
+    buf.retrieve(ChainBuffer::kBlockSize - 10);
+    assert(buf.retrieveAllAsString() == msg);
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+// 测试 5: writeFd 用 writev 写出多个块，部分写后继续
+TEST(test_chainbuffer_writefd) {
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    ChainBuffer buf;
+    std::string data = pattern(1024 * 1024);
+    buf.append(data);
+
+    std::string received;
+    char tmp[65536];
+    while (buf.readableBytes() > 0) {
+        int savedErrno = 0;
+        ssize_t n = buf.writeFd(fds[0], &savedErrno);
+        assert(n > 0 || savedErrno == EAGAIN);
+        ssize_t r = read(fds[1], tmp, sizeof tmp);
+        if (r > 0) {
+            received.append(tmp, r);
+        }
+    }
+    while (received.size() < data.size()) {
+        ssize_t r = read(fds[1], tmp, sizeof tmp);
+        assert(r > 0);
+        received.append(tmp, r);
+    }
+
+    assert(received == data);
+    assert(buf.numBlocks() == 0);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+// 测试 6: 移动
+TEST(test_chainbuffer_move) {
+    ChainBuffer a;
+    a.append(pattern(ChainBuffer::kBlockSize * 2));
+
+    ChainBuffer b(std::move(a));
+    assert(a.readableBytes() == 0);
+    assert(b.readableBytes() == ChainBuffer::kBlockSize * 2);
+
+    a = std::move(b);
+    assert(a.retrieveAllAsString() == pattern(ChainBuffer::kBlockSize * 2));
+}
+
+// 测试 7: 空缓冲区上readFd读到EOF
+TEST(test_chainbuffer_readfd_eof_empty) {
+    ChainBuffer buf;
+    int pipefd[2];
+    assert(pipe(pipefd) == 0);
+    close(pipefd[1]);
+
+    int savedErrno = 0;
+    assert(buf.readFd(pipefd[0], &savedErrno) == 0);
+    assert(buf.readableBytes() == 0);
+    assert(buf.numBlocks() == 0);
+
+    // 已有数据时EOF也不改变内容
+    buf.append(pattern(10));
+    assert(buf.readFd(pipefd[0], &savedErrno) == 0);
+    assert(buf.retrieveAllAsString() == pattern(10));
+
+    close(pipefd[0]);
+}
+
+int main() {
+    RUN_TEST(test_chainbuffer_append_retrieve);
+    RUN_TEST(test_chainbuffer_span_blocks);
+    RUN_TEST(test_chainbuffer_retrieve_blocks);
+    RUN_TEST(test_chainbuffer_readfd);
+    RUN_TEST(test_chainbuffer_writefd);
+    RUN_TEST(test_chainbuffer_move);
+    RUN_TEST(test_chainbuffer_readfd_eof_empty);
+
+    std::cout << "\n=== All ChainBuffer Tests Passed ===" << std::endl;
+    return 0;
+}
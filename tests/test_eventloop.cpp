@@ -1,11 +1,16 @@
 #include "../include/EventLoop.h"
 #include "../include/Channel.h"
 #include "../include/Socket.h"
+#include "../include/TimingWheel.h"
+#include <atomic>
 #include <cassert>
 #include <iostream>
 #include <unistd.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <thread>
+#include <vector>
 
 #define TEST(name) void test_##name()
 #define RUN_TEST(name) do { \
@@ -134,13 +139,295 @@ TEST(remove_channel){
 
 }
 
+TEST(queue_in_loop_cross_thread){
+    EventLoop loop;
+
+    const int kThreads = 4;
+    const int kPerThread = 10000;
+
+    std::vector<int> lastSeen(kThreads, -1);
+    bool inOrder = true;
+    int executed = 0;
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < kThreads; ++t) {
+        producers.emplace_back([&, t](){
+            for (int i = 0; i < kPerThread; ++i) {
+                loop.queueInLoop([&, t, i](){
+                    // 同一生产者的任务必须按投递顺序执行
+                    if (i != lastSeen[t] + 1) {
+                        inOrder = false;
+                    }
+                    lastSeen[t] = i;
+                    if (++executed == kThreads * kPerThread) {
+                        loop.quit();
+                    }
+                });
+            }
+        });
+    }
+
+    loop.loop();
+
+    for (auto& p : producers) {
+        p.join();
+    }
+
+    assert(inOrder);
+    assert(executed == kThreads * kPerThread);
+}
+
+TEST(quit_from_other_thread){
+    EventLoop loop;
+
+    // 没有任何事件时loop阻塞在epoll_wait，需要eventfd唤醒才能退出
+    std::thread t([&](){
+        usleep(10 * 1000);
+        loop.quit();
+    });
+
+    loop.loop();
+    t.join();
+}
+
+TEST(run_in_loop_same_thread){
+    EventLoop loop;
+
+    bool ran = false;
+    loop.runInLoop([&](){ ran = true; });
+    // loop线程内直接执行
+    assert(ran);
+}
+
+TEST(io_uring_poller){
+    EventLoop loop(Poller::kIoUring);
+
+    int pipefd[2];
+    assert(pipe(pipefd) == 0);
+
+    Channel reader(&loop, pipefd[0]);
+    Channel writer(&loop, pipefd[1]);
+
+    int reads = 0;
+    int writes = 0;
+
+    // 可写事件触发后写入数据并关闭可写关注，随后读端被触发
+    writer.setWriteCallback([&](){
+        ++writes;
+        write(pipefd[1], "test", 4);
+        writer.disableWriting();
+    });
+    reader.setReadCallback([&](){
+        ++reads;
+        char buf[16];
+        read(pipefd[0], buf, sizeof(buf));
+        loop.quit();
+    });
+
+    reader.enableReading();
+    writer.enableWriting();
+
+    loop.loop();
 
+    assert(writes == 1);
+    assert(reads == 1);
+
+    reader.disableAll();
+    reader.remove();
+    writer.remove();
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+TEST(adaptive_event_batch){
+    EventLoop loop(Poller::kEpoll);
+    const int kChannels = 200;
+    assert(loop.pollerBatchSize() == 16);
+
+    // 水平触发且不读取，每个eventfd每轮都就绪
+    std::vector<int> fds;
+    std::vector<std::unique_ptr<Channel>> channels;
+    int handled = 0;
+    for (int i = 0; i < kChannels; ++i) {
+        int fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+        assert(fd >= 0);
+        fds.push_back(fd);
+        channels.emplace_back(new Channel(&loop, fd));
+        channels.back()->setReadCallback([&](){
+            if (++handled == kChannels * 10) {
+                loop.quit();
+            }
+        });
+        channels.back()->enableReading();
+    }
+
+    loop.loop();
+
+    // 事件数组一路翻倍到能一次取完全部就绪fd
+    assert(loop.pollerBatchSize() >= static_cast<size_t>(kChannels));
+    assert(loop.pollerFullBatches() >= 4);
+    assert(loop.pollerEvents() > loop.pollerWakeups() * 16);
+
+    for (auto& channel : channels) {
+        channel->disableAll();
+        channel->remove();
+    }
+
+    // 负载消失后，连续的小批次唤醒让数组缩回
+    size_t grown = loop.pollerBatchSize();
+    int rounds = 0;
+    std::function<void()> spin = [&](){
+        if (++rounds == 200) {
+            loop.quit();
+        } else {
+            loop.queueInLoop(spin);
+        }
+    };
+    loop.runAfter(0.001, spin);
+    loop.loop();
+    assert(loop.pollerBatchSize() < grown);
+
+    for (int fd : fds) {
+        close(fd);
+    }
+}
+
+TEST(spin_mode){
+    EventLoop loop;
+    loop.setSpinBudget(std::chrono::milliseconds(20));
+
+    std::atomic<int> ran(0);
+    std::thread t([&](){
+        // 自旋期间投递：不写eventfd也能被执行
+        for (int i = 0; i < 1000; ++i) {
+            loop.queueInLoop([&](){ ++ran; });
+        }
+        while (ran < 1000) {
+            usleep(100);
+        }
+        // 超过自旋预算后loop已经阻塞，投递必须能唤醒它
+        usleep(100 * 1000);
+        loop.queueInLoop([&](){
+            ++ran;
+            loop.quit();
+        });
+    });
+
+    loop.loop();
+    t.join();
+    assert(ran == 1001);
+}
+
+TEST(loop_stats){
+#if HPN_LOOP_STATS
+    EventLoop loop;
+    loop.setSlowCallbackThreshold(std::chrono::milliseconds(5));
+
+    int pipefd[2];
+    assert(pipe(pipefd) == 0);
+
+    int slowFd = -1;
+    loop.setSlowCallbackHandler([&](int fd, uint64_t nanos){
+        slowFd = fd;
+        assert(nanos >= 5 * 1000 * 1000);
+    });
+
+    // 读回调故意阻塞10ms
+    Channel channel(&loop, pipefd[0]);
+    channel.setReadCallback([&](){
+        char buf[16];
+        read(pipefd[0], buf, sizeof(buf));
+        usleep(10 * 1000);
+        loop.quit();
+    });
+    channel.enableReading();
+
+    // 其他线程在loop运行期间读取快照
+    std::atomic<bool> done(false);
+    std::thread reader([&](){
+        while (!done) {
+            LoopStats::Snapshot s = loop.stats();
+            assert(s.callbackNanos.count <= s.eventsPerIteration.sum);
+        }
+    });
+
+    std::thread writer([&](){
+        usleep(20 * 1000);
+        write(pipefd[1], "x", 1);
+    });
+    loop.loop();
+    writer.join();
+    done = true;
+    reader.join();
+
+    LoopStats::Snapshot s = loop.stats();
+    assert(s.iterations >= 1);
+    assert(s.slowCallbacks == 1);
+    assert(s.lastSlowFd == pipefd[0]);
+    assert(slowFd == pipefd[0]);
+    assert(s.callbackNanos.max >= 10 * 1000 * 1000);
+    assert(s.callbackNanos.percentile(1.0) == s.callbackNanos.max);
+    // 第一轮等待了约20ms
+    assert(s.waitNanos.max >= 15 * 1000 * 1000);
+    assert(s.processNanos.max >= 10 * 1000 * 1000);
+
+    channel.disableAll();
+    channel.remove();
+    close(pipefd[0]);
+    close(pipefd[1]);
+#endif
+}
+
+// 时间轮只在有条目时驱动tick定时器
+TEST(timing_wheel_idle){
+    EventLoop loop;
+    TimingWheel wheel(&loop, 0.005);
+    assert(!wheel.ticking());
+
+    TimingWheel::Entry removed;
+    wheel.add(&removed, 1.0);
+    assert(wheel.ticking());
+    wheel.remove(&removed);
+    assert(!wheel.ticking());
+
+    bool expired = false;
+    TimingWheel::Entry entry;
+    entry.owner = &expired;
+    entry.onExpire = [](TimingWheel::Entry *e) {
+        *static_cast<bool *>(e->owner) = true;
+    };
+    wheel.add(&entry, 0.02);
+    assert(wheel.ticking());
+
+    // 条目到期后时间轮为空，tick停止
+    uint64_t tickAtExpiry = 0;
+    loop.runEvery(0.005, [&](){
+        if (expired && tickAtExpiry == 0) {
+            tickAtExpiry = wheel.currentTick();
+            loop.runAfter(0.05, [&](){ loop.quit(); });
+        }
+    });
+    loop.runAfter(2.0, [&](){ loop.quit(); });
+    loop.loop();
+
+    assert(expired);
+    assert(!wheel.ticking());
+    assert(wheel.currentTick() == tickAtExpiry);
+}
 
 int main() {
     std::cout << "=== EventLoop Tests ===" << std::endl;
     RUN_TEST(create_eventloop);
     RUN_TEST(read_event);
     RUN_TEST(multiple_channels);
+    RUN_TEST(queue_in_loop_cross_thread);
+    RUN_TEST(quit_from_other_thread);
+    RUN_TEST(run_in_loop_same_thread);
+    RUN_TEST(io_uring_poller);
+    RUN_TEST(adaptive_event_batch);
+    RUN_TEST(spin_mode);
+    RUN_TEST(loop_stats);
+    RUN_TEST(timing_wheel_idle);
 
     std::cout << "\nALL tests passed!" << std::endl;
     return 0;
@@ -1,11 +1,19 @@
 #include "../include/EventLoop.h"
 #include "../include/Socket.h"
 #include "../include/TcpConnection.h"
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <functional>
 #include <iostream>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <chrono>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 #define TEST(name) void name()
 #define RUN_TEST(name)                                                         \
@@ -15,6 +23,24 @@
         std::cout << " PASSED" << std::endl;                                   \
     } while (0)
 
+// 回环上建立一对TCP连接，零拷贝不支持AF_UNIX
+static void tcpPair(int fds[2]) {
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    assert(listen(listenFd, 1) == 0);
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd, (struct sockaddr *)&addr, &len);
+
+    fds[1] = socket(AF_INET, SOCK_STREAM, 0);
+    assert(connect(fds[1], (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    fds[0] = accept(listenFd, nullptr, nullptr);
+    assert(fds[0] >= 0);
+    close(listenFd);
+}
+
 // 测试 1: 创建和销毁 TcpConnection
 TEST(test_tcpconnection_create) {
     EventLoop loop;
@@ -254,6 +280,834 @@ TEST(test_tcpconnection_callbacks) {
     close(fds[1]);
 }
 
+// 测试 8: 其他线程调用 send
+TEST(test_tcpconnection_send_cross_thread) {
+    EventLoop loop;
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+    conn->connectEstablished();
+
+    const int kMessages = 100;
+    std::thread worker([&]() {
+        for (int i = 0; i < kMessages; ++i) {
+            conn->send("ping", 4);
+        }
+        conn->getLoop()->queueInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    worker.join();
+
+    std::string received;
+    char buf[1024];
+    while (received.size() < 4 * kMessages) {
+        ssize_t n = read(fds[1], buf, sizeof(buf));
+        if (n <= 0) {
+            break;
+        }
+        received.append(buf, n);
+    }
+
+    std::string expected;
+    for (int i = 0; i < kMessages; ++i) {
+        expected += "ping";
+    }
+    assert(received == expected);
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 9: 空闲超时关闭连接，有活动时不关闭
+TEST(test_tcpconnection_idle_timeout) {
+    EventLoop loop;
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+
+    auto start = std::chrono::steady_clock::now();
+    double closedAfter = 0;
+    conn->setConnectionCallback([&](const TcpConnection::TcpConnectionPtr &c) {
+        if (!c->connected()) {
+            closedAfter = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+            loop.quit();
+        }
+    });
+    conn->setMessageCallback(
+        [&](const TcpConnection::TcpConnectionPtr &, Buffer *buf) {
+            buf->retrieveAll();
+        });
+
+    conn->connectEstablished();
+    conn->setIdleTimeout(0.3);
+
+    // 前0.5秒内每0.1秒写一次，连接应保持
+    int writes = 0;
+    TimerId writer = loop.runEvery(0.1, [&]() {
+        if (++writes <= 5) {
+            write(fds[1], "x", 1);
+        }
+    });
+
+    loop.loop();
+    loop.cancel(writer);
+
+    // 最后一次活动在0.5秒左右，再过0.3秒左右超时
+    assert(conn->state() == TcpConnection::kDisconnected);
+    assert(closedAfter > 0.7);
+    assert(closedAfter < 1.5);
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 10: 边缘触发模式下大块数据的收发
+TEST(test_tcpconnection_edge_triggered) {
+    EventLoop loop;
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+    conn->setEdgeTriggered(true);
+
+    const size_t kInput = 256 * 1024;
+    const std::string output(1024 * 1024, 'o');
+
+    size_t received = 0;
+    conn->setMessageCallback(
+        [&](const TcpConnection::TcpConnectionPtr &c, Buffer *buf) {
+            received += buf->readableBytes();
+            buf->retrieveAll();
+            if (received == kInput) {
+                // 输入收完后回发1MB，远超socket缓冲区，需要多次可写边沿
+                c->send(output);
+            }
+        });
+
+    conn->connectEstablished();
+    assert(conn->edgeTriggered());
+
+    std::string echoed;
+    std::thread peer([&]() {
+        std::string input(kInput, 'i');
+        size_t written = 0;
+        while (written < input.size()) {
+            ssize_t n = write(fds[1], input.data() + written,
+                              input.size() - written);
+            assert(n > 0);
+            written += n;
+        }
+
+        char buf[65536];
+        while (echoed.size() < output.size()) {
+            ssize_t n = read(fds[1], buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            echoed.append(buf, n);
+        }
+        loop.queueInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    peer.join();
+
+    assert(received == kInput);
+    assert(echoed == output);
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 11: 各种send混合使用，写阻塞时按引用排队且保持顺序
+TEST(test_tcpconnection_send_variants) {
+    EventLoop loop;
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+    conn->connectEstablished();
+
+    // 远超socket缓冲区，第一次send之后后面的都要排队
+    auto payload = std::make_shared<const std::string>(1024 * 1024, 'p');
+    std::string expected;
+
+    loop.runAfter(0.001, [&]() {
+        conn->send(payload);
+        expected += *payload;
+        // 写不完的部分只是多了一个引用
+        assert(payload.use_count() == 2);
+
+        std::string moved(1000, 'm');
+        conn->send(std::move(moved));
+        expected += std::string(1000, 'm');
+
+        const char a[] = "head-";
+        const char b[] = "tail;";
+        struct iovec iov[2] = {{const_cast<char *>(a), 5},
+                               {const_cast<char *>(b), 5}};
+        conn->sendv(iov, 2);
+        expected += "head-tail;";
+
+        Buffer pooled(loop.bufferPool());
+        pooled.append(std::string_view("pooled;"));
+        conn->send(&pooled);
+        assert(pooled.readableBytes() == 0);
+        expected += "pooled;";
+
+        Buffer standalone;
+        standalone.append(std::string_view("standalone;"));
+        conn->send(&standalone);
+        assert(standalone.readableBytes() == 0);
+        // 交出去之后仍然可以继续使用
+        standalone.append(std::string_view("again;"));
+        conn->send(&standalone);
+        expected += "standalone;again;";
+
+        conn->send("copy;", 5);
+        expected += "copy;";
+        conn->send(payload);
+        expected += *payload;
+    });
+
+    std::string received;
+    std::thread peer([&]() {
+        usleep(20 * 1000);
+        char buf[65536];
+        while (received.size() < 2 * payload->size() + 1000 + 39) {
+            ssize_t n = read(fds[1], buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            received.append(buf, n);
+        }
+        loop.queueInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    peer.join();
+
+    assert(received == expected);
+    // 全部写出后输出队列不再持有负载
+    assert(payload.use_count() == 1);
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 12: sendFile与其他数据交错，跨多次可写事件续传
+TEST(test_tcpconnection_send_file) {
+    EventLoop loop;
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+    conn->connectEstablished();
+
+    char path[] = "/tmp/hpn_sendfile_XXXXXX";
+    int fileFd = mkstemp(path);
+    assert(fileFd >= 0);
+    unlink(path);
+    std::string content(2 * 1024 * 1024, '\0');
+    for (size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<char>('a' + i % 26);
+    }
+    assert(write(fileFd, content.data(), content.size()) ==
+           static_cast<ssize_t>(content.size()));
+
+    std::string expected;
+    loop.runAfter(0.001, [&]() {
+        conn->send("before;", 7);
+        expected += "before;";
+        conn->sendFile(fileFd, 100, 1500 * 1000);
+        expected += content.substr(100, 1500 * 1000);
+        conn->send(std::string("middle;"));
+        expected += "middle;";
+        conn->sendFile(fileFd, 0, 10);
+        expected += content.substr(0, 10);
+        // 超出文件末尾的部分被丢弃
+        conn->sendFile(fileFd, content.size() - 5, 20);
+        expected += content.substr(content.size() - 5);
+        conn->send("after;", 6);
+        expected += "after;";
+        // 连接持有自己的fd
+        close(fileFd);
+    });
+
+    const size_t kTotal = 7 + 1500 * 1000 + 7 + 10 + 5 + 6;
+    std::string received;
+    std::thread peer([&]() {
+        usleep(20 * 1000);
+        char buf[65536];
+        while (received.size() < kTotal) {
+            ssize_t n = read(fds[1], buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            received.append(buf, n);
+        }
+        loop.queueInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    peer.join();
+
+    assert(received == expected);
+    assert(loop.pendingOutputBytes() == 0);
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 13: 零拷贝发送，完成通知到达后才释放负载
+TEST(test_tcpconnection_zero_copy) {
+    EventLoop loop;
+
+    int fds[2];
+    tcpPair(fds);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+    conn->connectEstablished();
+    conn->setZeroCopy(true, 64 * 1024);
+    if (!conn->zeroCopy()) {
+        // 内核不支持SO_ZEROCOPY
+        conn->connectDestroyed();
+        close(fds[1]);
+        return;
+    }
+
+    auto payload = std::make_shared<const std::string>(4 * 1024 * 1024, 'z');
+    conn->send("small;", 6);
+    conn->send(payload);
+    conn->send(std::string(100 * 1024, 's'));
+    const size_t kTotal = 6 + payload->size() + 100 * 1024;
+
+    std::string received;
+    std::thread peer([&]() {
+        char buf[65536];
+        while (received.size() < kTotal) {
+            ssize_t n = read(fds[1], buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            received.append(buf, n);
+        }
+    });
+
+    // 数据读完且完成通知释放了负载后退出
+    loop.runEvery(0.001, [&]() {
+        if (received.size() == kTotal && payload.use_count() == 1) {
+            loop.quit();
+        }
+    });
+    loop.runAfter(5, [&]() { loop.quit(); });
+    loop.loop();
+    peer.join();
+
+    assert(received == "small;" + *payload + std::string(100 * 1024, 's'));
+    assert(conn->zeroCopySends() > 0);
+    assert(payload.use_count() == 1);
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 14: 快生产者、慢读者：高水位线回调暂停生产，写完回调恢复
+TEST(test_tcpconnection_high_water_mark) {
+    EventLoop loop;
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+
+    const size_t kHighWaterMark = 256 * 1024;
+    const size_t kChunk = 16 * 1024;
+    const size_t kTotal = 8 * 1024 * 1024;
+
+    bool paused = false;
+    int highWaterHits = 0;
+    int writeCompletes = 0;
+    size_t produced = 0;
+    size_t maxPending = 0;
+
+    conn->setHighWaterMarkCallback(
+        [&](const TcpConnection::TcpConnectionPtr &, size_t pending) {
+            assert(pending >= kHighWaterMark);
+            paused = true;
+            ++highWaterHits;
+        },
+        kHighWaterMark);
+    conn->setWriteCompleteCallback([&](const TcpConnection::TcpConnectionPtr &) {
+        paused = false;
+        ++writeCompletes;
+    });
+    conn->connectEstablished();
+
+    // 生产者：没被暂停时每次定时器发4块；回调在本次回调返回后才执行
+    const int kBurst = 4;
+    std::string chunk(kChunk, 'd');
+    loop.runEvery(0.0002, [&]() {
+        for (int i = 0; i < kBurst && !paused && produced < kTotal; ++i) {
+            conn->send(chunk);
+            produced += kChunk;
+            maxPending = std::max(maxPending, loop.pendingOutputBytes());
+        }
+    });
+
+    size_t consumed = 0;
+    std::thread reader([&]() {
+        char buf[kChunk];
+        while (consumed < kTotal) {
+            ssize_t n = read(fds[1], buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            consumed += n;
+            usleep(100);
+        }
+        loop.queueInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    reader.join();
+
+    assert(consumed == kTotal);
+    assert(highWaterHits > 0);
+    assert(writeCompletes > 0);
+    // 越过水位线后最多再多发同一次突发中剩下的几块
+    assert(maxPending <= kHighWaterMark + kBurst * kChunk);
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 15: 对端只发不收：积压越过水位线时自动停读，内存有上界
+TEST(test_tcpconnection_pause_read_on_high_water) {
+    EventLoop loop;
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+
+    const size_t kHighWaterMark = 256 * 1024;
+    const size_t kTotal = 16 * 1024 * 1024;
+    size_t maxPending = 0;
+    bool sawPaused = false;
+
+    conn->setHighWaterMarkCallback(nullptr, kHighWaterMark);
+    conn->setPauseReadOnHighWaterMark(true);
+    conn->setMessageCallback(
+        [&](const TcpConnection::TcpConnectionPtr &c, Buffer *buf) {
+            c->send(buf);
+            maxPending = std::max(maxPending, loop.pendingOutputBytes());
+            sawPaused = sawPaused || !c->isReading();
+        });
+    conn->connectEstablished();
+
+    std::thread writer([&]() {
+        std::string data(64 * 1024, 'e');
+        size_t written = 0;
+        while (written < kTotal) {
+            ssize_t n = write(fds[1], data.data(), data.size());
+            if (n <= 0) {
+                break;
+            }
+            written += n;
+        }
+    });
+
+    size_t echoed = 0;
+    std::thread reader([&]() {
+        char buf[16 * 1024];
+        while (echoed < kTotal) {
+            ssize_t n = read(fds[1], buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            echoed += n;
+            usleep(50);
+        }
+        loop.queueInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    writer.join();
+    reader.join();
+
+    assert(echoed == kTotal);
+    assert(sawPaused);
+    // 越过水位线前的最后一次读最多带进一个读取上限加溢出区
+    assert(maxPending <= kHighWaterMark + Buffer::kMaxReadHint +
+                             Buffer::kOverflowSize);
+    assert(conn->isReading());
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 16: 写合并：一轮迭代内的多次send在迭代末尾一起写出，顺序不变
+TEST(test_tcpconnection_write_coalescing) {
+    EventLoop loop;
+
+    int fds[2];
+    tcpPair(fds);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+    conn->setWriteCoalescing(true, true);
+    int writeCompletes = 0;
+    conn->setWriteCompleteCallback(
+        [&](const TcpConnection::TcpConnectionPtr &) { ++writeCompletes; });
+    conn->connectEstablished();
+
+    char path[] = "/tmp/hpn_coalesce_XXXXXX";
+    int fileFd = mkstemp(path);
+    assert(fileFd >= 0);
+    unlink(path);
+    std::string content(100 * 1000, 'f');
+    assert(write(fileFd, content.data(), content.size()) ==
+           static_cast<ssize_t>(content.size()));
+
+    std::string expected;
+    size_t unflushed = 0;
+    loop.runAfter(0.001, [&]() {
+        conn->send("header;", 7);
+        conn->send(std::string("body;"));
+        Buffer trailer(loop.bufferPool());
+        trailer.append(std::string_view("trailer;"));
+        conn->send(&trailer);
+        expected += "header;body;trailer;";
+        // 文件前的内存数据带MSG_MORE写出
+        conn->sendFile(fileFd, 0, content.size());
+        expected += content;
+        conn->send("end;", 4);
+        expected += "end;";
+        close(fileFd);
+
+        // 回调返回之前一个字节都没有写
+        int avail = -1;
+        usleep(2000);
+        ioctl(fds[1], FIONREAD, &avail);
+        unflushed = static_cast<size_t>(avail) == 0 ? loop.pendingOutputBytes()
+                                                    : 0;
+    });
+
+    std::string received;
+    std::thread peer([&]() {
+        char buf[65536];
+        while (received.size() < 20 + content.size() + 4) {
+            ssize_t n = read(fds[1], buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            received.append(buf, n);
+        }
+        loop.runAfter(0.01, [&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    peer.join();
+
+    assert(unflushed == expected.size());
+    assert(received == expected);
+    assert(loop.pendingOutputBytes() == 0);
+    // 整批数据只有一次写完回调
+    assert(writeCompletes == 1);
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 17: 边缘触发+读预算：每轮最多读预算字节，剩下的推迟到后续迭代读完
+TEST(test_tcpconnection_read_budget) {
+    EventLoop loop;
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+    conn->setEdgeTriggered(true);
+    const size_t kBudget = 4096;
+    const size_t kInput = 128 * 1024;
+    conn->setReadBudget(kBudget);
+
+    size_t received = 0;
+    size_t maxPerCallback = 0;
+    int callbacks = 0;
+    conn->setMessageCallback(
+        [&](const TcpConnection::TcpConnectionPtr &, Buffer *buf) {
+            ++callbacks;
+            maxPerCallback = std::max(maxPerCallback, buf->readableBytes());
+            received += buf->readableBytes();
+            buf->retrieveAll();
+            if (received == kInput) {
+                loop.quit();
+            }
+        });
+
+    // 数据在建立之前全部写好，只会有一次可读边沿
+    std::string input(kInput, 'i');
+    size_t written = 0;
+    while (written < input.size()) {
+        ssize_t n = write(fds[1], input.data() + written, input.size() - written);
+        assert(n > 0);
+        written += n;
+    }
+    conn->connectEstablished();
+    loop.loop();
+
+    assert(received == kInput);
+    assert(maxPerCallback <= kBudget);
+    assert(callbacks >= static_cast<int>(kInput / kBudget));
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 18: deferRead：回调每次只处理一条消息，剩下的在之后的迭代中继续回调
+TEST(test_tcpconnection_defer_read) {
+    EventLoop loop;
+
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+    std::vector<std::string> lines;
+    int ticks = 0;
+    int ticksAtFirst = -1;
+    conn->setMessageCallback(
+        [&](const TcpConnection::TcpConnectionPtr &c, Buffer *buf) {
+            const char *eol = buf->findEOL();
+            if (eol == nullptr) {
+                return;
+            }
+            if (ticksAtFirst < 0) {
+                ticksAtFirst = ticks;
+            }
+            lines.push_back(buf->retrieveAsString(eol - buf->peek()));
+            buf->retrieve(1);
+            if (buf->findEOL() != nullptr) {
+                c->deferRead();
+            } else if (lines.size() == 10) {
+                loop.quit();
+            }
+        });
+    conn->connectEstablished();
+
+    // 同一loop上的其他工作：每轮迭代执行一次
+    std::function<void()> tick = [&]() {
+        ++ticks;
+        loop.queueInLoop(tick);
+    };
+    loop.queueInLoop(tick);
+
+    std::string input;
+    for (int i = 0; i < 10; ++i) {
+        input += "line" + std::to_string(i) + "\n";
+    }
+    assert(write(fds[1], input.data(), input.size()) ==
+           static_cast<ssize_t>(input.size()));
+    loop.loop();
+
+    assert(lines.size() == 10);
+    assert(lines[0] == "line0" && lines[9] == "line9");
+    // 10条消息分布在10轮迭代中，期间其他工作照常执行
+    assert(ticks - ticksAtFirst >= 9);
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
+// 测试 19: 池分配的连接共享一组回调，单独设置时只影响自己
+TEST(test_tcpconnection_shared_callbacks) {
+    EventLoop loop;
+
+    int fdsA[2];
+    int fdsB[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fdsA) == 0);
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fdsB) == 0);
+
+    std::string sharedGot;
+    std::string ownGot;
+    auto callbacks = std::make_shared<TcpConnection::Callbacks>();
+    callbacks->message = [&](const TcpConnection::TcpConnectionPtr &,
+                             Buffer *buf) {
+        sharedGot += buf->retrieveAllAsString();
+    };
+
+    Socket sockA(fdsA[0]);
+    sockA.setNonBlocking();
+    Socket sockB(fdsB[0]);
+    sockB.setNonBlocking();
+    auto a = TcpConnection::create(&loop, std::move(sockA), "a");
+    auto b = TcpConnection::create(&loop, std::move(sockB), "b");
+    a->setCallbacks(callbacks);
+    b->setCallbacks(callbacks);
+    // 复制一份再改，a仍然用共享的那份
+    b->setMessageCallback(
+        [&](const TcpConnection::TcpConnectionPtr &, Buffer *buf) {
+            ownGot += buf->retrieveAllAsString();
+        });
+    a->connectEstablished();
+    b->connectEstablished();
+
+    assert(write(fdsA[1], "to-a", 4) == 4);
+    assert(write(fdsB[1], "to-b", 4) == 4);
+    loop.runAfter(0.02, [&]() { loop.quit(); });
+    loop.loop();
+
+    assert(sharedGot == "to-a");
+    assert(ownGot == "to-b");
+
+    a->connectDestroyed();
+    b->connectDestroyed();
+    close(fdsA[1]);
+    close(fdsB[1]);
+}
+
+// 测试 20: 比读预算大的消息：不消费输入时继续按预算读，回调只在有新数据时调用
+TEST(test_tcpconnection_frame_larger_than_budget) {
+    for (bool edgeTriggered : {false, true}) {
+        EventLoop loop;
+
+        int fds[2];
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+        Socket sock(fds[0]);
+        sock.setNonBlocking();
+
+        auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+        conn->setEdgeTriggered(edgeTriggered);
+        const size_t kBudget = 4096;
+        const size_t kFrame = 10 * 1024;
+        conn->setReadBudget(kBudget);
+
+        int callbacks = 0;
+        bool complete = false;
+        conn->setMessageCallback(
+            [&](const TcpConnection::TcpConnectionPtr &, Buffer *buf) {
+                ++callbacks;
+                // 等整帧到齐才消费
+                if (buf->readableBytes() < kFrame) {
+                    return;
+                }
+                buf->retrieve(kFrame);
+                complete = true;
+                loop.quit();
+            });
+
+        std::string frame(kFrame, 'f');
+        assert(write(fds[1], frame.data(), frame.size()) ==
+               static_cast<ssize_t>(frame.size()));
+        conn->connectEstablished();
+        loop.runAfter(1.0, [&]() { loop.quit(); });
+        loop.loop();
+
+        assert(complete);
+        // 每次回调都带来新数据：4096 + 4096 + 2048
+        assert(callbacks == static_cast<int>((kFrame + kBudget - 1) / kBudget));
+
+        conn->connectDestroyed();
+        close(fds[1]);
+    }
+}
+
+// 测试 21: 停止读且写完后仍能收到零拷贝完成通知并释放负载
+TEST(test_tcpconnection_zero_copy_stop_read) {
+    EventLoop loop;
+
+    int fds[2];
+    tcpPair(fds);
+
+    Socket sock(fds[0]);
+    sock.setNonBlocking();
+
+    auto conn = std::make_shared<TcpConnection>(&loop, std::move(sock));
+    conn->connectEstablished();
+    conn->stopRead();
+    conn->setZeroCopy(true, 64 * 1024);
+    if (!conn->zeroCopy()) {
+        conn->connectDestroyed();
+        close(fds[1]);
+        return;
+    }
+
+    auto payload = std::make_shared<const std::string>(4 * 1024 * 1024, 'z');
+    conn->send(payload);
+
+    size_t received = 0;
+    std::thread peer([&]() {
+        char buf[65536];
+        while (received < payload->size()) {
+            ssize_t n = read(fds[1], buf, sizeof(buf));
+            if (n <= 0) {
+                break;
+            }
+            received += n;
+        }
+    });
+
+    loop.runEvery(0.001, [&]() {
+        if (payload.use_count() == 1) {
+            loop.quit();
+        }
+    });
+    loop.runAfter(2, [&]() { loop.quit(); });
+    loop.loop();
+    peer.join();
+
+    assert(received == payload->size());
+    assert(conn->zeroCopySends() > 0);
+    assert(payload.use_count() == 1);
+
+    conn->connectDestroyed();
+    close(fds[1]);
+}
+
 int main() {
     RUN_TEST(test_tcpconnection_create);
     RUN_TEST(test_tcpconnection_establish);
@@ -262,6 +1116,20 @@ int main() {
     RUN_TEST(test_tcpconnection_large_send);
     RUN_TEST(test_tcpconnection_close);
     RUN_TEST(test_tcpconnection_callbacks);
+    RUN_TEST(test_tcpconnection_send_cross_thread);
+    RUN_TEST(test_tcpconnection_idle_timeout);
+    RUN_TEST(test_tcpconnection_edge_triggered);
+    RUN_TEST(test_tcpconnection_send_variants);
+    RUN_TEST(test_tcpconnection_send_file);
+    RUN_TEST(test_tcpconnection_zero_copy);
+    RUN_TEST(test_tcpconnection_high_water_mark);
+    RUN_TEST(test_tcpconnection_pause_read_on_high_water);
+    RUN_TEST(test_tcpconnection_write_coalescing);
+    RUN_TEST(test_tcpconnection_read_budget);
+    RUN_TEST(test_tcpconnection_defer_read);
+    RUN_TEST(test_tcpconnection_shared_callbacks);
+    RUN_TEST(test_tcpconnection_frame_larger_than_budget);
+    RUN_TEST(test_tcpconnection_zero_copy_stop_read);
 
     std::cout << "\n=== All TcpConnection Tests Passed ===" << std::endl;
     return 0;
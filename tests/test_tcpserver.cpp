@@ -0,0 +1,655 @@
+#include "../include/Acceptor.h"
+#include "../include/EventLoop.h"
+#include "../include/EventLoopThread.h"
+#include "../include/EventLoopThreadPool.h"
+#include "../include/SlotMap.h"
+#include "../include/SocketOptions.h"
+#include "../include/TcpServer.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <netinet/tcp.h>
+#include <set>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define TEST(name) void name()
+#define RUN_TEST(name)                                                         \
+    do {                                                                       \
+        std::cout << "Running " << #name << "...";                             \
+        name();                                                                \
+        std::cout << " PASSED" << std::endl;                                   \
+    } while (0)
+
+// 阻塞方式连接到本机端口
+static int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    assert(fd >= 0);
+
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // server 在另一个线程启动，可能还没listen
+    for (int i = 0; i < 100; ++i) {
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        usleep(10 * 1000);
+    }
+    assert(false);
+    return -1;
+}
+
+static std::string readExactly(int fd, size_t len) {
+    std::string result;
+    char buf[4096];
+    while (result.size() < len) {
+        ssize_t n = ::read(fd, buf, std::min(sizeof(buf), len - result.size()));
+        if (n <= 0) {
+            break;
+        }
+        result.append(buf, n);
+    }
+    return result;
+}
+
+// 测试 1: 线程池启动，每个子循环运行在独立线程
+TEST(test_threadpool_start) {
+    EventLoop baseLoop;
+    EventLoopThreadPool pool(&baseLoop);
+    pool.setThreadNum(3);
+    pool.start();
+
+    std::vector<EventLoop *> loops = pool.getAllLoops();
+    assert(loops.size() == 3);
+
+    std::set<EventLoop *> unique(loops.begin(), loops.end());
+    assert(unique.size() == 3);
+    assert(unique.count(&baseLoop) == 0);
+
+    // 轮询分发
+    assert(pool.getNextLoop() == loops[0]);
+    assert(pool.getNextLoop() == loops[1]);
+    assert(pool.getNextLoop() == loops[2]);
+    assert(pool.getNextLoop() == loops[0]);
+}
+
+// 测试 2: 没有子线程时所有连接都留在baseLoop
+TEST(test_threadpool_zero_threads) {
+    EventLoop baseLoop;
+    EventLoopThreadPool pool(&baseLoop);
+    pool.start();
+
+    assert(pool.getNextLoop() == &baseLoop);
+    assert(pool.getAllLoops().size() == 1);
+}
+
+// 测试 3: runInLoop 跨线程执行
+TEST(test_run_in_loop_cross_thread) {
+    EventLoop baseLoop;
+    EventLoopThreadPool pool(&baseLoop);
+    pool.setThreadNum(1);
+    pool.start();
+
+    EventLoop *ioLoop = pool.getNextLoop();
+    std::atomic<bool> ran(false);
+    std::atomic<bool> inLoopThread(false);
+
+    ioLoop->runInLoop([&]() {
+        inLoopThread = ioLoop->isInLoopThread();
+        ran = true;
+    });
+
+    for (int i = 0; i < 200 && !ran; ++i) {
+        usleep(1000);
+    }
+    assert(ran);
+    assert(inLoopThread);
+}
+
+// 测试 4: 最少连接策略
+TEST(test_threadpool_least_connections) {
+    EventLoop baseLoop;
+    EventLoopThreadPool pool(&baseLoop);
+    pool.setThreadNum(3);
+    pool.setDistribution(EventLoopThreadPool::kLeastConnections);
+    pool.start();
+
+    std::vector<EventLoop *> loops = pool.getAllLoops();
+    loops[0]->addConnections(5);
+    loops[1]->addConnections(1);
+    loops[2]->addConnections(3);
+    assert(pool.getNextLoop() == loops[1]);
+
+    loops[1]->addConnections(10);
+    assert(pool.getNextLoop() == loops[2]);
+
+    // 自定义策略优先
+    pool.setLoopSelector(
+        [](const std::vector<EventLoop *> &all) { return all.back(); });
+    assert(pool.getNextLoop() == loops[2]);
+}
+
+// 测试 5: 多Reactor回显服务器
+TEST(test_tcpserver_multi_reactor_echo) {
+    const uint16_t port = 19081;
+    const int kClients = 8;
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port, true));
+    server.setThreadNum(4);
+
+    std::mutex mutex;
+    std::set<EventLoop *> usedLoops;
+
+    server.setConnectionCallback([&](const TcpServer::TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            assert(conn->getLoop()->isInLoopThread());
+            std::lock_guard<std::mutex> lock(mutex);
+            usedLoops.insert(conn->getLoop());
+        }
+    });
+    server.setMessageCallback(
+        [](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+            conn->send(buf->retrieveAllAsString());
+        });
+    server.start();
+
+    std::thread client([&]() {
+        for (int i = 0; i < kClients; ++i) {
+            int fd = connectTo(port);
+            std::string msg = "hello from client " + std::to_string(i);
+            assert(::write(fd, msg.data(), msg.size()) ==
+                   static_cast<ssize_t>(msg.size()));
+            assert(readExactly(fd, msg.size()) == msg);
+            ::close(fd);
+        }
+        loop.runInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    client.join();
+
+    // 8个连接轮询分到4个子循环
+    assert(usedLoops.size() == 4);
+    assert(usedLoops.count(&loop) == 0);
+}
+
+// 测试 6: 每次可读最多accept N个，水平和边缘触发都能把积压的连接取完
+TEST(test_acceptor_batched_accept) {
+    const int kClients = 20;
+
+    for (bool edge : {false, true}) {
+        // io_uring后端释放监听socket是异步的，两轮不用同一个端口
+        const uint16_t port = edge ? 19084 : 19082;
+        EventLoop loop;
+        Acceptor acceptor(&loop, InetAddress(port, true));
+        acceptor.setEdgeTriggered(edge);
+        acceptor.setMaxAcceptsPerWakeup(3);
+        std::vector<int> accepted;
+        acceptor.setNewConnectionCallback(
+            [&](int sockfd, const InetAddress &) {
+                // accept4带上了SOCK_NONBLOCK和SOCK_CLOEXEC
+                assert(::fcntl(sockfd, F_GETFL) & O_NONBLOCK);
+                assert(::fcntl(sockfd, F_GETFD) & FD_CLOEXEC);
+                accepted.push_back(sockfd);
+            });
+        acceptor.listen();
+
+        // 先全部连上再进入loop，一次可读事件对应整批积压的连接
+        std::vector<int> clients;
+        for (int i = 0; i < kClients; ++i) {
+            clients.push_back(connectTo(port));
+        }
+        loop.runAfter(0.05, [&]() { loop.quit(); });
+        loop.loop();
+
+        assert(accepted.size() == static_cast<size_t>(kClients));
+        assert(acceptor.acceptedCount() == static_cast<uint64_t>(kClients));
+        assert(acceptor.droppedCount() == 0);
+        for (int fd : accepted) {
+            ::close(fd);
+        }
+        for (int fd : clients) {
+            ::close(fd);
+        }
+    }
+}
+
+// 测试 7: fd耗尽时用预留的fd关闭多出的连接，不会一直可读
+TEST(test_acceptor_emfile) {
+    const uint16_t port = 19083;
+    const int kClients = 5;
+    const int kFree = 2;
+
+    EventLoop loop;
+    Acceptor acceptor(&loop, InetAddress(port, true));
+    std::vector<int> accepted;
+    acceptor.setNewConnectionCallback(
+        [&](int sockfd, const InetAddress &) { accepted.push_back(sockfd); });
+    acceptor.listen();
+
+    // 客户端socket先创建好，connect不再占用fd
+    std::vector<int> clients;
+    for (int i = 0; i < kClients; ++i) {
+        clients.push_back(::socket(AF_INET, SOCK_STREAM, 0));
+    }
+
+    // 把fd占满，只留kFree个给accept
+    struct rlimit saved;
+    getrlimit(RLIMIT_NOFILE, &saved);
+    struct rlimit limited = saved;
+    limited.rlim_cur = static_cast<rlim_t>(clients.back() + 64);
+    setrlimit(RLIMIT_NOFILE, &limited);
+    std::vector<int> fillers;
+    for (;;) {
+        int fd = ::dup(0);
+        if (fd < 0) {
+            assert(errno == EMFILE);
+            break;
+        }
+        fillers.push_back(fd);
+    }
+    for (int i = 0; i < kFree; ++i) {
+        ::close(fillers.back());
+        fillers.pop_back();
+    }
+
+    struct sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int fd : clients) {
+        assert(::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    }
+    loop.runAfter(0.05, [&]() { loop.quit(); });
+    loop.loop();
+
+    assert(accepted.size() == static_cast<size_t>(kFree));
+    assert(acceptor.droppedCount() ==
+           static_cast<uint64_t>(kClients - kFree));
+    // 被丢弃的连接对端读到EOF
+    int eofs = 0;
+    for (int fd : clients) {
+        char c;
+        struct timeval tv {0, 100 * 1000};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        if (::read(fd, &c, 1) == 0) {
+            ++eofs;
+        }
+    }
+    assert(eofs == kClients - kFree);
+
+    // 释放fd后恢复正常accept，预留的fd也重新打开了
+    for (int fd : fillers) {
+        ::close(fd);
+    }
+    setrlimit(RLIMIT_NOFILE, &saved);
+    int late = connectTo(port);
+    loop.runAfter(0.05, [&]() { loop.quit(); });
+    loop.loop();
+    assert(accepted.size() == static_cast<size_t>(kFree + 1));
+
+    ::close(late);
+    for (int fd : accepted) {
+        ::close(fd);
+    }
+    for (int fd : clients) {
+        ::close(fd);
+    }
+}
+
+// 预留fd打不开时暂停accept，不忙循环；释放fd后定时重试恢复，backlog里的连接都被accept
+TEST(test_acceptor_no_spare_fd) {
+    for (bool edgeTriggered : {false, true}) {
+        const uint16_t port = edgeTriggered ? 19091 : 19090;
+        const int kClients = 3;
+
+        EventLoop loop;
+        std::vector<int> clients;
+        for (int i = 0; i < kClients; ++i) {
+            clients.push_back(::socket(AF_INET, SOCK_STREAM, 0));
+        }
+
+        struct rlimit saved;
+        getrlimit(RLIMIT_NOFILE, &saved);
+        struct rlimit limited = saved;
+        limited.rlim_cur = static_cast<rlim_t>(clients.back() + 64);
+        setrlimit(RLIMIT_NOFILE, &limited);
+        std::vector<int> fillers;
+        for (;;) {
+            int fd = ::dup(0);
+            if (fd < 0) {
+                assert(errno == EMFILE);
+                break;
+            }
+            fillers.push_back(fd);
+        }
+        // 只留一个fd给监听socket，预留的空闲fd打不开
+        ::close(fillers.back());
+        fillers.pop_back();
+
+        std::unique_ptr<Acceptor> acceptor(
+            new Acceptor(&loop, InetAddress(port, true)));
+        std::vector<int> accepted;
+        acceptor->setNewConnectionCallback(
+            [&](int sockfd, const InetAddress &) { accepted.push_back(sockfd); });
+        acceptor->setEdgeTriggered(edgeTriggered);
+        acceptor->listen();
+
+        struct sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        for (int fd : clients) {
+            assert(::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+        }
+
+        // 暂停期间只有重试定时器唤醒loop
+        uint64_t syscallsBefore = loop.pollerSyscalls();
+        uint64_t syscallsPaused = 0;
+        loop.runAfter(0.25, [&]() {
+            syscallsPaused = loop.pollerSyscalls() - syscallsBefore;
+            assert(accepted.empty());
+            // 释放fd时不再有新连接，也就没有新的边沿
+            for (int fd : fillers) {
+                ::close(fd);
+            }
+            setrlimit(RLIMIT_NOFILE, &saved);
+        });
+        loop.runAfter(0.5, [&]() { loop.quit(); });
+        loop.loop();
+
+        assert(syscallsPaused < 50);
+        assert(accepted.size() == static_cast<size_t>(kClients));
+        for (int fd : accepted) {
+            ::close(fd);
+        }
+        for (int fd : clients) {
+            ::close(fd);
+        }
+    }
+}
+
+// 测试 8: 每个子循环自己accept，连接留在accept它的loop上
+TEST(test_tcpserver_sharded_listeners) {
+    const int kClients = 16;
+
+    for (TcpServer::ListenMode mode :
+         {TcpServer::kReusePort, TcpServer::kExclusive}) {
+        const uint16_t port = mode == TcpServer::kReusePort ? 19085 : 19086;
+        EventLoop loop;
+        TcpServer server(&loop, InetAddress(port, true));
+        server.setThreadNum(4);
+        server.setListenMode(mode);
+        // 不会经过分发策略
+        server.setLoopSelector([](const std::vector<EventLoop *> &) {
+            assert(false);
+            return static_cast<EventLoop *>(nullptr);
+        });
+
+        std::mutex mutex;
+        std::set<EventLoop *> usedLoops;
+        server.setConnectionCallback(
+            [&](const TcpServer::TcpConnectionPtr &conn) {
+                if (conn->connected()) {
+                    assert(conn->getLoop()->isInLoopThread());
+                    std::lock_guard<std::mutex> lock(mutex);
+                    usedLoops.insert(conn->getLoop());
+                }
+            });
+        server.setMessageCallback(
+            [](const TcpServer::TcpConnectionPtr &conn, Buffer *buf) {
+                conn->send(buf->retrieveAllAsString());
+            });
+        server.start();
+
+        std::thread client([&]() {
+            std::vector<int> fds;
+            for (int i = 0; i < kClients; ++i) {
+                fds.push_back(connectTo(port));
+            }
+            for (int i = 0; i < kClients; ++i) {
+                std::string msg = "hello from client " + std::to_string(i);
+                assert(::write(fds[i], msg.data(), msg.size()) ==
+                       static_cast<ssize_t>(msg.size()));
+                assert(readExactly(fds[i], msg.size()) == msg);
+            }
+            for (int fd : fds) {
+                ::close(fd);
+            }
+            loop.runInLoop([&]() { loop.quit(); });
+        });
+
+        loop.loop();
+        client.join();
+
+        assert(!usedLoops.empty());
+        assert(usedLoops.count(&loop) == 0);
+        if (mode == TcpServer::kReusePort) {
+            // 16个连接按四元组哈希分到4个监听socket，几乎不可能都落在同一个上
+            assert(usedLoops.size() > 1);
+        }
+    }
+}
+
+// 测试 9: 槽表的键带代数，删除后旧键失效，复用的槽不会被旧键访问到
+TEST(test_slotmap) {
+    SlotMap<int> map;
+    auto a = map.insert(1);
+    auto b = map.insert(2);
+    auto c = map.insert(3);
+    assert(a != SlotMap<int>::kInvalidKey);
+    assert(map.size() == 3);
+    assert(*map.find(a) == 1 && *map.find(b) == 2 && *map.find(c) == 3);
+    assert(map.find(SlotMap<int>::kInvalidKey) == nullptr);
+
+    // 删除中间的元素，最后一个挪过来，其他键仍然有效
+    assert(map.erase(b));
+    assert(!map.erase(b));
+    assert(map.find(b) == nullptr);
+    assert(*map.find(a) == 1 && *map.find(c) == 3);
+    assert(map.size() == 2);
+
+    // 复用同一个槽，下标相同代数不同
+    auto d = map.insert(4);
+    assert(SlotMap<int>::indexOf(d) == SlotMap<int>::indexOf(b));
+    assert(d != b);
+    assert(map.find(b) == nullptr);
+    assert(*map.find(d) == 4);
+
+    int sum = 0;
+    for (int v : map) {
+        sum += v;
+    }
+    assert(sum == 1 + 3 + 4);
+
+    map.clear();
+    assert(map.empty());
+    assert(map.find(a) == nullptr && map.find(c) == nullptr &&
+           map.find(d) == nullptr);
+}
+
+// 测试 10: 按ConnectionId在其他线程查找连接，断开后旧id查不到
+TEST(test_tcpserver_connection_id) {
+    for (TcpServer::ListenMode mode :
+         {TcpServer::kSingleAcceptor, TcpServer::kReusePort}) {
+        const uint16_t port = mode == TcpServer::kReusePort ? 19088 : 19087;
+        EventLoop loop;
+        TcpServer server(&loop, InetAddress(port, true));
+        server.setThreadNum(2);
+        server.setListenMode(mode);
+
+        std::mutex mutex;
+        std::vector<TcpServer::ConnectionId> ids;
+        std::atomic<int> closed(0);
+        server.setConnectionCallback(
+            [&](const TcpServer::TcpConnectionPtr &conn) {
+                if (conn->connected()) {
+                    assert(conn->id() != TcpConnection::kInvalidId);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ids.push_back(conn->id());
+                } else {
+                    ++closed;
+                }
+            });
+        server.start();
+
+        std::thread client([&]() {
+            int a = connectTo(port);
+            int b = connectTo(port);
+            // 连接建立回调在连接加入连接表之后
+            std::vector<TcpServer::ConnectionId> seen;
+            while (seen.size() < 2) {
+                usleep(1000);
+                std::lock_guard<std::mutex> lock(mutex);
+                seen = ids;
+            }
+            assert(seen[0] != seen[1]);
+            for (TcpServer::ConnectionId id : seen) {
+                TcpServer::TcpConnectionPtr conn = server.getConnection(id);
+                assert(conn && conn->id() == id);
+            }
+
+            // 关掉一个，等服务端移除后旧id查不到
+            ::close(a);
+            while (closed.load() < 1 || server.numConnections() != 1) {
+                usleep(1000);
+            }
+            int found = 0;
+            for (TcpServer::ConnectionId id : seen) {
+                found += server.getConnection(id) ? 1 : 0;
+            }
+            assert(found == 1);
+
+            ::close(b);
+            while (server.numConnections() != 0) {
+                usleep(1000);
+            }
+            for (TcpServer::ConnectionId id : seen) {
+                assert(!server.getConnection(id));
+            }
+            assert(!server.getConnection(TcpConnection::kInvalidId));
+            loop.runInLoop([&]() { loop.quit(); });
+        });
+
+        loop.loop();
+        client.join();
+    }
+}
+
+static int getIntOption(int fd, int level, int option) {
+    int value = 0;
+    socklen_t len = sizeof(value);
+    int rc = ::getsockopt(fd, level, option, &value, &len);
+    assert(rc == 0);
+    (void)rc;
+    return value;
+}
+
+TEST(test_tcpserver_socket_options) {
+    // 没有设置的项不改动
+    {
+        Socket socket = Socket::createTCP().value();
+        int sndBuf = getIntOption(socket.fd(), SOL_SOCKET, SO_SNDBUF);
+        assert(SocketOptions().applyToConnection(socket, "empty"));
+        assert(getIntOption(socket.fd(), SOL_SOCKET, SO_SNDBUF) == sndBuf);
+        assert(getIntOption(socket.fd(), IPPROTO_TCP, TCP_NODELAY) == 0);
+        assert(getIntOption(socket.fd(), SOL_SOCKET, SO_KEEPALIVE) == 0);
+    }
+
+    const uint16_t port = 19089;
+    SocketOptions opts = SocketOptions::lowLatency();
+    opts.sendBufferBytes = 256 * 1024;
+    opts.recvBufferBytes = 256 * 1024;
+    opts.keepAlive = SocketOptions::KeepAlive{30, 5, 3};
+    opts.notSentLowatBytes = 32 * 1024;
+    opts.deferAcceptSeconds = 5;
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port, true));
+    server.setThreadNum(1);
+    server.setSocketOptions(opts);
+
+    std::atomic<int> established(0);
+    std::atomic<bool> checked(false);
+    server.setConnectionCallback([&](const TcpServer::TcpConnectionPtr &conn) {
+        if (!conn->connected()) {
+            return;
+        }
+        int fd = conn->fd();
+        assert(getIntOption(fd, IPPROTO_TCP, TCP_NODELAY) == 1);
+        // 内核把设置的值加倍记账
+        assert(getIntOption(fd, SOL_SOCKET, SO_SNDBUF) >= 256 * 1024);
+        assert(getIntOption(fd, SOL_SOCKET, SO_RCVBUF) >= 256 * 1024);
+        assert(getIntOption(fd, SOL_SOCKET, SO_KEEPALIVE) == 1);
+        assert(getIntOption(fd, IPPROTO_TCP, TCP_KEEPIDLE) == 30);
+        assert(getIntOption(fd, IPPROTO_TCP, TCP_KEEPINTVL) == 5);
+        assert(getIntOption(fd, IPPROTO_TCP, TCP_KEEPCNT) == 3);
+        assert(getIntOption(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT) == 32 * 1024);
+        checked = true;
+        ++established;
+    });
+    server.start();
+
+    std::thread client([&]() {
+        int fd = connectTo(port);
+        // TCP_DEFER_ACCEPT：客户端的connect已经完成，但第一个数据包到达之前不会accept
+        usleep(100 * 1000);
+        assert(established.load() == 0);
+        assert(::send(fd, "x", 1, 0) == 1);
+        while (established.load() == 0) {
+            usleep(1000);
+        }
+        assert(checked.load());
+        ::close(fd);
+        loop.runInLoop([&]() { loop.quit(); });
+    });
+
+    loop.loop();
+    client.join();
+}
+
+// 测试 11: loop自己退出后析构EventLoopThread，线程仍被join
+TEST(test_eventloopthread_loop_exits_first) {
+    std::atomic<bool> exited(false);
+    {
+        EventLoopThread thread;
+        EventLoop *loop = thread.startLoop();
+        loop->runInLoop([loop]() { loop->quit(); });
+        loop->queueInLoop([&]() { exited = true; });
+        for (int i = 0; i < 1000 && !exited; ++i) {
+            usleep(1000);
+        }
+        // 析构时loop_已为nullptr，不join的话std::thread析构会terminate
+    }
+    assert(exited);
+}
+
+int main() {
+    RUN_TEST(test_threadpool_start);
+    RUN_TEST(test_threadpool_zero_threads);
+    RUN_TEST(test_run_in_loop_cross_thread);
+    RUN_TEST(test_threadpool_least_connections);
+    RUN_TEST(test_tcpserver_multi_reactor_echo);
+    RUN_TEST(test_acceptor_batched_accept);
+    RUN_TEST(test_acceptor_emfile);
+    RUN_TEST(test_acceptor_no_spare_fd);
+    RUN_TEST(test_tcpserver_sharded_listeners);
+    RUN_TEST(test_slotmap);
+    RUN_TEST(test_tcpserver_connection_id);
+    RUN_TEST(test_tcpserver_socket_options);
+    RUN_TEST(test_eventloopthread_loop_exits_first);
+
+    std::cout << "\n=== All TcpServer Tests Passed ===" << std::endl;
+    return 0;
+}
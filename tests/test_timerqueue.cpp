@@ -0,0 +1,154 @@
+#include "../include/EventLoop.h"
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define TEST(name) void name()
+#define RUN_TEST(name)                                                         \
+    do {                                                                       \
+        std::cout << "Running " << #name << "...";                             \
+        name();                                                                \
+        std::cout << " PASSED" << std::endl;                                   \
+    } while (0)
+
+// 测试 1: 按到期时间顺序触发
+TEST(test_timer_order) {
+    EventLoop loop;
+    std::vector<int> fired;
+
+    loop.runAfter(0.03, [&]() {
+        fired.push_back(3);
+        loop.quit();
+    });
+    loop.runAfter(0.01, [&]() { fired.push_back(1); });
+    loop.runAfter(0.02, [&]() { fired.push_back(2); });
+
+    loop.loop();
+
+    assert((fired == std::vector<int>{1, 2, 3}));
+}
+
+// 测试 2: 同一时刻到期的定时器一次唤醒全部处理，并保持添加顺序
+TEST(test_timer_batch_expiry) {
+    EventLoop loop;
+    std::vector<int> fired;
+
+    TimePoint when = TimerClock::now() + std::chrono::milliseconds(10);
+    for (int i = 0; i < 100; ++i) {
+        loop.runAt(when, [&, i]() { fired.push_back(i); });
+    }
+    loop.runAt(when, [&]() { loop.quit(); });
+
+    loop.loop();
+
+    assert(fired.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        assert(fired[i] == i);
+    }
+}
+
+// 测试 3: 重复定时器与取消
+TEST(test_timer_every_and_cancel) {
+    EventLoop loop;
+    int count = 0;
+
+    TimerId every = loop.runEvery(0.005, [&]() { ++count; });
+    loop.runAfter(0.05, [&]() {
+        loop.cancel(every);
+        loop.runAfter(0.03, [&]() { loop.quit(); });
+    });
+
+    loop.loop();
+
+    int countAtCancel = count;
+    assert(countAtCancel >= 3);
+
+    // 取消之后不再触发
+    loop.runAfter(0.03, [&]() { loop.quit(); });
+    loop.loop();
+    assert(count == countAtCancel);
+}
+
+// 测试 4: 到期前取消
+TEST(test_timer_cancel_before_fire) {
+    EventLoop loop;
+    bool fired = false;
+
+    TimerId id = loop.runAfter(0.01, [&]() { fired = true; });
+    loop.cancel(id);
+    loop.runAfter(0.03, [&]() { loop.quit(); });
+
+    loop.loop();
+    assert(!fired);
+
+    // 重复取消以及取消已失效的句柄都是安全的
+    loop.cancel(id);
+    loop.cancel(TimerId());
+}
+
+// 测试 5: 在自身回调中取消重复定时器
+TEST(test_timer_cancel_self) {
+    EventLoop loop;
+    int count = 0;
+    TimerId id;
+
+    id = loop.runEvery(0.002, [&]() {
+        if (++count == 3) {
+            loop.cancel(id);
+            loop.runAfter(0.02, [&]() { loop.quit(); });
+        }
+    });
+
+    loop.loop();
+    assert(count == 3);
+}
+
+// 测试 6: 其他线程添加定时器
+TEST(test_timer_cross_thread) {
+    EventLoop loop;
+    bool inLoopThread = false;
+
+    std::thread t([&]() {
+        loop.runAfter(0.01, [&]() {
+            inLoopThread = loop.isInLoopThread();
+            loop.quit();
+        });
+    });
+
+    loop.loop();
+    t.join();
+    assert(inLoopThread);
+}
+
+// 测试 7: 过期句柄不能取消复用了同一槽位的新定时器
+TEST(test_timer_stale_id) {
+    EventLoop loop;
+    bool fired = false;
+
+    TimerId stale = loop.runAfter(0.01, []() {});
+    loop.cancel(stale);
+    TimerId fresh = loop.runAfter(0.01, [&]() { fired = true; });
+    assert(fresh.slot() == stale.slot());
+    assert(fresh.generation() != stale.generation());
+
+    loop.cancel(stale);
+    loop.runAfter(0.03, [&]() { loop.quit(); });
+
+    loop.loop();
+    assert(fired);
+}
+
+int main() {
+    RUN_TEST(test_timer_order);
+    RUN_TEST(test_timer_batch_expiry);
+    RUN_TEST(test_timer_every_and_cancel);
+    RUN_TEST(test_timer_cancel_before_fire);
+    RUN_TEST(test_timer_cancel_self);
+    RUN_TEST(test_timer_cross_thread);
+    RUN_TEST(test_timer_stale_id);
+
+    std::cout << "\n=== All TimerQueue Tests Passed ===" << std::endl;
+    return 0;
+}